@@ -180,7 +180,31 @@ data class WindowsSettingsPigeon (
   val displayName: String,
   val bundleId: String,
   val icon: String,
-  val iconContent: String
+  val iconContent: String,
+  /** Hot-standby server, same scheme and path as the mode; null = off */
+  val standbyHost: String? = null,
+  /** Port of the standby server; null = the mode's port */
+  val standbyPort: Long? = null,
+  /** Servers of the site as "host" or "host:port" (mode's port when omitted); the service picks one by health and latency */
+  val endpoints: List<String>? = null,
+  /** "latency" (default) or "affinity": each client sticks to the endpoint its connector id and device id hash to */
+  val endpointSelection: String? = null,
+  /** Topic patterns to receive ("a/+/c", "a/#", {connectorTag} and {connectorId} substituted); null or empty = every topic */
+  val subscriptions: List<String>? = null,
+  /** Routing rules, first match wins; no match = deliver */
+  val rules: List<RouteRulePigeon>? = null,
+  /** Delivery acks are sent once per this window (0 = each on its own) */
+  val ackWindowMs: Long? = null,
+  /** or sooner, once this many are pending */
+  val ackMaxCount: Long? = null,
+  /** Events to the app within this window go in one pipe write (0 = off) */
+  val ipcBatchWindowUs: Long? = null,
+  /** Most events in one batch */
+  val ipcBatchMaxCount: Long? = null,
+  /** Most bytes in one batch */
+  val ipcBatchMaxBytes: Long? = null,
+  /** Largest message the service and the app pass to each other */
+  val ipcMaxMessageBytes: Long? = null
 )
  {
   companion object {
@@ -189,7 +213,19 @@ data class WindowsSettingsPigeon (
       val bundleId = pigeonVar_list[1] as String
       val icon = pigeonVar_list[2] as String
       val iconContent = pigeonVar_list[3] as String
-      return WindowsSettingsPigeon(displayName, bundleId, icon, iconContent)
+      val standbyHost = pigeonVar_list[4] as String?
+      val standbyPort = pigeonVar_list[5] as Long?
+      val endpoints = pigeonVar_list[6] as List<String>?
+      val endpointSelection = pigeonVar_list[7] as String?
+      val subscriptions = pigeonVar_list[8] as List<String>?
+      val rules = pigeonVar_list[9] as List<RouteRulePigeon>?
+      val ackWindowMs = pigeonVar_list[10] as Long?
+      val ackMaxCount = pigeonVar_list[11] as Long?
+      val ipcBatchWindowUs = pigeonVar_list[12] as Long?
+      val ipcBatchMaxCount = pigeonVar_list[13] as Long?
+      val ipcBatchMaxBytes = pigeonVar_list[14] as Long?
+      val ipcMaxMessageBytes = pigeonVar_list[15] as Long?
+      return WindowsSettingsPigeon(displayName, bundleId, icon, iconContent, standbyHost, standbyPort, endpoints, endpointSelection, subscriptions, rules, ackWindowMs, ackMaxCount, ipcBatchWindowUs, ipcBatchMaxCount, ipcBatchMaxBytes, ipcMaxMessageBytes)
     }
   }
   fun toList(): List<Any?> {
@@ -198,6 +234,18 @@ data class WindowsSettingsPigeon (
       bundleId,
       icon,
       iconContent,
+      standbyHost,
+      standbyPort,
+      endpoints,
+      endpointSelection,
+      subscriptions,
+      rules,
+      ackWindowMs,
+      ackMaxCount,
+      ipcBatchWindowUs,
+      ipcBatchMaxCount,
+      ipcBatchMaxBytes,
+      ipcMaxMessageBytes,
     )
   }
   override fun equals(other: Any?): Boolean {
@@ -461,6 +509,51 @@ data class PluginSettingsPigeon (
 
   override fun hashCode(): Int = toList().hashCode()
 }
+
+/** Generated class from Pigeon that represents data sent in messages. */
+data class RouteRulePigeon (
+  /** deliver, toast, store, drop or collapse */
+  val action: String,
+  /** Envelope "Type" to match; null = any */
+  val type: String? = null,
+  /** Envelope "Tag" to match; null = any */
+  val tag: String? = null,
+  /** high, normal or low; null = any */
+  val priority: String? = null,
+  /** Exact topic, or a prefix ending in '#'; null = any */
+  val topic: String? = null
+)
+ {
+  companion object {
+    fun fromList(pigeonVar_list: List<Any?>): RouteRulePigeon {
+      val action = pigeonVar_list[0] as String
+      val type = pigeonVar_list[1] as String?
+      val tag = pigeonVar_list[2] as String?
+      val priority = pigeonVar_list[3] as String?
+      val topic = pigeonVar_list[4] as String?
+      return RouteRulePigeon(action, type, tag, priority, topic)
+    }
+  }
+  fun toList(): List<Any?> {
+    return listOf(
+      action,
+      type,
+      tag,
+      priority,
+      topic,
+    )
+  }
+  override fun equals(other: Any?): Boolean {
+    if (other !is RouteRulePigeon) {
+      return false
+    }
+    if (this === other) {
+      return true
+    }
+    return MessagesPigeonUtils.deepEquals(toList(), other.toList())  }
+
+  override fun hashCode(): Int = toList().hashCode()
+}
 private open class MessagesPigeonCodec : StandardMessageCodec() {
   override fun readValueOfType(type: Byte, buffer: ByteBuffer): Any? {
     return when (type) {
@@ -519,6 +612,11 @@ private open class MessagesPigeonCodec : StandardMessageCodec() {
           PluginSettingsPigeon.fromList(it)
         }
       }
+      140.toByte() -> {
+        return (readValue(buffer) as? List<Any?>)?.let {
+          RouteRulePigeon.fromList(it)
+        }
+      }
       else -> super.readValueOfType(type, buffer)
     }
   }
@@ -568,6 +666,10 @@ private open class MessagesPigeonCodec : StandardMessageCodec() {
         stream.write(139)
         writeValue(stream, value.toList())
       }
+      is RouteRulePigeon -> {
+        stream.write(140)
+        writeValue(stream, value.toList())
+      }
       else -> super.writeValue(stream, value)
     }
   }
@@ -227,6 +227,30 @@ struct WindowsSettingsPigeon: Hashable {
   var bundleId: String
   var icon: String
   var iconContent: String
+  /// Hot-standby server, same scheme and path as the mode; null = off
+  var standbyHost: String? = nil
+  /// Port of the standby server; null = the mode's port
+  var standbyPort: Int64? = nil
+  /// Servers of the site as "host" or "host:port" (mode's port when omitted); the service picks one by health and latency
+  var endpoints: [String]? = nil
+  /// "latency" (default) or "affinity": each client sticks to the endpoint its connector id and device id hash to
+  var endpointSelection: String? = nil
+  /// Topic patterns to receive ("a/+/c", "a/#", {connectorTag} and {connectorId} substituted); null or empty = every topic
+  var subscriptions: [String]? = nil
+  /// Routing rules, first match wins; no match = deliver
+  var rules: [RouteRulePigeon]? = nil
+  /// Delivery acks are sent once per this window (0 = each on its own)
+  var ackWindowMs: Int64? = nil
+  /// or sooner, once this many are pending
+  var ackMaxCount: Int64? = nil
+  /// Events to the app within this window go in one pipe write (0 = off)
+  var ipcBatchWindowUs: Int64? = nil
+  /// Most events in one batch
+  var ipcBatchMaxCount: Int64? = nil
+  /// Most bytes in one batch
+  var ipcBatchMaxBytes: Int64? = nil
+  /// Largest message the service and the app pass to each other
+  var ipcMaxMessageBytes: Int64? = nil
 
 
   // swift-format-ignore: AlwaysUseLowerCamelCase
@@ -235,12 +259,36 @@ struct WindowsSettingsPigeon: Hashable {
     let bundleId = pigeonVar_list[1] as! String
     let icon = pigeonVar_list[2] as! String
     let iconContent = pigeonVar_list[3] as! String
+    let standbyHost: String? = nilOrValue(pigeonVar_list[4])
+    let standbyPort: Int64? = nilOrValue(pigeonVar_list[5])
+    let endpoints: [String]? = nilOrValue(pigeonVar_list[6])
+    let endpointSelection: String? = nilOrValue(pigeonVar_list[7])
+    let subscriptions: [String]? = nilOrValue(pigeonVar_list[8])
+    let rules: [RouteRulePigeon]? = nilOrValue(pigeonVar_list[9])
+    let ackWindowMs: Int64? = nilOrValue(pigeonVar_list[10])
+    let ackMaxCount: Int64? = nilOrValue(pigeonVar_list[11])
+    let ipcBatchWindowUs: Int64? = nilOrValue(pigeonVar_list[12])
+    let ipcBatchMaxCount: Int64? = nilOrValue(pigeonVar_list[13])
+    let ipcBatchMaxBytes: Int64? = nilOrValue(pigeonVar_list[14])
+    let ipcMaxMessageBytes: Int64? = nilOrValue(pigeonVar_list[15])
 
     return WindowsSettingsPigeon(
       displayName: displayName,
       bundleId: bundleId,
       icon: icon,
-      iconContent: iconContent
+      iconContent: iconContent,
+      standbyHost: standbyHost,
+      standbyPort: standbyPort,
+      endpoints: endpoints,
+      endpointSelection: endpointSelection,
+      subscriptions: subscriptions,
+      rules: rules,
+      ackWindowMs: ackWindowMs,
+      ackMaxCount: ackMaxCount,
+      ipcBatchWindowUs: ipcBatchWindowUs,
+      ipcBatchMaxCount: ipcBatchMaxCount,
+      ipcBatchMaxBytes: ipcBatchMaxBytes,
+      ipcMaxMessageBytes: ipcMaxMessageBytes
     )
   }
   func toList() -> [Any?] {
@@ -249,6 +297,18 @@ struct WindowsSettingsPigeon: Hashable {
       bundleId,
       icon,
       iconContent,
+      standbyHost,
+      standbyPort,
+      endpoints,
+      endpointSelection,
+      subscriptions,
+      rules,
+      ackWindowMs,
+      ackMaxCount,
+      ipcBatchWindowUs,
+      ipcBatchMaxCount,
+      ipcBatchMaxBytes,
+      ipcMaxMessageBytes,
     ]
   }
   static func == (lhs: WindowsSettingsPigeon, rhs: WindowsSettingsPigeon) -> Bool {
@@ -505,6 +565,52 @@ struct PluginSettingsPigeon: Hashable {
   }
 }
 
+/// Generated class from Pigeon that represents data sent in messages.
+struct RouteRulePigeon: Hashable {
+  /// deliver, toast, store, drop or collapse
+  var action: String
+  /// Envelope "Type" to match; null = any
+  var type: String? = nil
+  /// Envelope "Tag" to match; null = any
+  var tag: String? = nil
+  /// high, normal or low; null = any
+  var priority: String? = nil
+  /// Exact topic, or a prefix ending in '#'; null = any
+  var topic: String? = nil
+
+
+  // swift-format-ignore: AlwaysUseLowerCamelCase
+  static func fromList(_ pigeonVar_list: [Any?]) -> RouteRulePigeon? {
+    let action = pigeonVar_list[0] as! String
+    let type: String? = nilOrValue(pigeonVar_list[1])
+    let tag: String? = nilOrValue(pigeonVar_list[2])
+    let priority: String? = nilOrValue(pigeonVar_list[3])
+    let topic: String? = nilOrValue(pigeonVar_list[4])
+
+    return RouteRulePigeon(
+      action: action,
+      type: type,
+      tag: tag,
+      priority: priority,
+      topic: topic
+    )
+  }
+  func toList() -> [Any?] {
+    return [
+      action,
+      type,
+      tag,
+      priority,
+      topic,
+    ]
+  }
+  static func == (lhs: RouteRulePigeon, rhs: RouteRulePigeon) -> Bool {
+    return deepEqualsMessages(lhs.toList(), rhs.toList())  }
+  func hash(into hasher: inout Hasher) {
+    deepHashMessages(value: toList(), hasher: &hasher)
+  }
+}
+
 private class MessagesPigeonCodecReader: FlutterStandardReader {
   override func readValue(ofType type: UInt8) -> Any? {
     switch type {
@@ -534,6 +640,8 @@ private class MessagesPigeonCodecReader: FlutterStandardReader {
       return RegisterMessagePigeon.fromList(self.readValue() as! [Any?])
     case 139:
       return PluginSettingsPigeon.fromList(self.readValue() as! [Any?])
+    case 140:
+      return RouteRulePigeon.fromList(self.readValue() as! [Any?])
     default:
       return super.readValue(ofType: type)
     }
@@ -575,6 +683,9 @@ private class MessagesPigeonCodecWriter: FlutterStandardWriter {
     } else if let value = value as? PluginSettingsPigeon {
       super.writeByte(139)
       super.writeValue(value.toList())
+    } else if let value = value as? RouteRulePigeon {
+      super.writeByte(140)
+      super.writeValue(value.toList())
     } else {
       super.writeValue(value)
     }
@@ -173,6 +173,18 @@ class WindowsSettingsPigeon {
     required this.bundleId,
     required this.icon,
     required this.iconContent,
+    this.standbyHost,
+    this.standbyPort,
+    this.endpoints,
+    this.endpointSelection,
+    this.subscriptions,
+    this.rules,
+    this.ackWindowMs,
+    this.ackMaxCount,
+    this.ipcBatchWindowUs,
+    this.ipcBatchMaxCount,
+    this.ipcBatchMaxBytes,
+    this.ipcMaxMessageBytes,
   });
 
   String displayName;
@@ -183,12 +195,60 @@ class WindowsSettingsPigeon {
 
   String iconContent;
 
+  /// Hot-standby server, same scheme and path as the mode; null = off
+  String? standbyHost;
+
+  /// Port of the standby server; null = the mode's port
+  int? standbyPort;
+
+  /// Servers of the site as "host" or "host:port" (mode's port when omitted); the service picks one by health and latency
+  List<String>? endpoints;
+
+  /// "latency" (default) or "affinity": each client sticks to the endpoint its connector id and device id hash to
+  String? endpointSelection;
+
+  /// Topic patterns to receive ("a/+/c", "a/#", {connectorTag} and {connectorId} substituted); null or empty = every topic
+  List<String>? subscriptions;
+
+  /// Routing rules, first match wins; no match = deliver
+  List<RouteRulePigeon>? rules;
+
+  /// Delivery acks are sent once per this window (0 = each on its own)
+  int? ackWindowMs;
+
+  /// or sooner, once this many are pending
+  int? ackMaxCount;
+
+  /// Events to the app within this window go in one pipe write (0 = off)
+  int? ipcBatchWindowUs;
+
+  /// Most events in one batch
+  int? ipcBatchMaxCount;
+
+  /// Most bytes in one batch
+  int? ipcBatchMaxBytes;
+
+  /// Largest message the service and the app pass to each other
+  int? ipcMaxMessageBytes;
+
   List<Object?> _toList() {
     return <Object?>[
       displayName,
       bundleId,
       icon,
       iconContent,
+      standbyHost,
+      standbyPort,
+      endpoints,
+      endpointSelection,
+      subscriptions,
+      rules,
+      ackWindowMs,
+      ackMaxCount,
+      ipcBatchWindowUs,
+      ipcBatchMaxCount,
+      ipcBatchMaxBytes,
+      ipcMaxMessageBytes,
     ];
   }
 
@@ -202,6 +262,18 @@ class WindowsSettingsPigeon {
       bundleId: result[1]! as String,
       icon: result[2]! as String,
       iconContent: result[3]! as String,
+      standbyHost: result[4] as String?,
+      standbyPort: result[5] as int?,
+      endpoints: (result[6] as List<Object?>?)?.cast<String>(),
+      endpointSelection: result[7] as String?,
+      subscriptions: (result[8] as List<Object?>?)?.cast<String>(),
+      rules: (result[9] as List<Object?>?)?.cast<RouteRulePigeon>(),
+      ackWindowMs: result[10] as int?,
+      ackMaxCount: result[11] as int?,
+      ipcBatchWindowUs: result[12] as int?,
+      ipcBatchMaxCount: result[13] as int?,
+      ipcBatchMaxBytes: result[14] as int?,
+      ipcMaxMessageBytes: result[15] as int?,
     );
   }
 
@@ -600,6 +672,72 @@ class PluginSettingsPigeon {
 ;
 }
 
+class RouteRulePigeon {
+  RouteRulePigeon({
+    required this.action,
+    this.type,
+    this.tag,
+    this.priority,
+    this.topic,
+  });
+
+  /// deliver, toast, store, drop or collapse
+  String action;
+
+  /// Envelope "Type" to match; null = any
+  String? type;
+
+  /// Envelope "Tag" to match; null = any
+  String? tag;
+
+  /// high, normal or low; null = any
+  String? priority;
+
+  /// Topic pattern as in subscriptions ("a/b", "a/+/c", "a/#"); null = any
+  String? topic;
+
+  List<Object?> _toList() {
+    return <Object?>[
+      action,
+      type,
+      tag,
+      priority,
+      topic,
+    ];
+  }
+
+  Object encode() {
+    return _toList();  }
+
+  static RouteRulePigeon decode(Object result) {
+    result as List<Object?>;
+    return RouteRulePigeon(
+      action: result[0]! as String,
+      type: result[1] as String?,
+      tag: result[2] as String?,
+      priority: result[3] as String?,
+      topic: result[4] as String?,
+    );
+  }
+
+  @override
+  // ignore: avoid_equals_and_hash_code_on_mutable_classes
+  bool operator ==(Object other) {
+    if (other is! RouteRulePigeon || other.runtimeType != runtimeType) {
+      return false;
+    }
+    if (identical(this, other)) {
+      return true;
+    }
+    return _deepEquals(encode(), other.encode());
+  }
+
+  @override
+  // ignore: avoid_equals_and_hash_code_on_mutable_classes
+  int get hashCode => Object.hashAll(_toList())
+;
+}
+
 
 class _PigeonCodec extends StandardMessageCodec {
   const _PigeonCodec();
@@ -641,6 +779,9 @@ class _PigeonCodec extends StandardMessageCodec {
     }    else if (value is PluginSettingsPigeon) {
       buffer.putUint8(139);
       writeValue(buffer, value.encode());
+    }    else if (value is RouteRulePigeon) {
+      buffer.putUint8(140);
+      writeValue(buffer, value.encode());
     } else {
       super.writeValue(buffer, value);
     }
@@ -672,6 +813,8 @@ class _PigeonCodec extends StandardMessageCodec {
         return RegisterMessagePigeon.decode(readValue(buffer)!);
       case 139: 
         return PluginSettingsPigeon.decode(readValue(buffer)!);
+      case 140: 
+        return RouteRulePigeon.decode(readValue(buffer)!);
       default:
         return super.readValueOfType(type, buffer);
     }
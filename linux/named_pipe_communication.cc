@@ -0,0 +1,401 @@
+#include "named_pipe_communication.h"
+
+#include <glib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+// NamedPipeServer Implementation
+NamedPipeServer::NamedPipeServer(const std::string& name)
+    : listenFd(-1), epollFd(-1), wakeFd(-1), pipeName(name), running(false) {}
+
+NamedPipeServer::~NamedPipeServer() {
+  Stop();
+}
+
+bool NamedPipeServer::Start(std::function<void(const PipeMessage&)> handler) {
+  if (running.load()) {
+    return true;
+  }
+
+  // Bind before returning so a client started right after us finds the name
+  if (!CreatePipe()) {
+    ClosePipe();
+    return false;
+  }
+
+  messageHandler = handler;
+  running.store(true);
+
+  try {
+    serverThread = std::thread(&NamedPipeServer::ServerLoop, this);
+    return true;
+  } catch (const std::exception& ex) {
+    g_warning("[NamedPipe] Failed to start server thread: %s", ex.what());
+    running.store(false);
+    ClosePipe();
+    return false;
+  }
+}
+
+void NamedPipeServer::Stop() {
+  if (!running.load()) {
+    return;
+  }
+
+  running.store(false);
+
+  uint64_t one = 1;
+  if (write(wakeFd, &one, sizeof(one)) < 0) {
+    g_warning("[NamedPipe] wake failed: %s", strerror(errno));
+  }
+  if (serverThread.joinable()) {
+    serverThread.join();
+  }
+  ClosePipe();
+}
+
+void NamedPipeServer::ServerLoop() {
+  epoll_event events[16];
+  while (running.load()) {
+    int count = epoll_wait(epollFd, events, 16, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      g_warning("[NamedPipe] epoll_wait failed: %s", strerror(errno));
+      break;
+    }
+    for (int i = 0; i < count && running.load(); i++) {
+      int fd = events[i].data.fd;
+      if (fd == wakeFd) {
+        return;
+      }
+      if (fd == listenFd) {
+        AcceptClients();
+        continue;
+      }
+      // Drain what is readable first: a client may write and close at once
+      if (!ReadClient(fd)) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        clients.erase(fd);
+        partial.erase(fd);
+      }
+    }
+  }
+}
+
+void NamedPipeServer::AcceptClients() {
+  while (true) {
+    int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        g_warning("[NamedPipe] accept failed: %s", strerror(errno));
+      }
+      return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      g_warning("[NamedPipe] epoll_ctl failed: %s", strerror(errno));
+      close(fd);
+      continue;
+    }
+    clients.insert(fd);
+    accepted++;
+    g_debug("[NamedPipe] Client connected");
+  }
+}
+
+// Handles every record available now. False once the client is gone.
+// Fragments are kept per client until the last one arrives, since the
+// sender may stall between them.
+bool NamedPipeServer::ReadClient(int fd) {
+  // Reused across records: once grown, data is assigned without allocating
+  thread_local PipeMessage record;
+  while (true) {
+    bool fragment = false;
+    if (!ReadPipeRecord(fd, record, fragment)) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+      if (errno == 0) {
+        g_debug("[NamedPipe] Client disconnected");
+      } else {
+        g_warning("[NamedPipe] ReadPipeRecord failed: %s", strerror(errno));
+      }
+      return false;
+    }
+
+    auto it = partial.find(fd);
+    if (!fragment && it == partial.end()) {
+      Deliver(record);
+      continue;
+    }
+    if (it == partial.end()) {
+      it = partial.emplace(fd, PipeMessage()).first;
+      it->second.command = record.command;
+    }
+    PipeMessage& message = it->second;
+    if (record.command != message.command ||
+        message.data.size() + record.dataSize > PIPE_MAX_MESSAGE_SIZE) {
+      g_warning("[NamedPipe] Bad fragment, dropping client");
+      return false;
+    }
+    message.data.append(record.data);
+    if (fragment) continue;
+    message.dataSize = static_cast<uint32_t>(message.data.size());
+    Deliver(message);
+    partial.erase(it);
+  }
+}
+
+void NamedPipeServer::Deliver(const PipeMessage& message) {
+  if (!messageHandler) return;
+  try {
+    messageHandler(message);
+  } catch (const std::exception& ex) {
+    g_warning("[NamedPipe] Handler failed: %s", ex.what());
+  } catch (...) {
+    g_warning("[NamedPipe] Handler failed");
+  }
+}
+
+bool NamedPipeServer::CreatePipe() {
+  listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (listenFd < 0 || epollFd < 0 || wakeFd < 0) {
+    g_warning("[NamedPipe] socket/epoll failed: %s", strerror(errno));
+    return false;
+  }
+
+  sockaddr_un address;
+  socklen_t length = PipeAddress(pipeName, address);
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), length) < 0 ||
+      listen(listenFd, SOMAXCONN) < 0) {
+    // EADDRINUSE: another instance of the app already owns the name
+    g_warning("[NamedPipe] bind/listen %s failed: %s", pipeName.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  for (int fd : {listenFd, wakeFd}) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      g_warning("[NamedPipe] epoll_ctl failed: %s", strerror(errno));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Server thread stopped (or never started)
+void NamedPipeServer::ClosePipe() {
+  for (int fd : clients) {
+    close(fd);
+  }
+  clients.clear();
+  partial.clear();
+  for (int* fd : {&listenFd, &epollFd, &wakeFd}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+// NamedPipeClient Implementation
+NamedPipeClient::NamedPipeClient(const std::string& name)
+    : fd(-1), pipeName(name) {}
+
+NamedPipeClient::~NamedPipeClient() {
+  Disconnect();
+}
+
+bool NamedPipeClient::Connect(int maxRetries) {
+  std::lock_guard<std::mutex> lock(pipeMutex);
+
+  if (fd >= 0) {
+    return true;  // Already connected
+  }
+
+  sockaddr_un address;
+  socklen_t length = PipeAddress(pipeName, address);
+
+  for (int retryCount = 0; retryCount < maxRetries; retryCount++) {
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      g_warning("[NamedPipe] socket failed: %s", strerror(errno));
+      return false;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), length) == 0) {
+      g_debug("[NamedPipe] Client connected to server");
+      return true;
+    }
+
+    // A blocking connect waits for room in the listen backlog itself, so
+    // there is no busy case to sleep on
+    int error = errno;
+    ClosePipe();
+    if (error == EINTR) {
+      continue;
+    } else if (error == ECONNREFUSED || error == ENOENT) {
+      g_debug("[NamedPipe] Pipe not found, server not ready");
+      break;
+    } else {
+      g_warning("[NamedPipe] connect failed: %s", strerror(error));
+      break;
+    }
+  }
+
+  return false;
+}
+
+void NamedPipeClient::Disconnect() {
+  std::lock_guard<std::mutex> lock(pipeMutex);
+  ClosePipe();
+}
+
+bool NamedPipeClient::SendMessage(const PipeMessage& message) {
+  std::lock_guard<std::mutex> lock(pipeMutex);
+
+  if (fd < 0) {
+    g_debug("[NamedPipe] Not connected to server");
+    return false;
+  }
+
+  return WritePipeMessage(fd, message);
+}
+
+bool NamedPipeClient::IsConnected() const {
+  std::lock_guard<std::mutex> lock(pipeMutex);
+  return fd >= 0;
+}
+
+void NamedPipeClient::ClosePipe() {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+// Utility functions
+std::string GetPipeName(const std::string& appTitle) {
+  return appTitle + "_notification_pipe";
+}
+
+socklen_t PipeAddress(const std::string& pipeName, sockaddr_un& address) {
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  // sun_path[0] stays NUL (abstract namespace); long titles are cut to fit
+  size_t size = pipeName.size();
+  if (size > sizeof(address.sun_path) - 1) size = sizeof(address.sun_path) - 1;
+  memcpy(address.sun_path + 1, pipeName.data(), size);
+  return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + size);
+}
+
+PipeMessage CreatePipeMessage(uint32_t command, const std::string& data) {
+  return PipeMessage(command, data);
+}
+
+// Header and data of a record go out in a single sendmsg; a message larger
+// than PIPE_RECORD_SIZE takes several. The caller keeps other writers off
+// the socket until the last one is out.
+bool WritePipeMessage(int fd, const PipeMessage& message) {
+  if (message.dataSize > PIPE_MAX_MESSAGE_SIZE ||
+      message.dataSize > message.data.size() ||
+      (message.command & PIPE_FRAGMENT_FLAG) != 0) {
+    errno = EMSGSIZE;
+    return false;
+  }
+
+  uint32_t offset = 0;
+  do {
+    uint32_t size = message.dataSize - offset;
+    if (size > PIPE_RECORD_SIZE) size = PIPE_RECORD_SIZE;
+    uint32_t command = message.command;
+    if (offset + size < message.dataSize) command |= PIPE_FRAGMENT_FLAG;
+    iovec parts[3] = {
+        {&command, sizeof(uint32_t)},
+        {&size, sizeof(uint32_t)},
+        {const_cast<char*>(message.data.data()) + offset, size},
+    };
+    msghdr msg = {};
+    msg.msg_iov = parts;
+    msg.msg_iovlen = size > 0 ? 3 : 2;
+
+    ssize_t sent;
+    do {
+      sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != static_cast<ssize_t>(2 * sizeof(uint32_t) + size)) {
+      return false;
+    }
+    offset += size;
+  } while (offset < message.dataSize);
+  return true;
+}
+
+bool ReadPipeMessage(int fd, PipeMessage& message) {
+  thread_local PipeMessage record;
+  bool fragment = false;
+  if (!ReadPipeRecord(fd, record, fragment)) return false;
+  message.command = record.command;
+  message.data.assign(record.data);
+  while (fragment) {
+    if (!ReadPipeRecord(fd, record, fragment)) return false;
+    if (record.command != message.command ||
+        message.data.size() + record.dataSize > PIPE_MAX_MESSAGE_SIZE) {
+      errno = EPROTO;
+      return false;
+    }
+    message.data.append(record.data);
+  }
+  message.dataSize = static_cast<uint32_t>(message.data.size());
+  return true;
+}
+
+// False with errno == 0 when the peer closed the connection.
+// One recv per record: it lands in a per-thread buffer sized for the
+// largest valid record, MSG_TRUNC reports the real length of anything
+// larger. The command is returned without PIPE_FRAGMENT_FLAG.
+bool ReadPipeRecord(int fd, PipeMessage& message, bool& fragment) {
+  const size_t header = 2 * sizeof(uint32_t);
+  thread_local std::string scratch(header + PIPE_RECORD_SIZE, '\0');
+
+  ssize_t size;
+  do {
+    size = recv(fd, &scratch[0], scratch.size(), MSG_TRUNC);
+  } while (size < 0 && errno == EINTR);
+  if (size <= 0) {
+    if (size == 0) errno = 0;
+    return false;
+  }
+
+  // A bad record is consumed whole, so the next read is still in sync
+  if (static_cast<size_t>(size) < header ||
+      static_cast<size_t>(size) > scratch.size()) {
+    errno = EMSGSIZE;
+    return false;
+  }
+  uint32_t dataSize;
+  memcpy(&dataSize, scratch.data() + sizeof(uint32_t), sizeof(uint32_t));
+  if (dataSize != static_cast<size_t>(size) - header) {
+    errno = EPROTO;
+    return false;
+  }
+
+  memcpy(&message.command, scratch.data(), sizeof(uint32_t));
+  fragment = (message.command & PIPE_FRAGMENT_FLAG) != 0;
+  message.command &= ~PIPE_FRAGMENT_FLAG;
+  message.dataSize = dataSize;
+  message.data.assign(scratch.data() + header, dataSize);
+  return true;
+}
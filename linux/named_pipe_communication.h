@@ -0,0 +1,126 @@
+#ifndef FLUTTER_PLUGIN_LOCAL_PUSH_CONNECTIVITY_NAMED_PIPE_COMMUNICATION_H_
+#define FLUTTER_PLUGIN_LOCAL_PUSH_CONNECTIVITY_NAMED_PIPE_COMMUNICATION_H_
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+// Linux transport for the app <-> service channel. Same API and framing as
+// windows/named_pipe_communication.h, over an AF_UNIX SOCK_SEQPACKET socket
+// in the abstract namespace: the kernel keeps record boundaries for us, so
+// a read never returns half a record. A message up to PIPE_RECORD_SIZE is
+// one record; a larger one is split (see PIPE_FRAGMENT_FLAG).
+// Command and protocol IDs are shared with the Windows side.
+
+// Legacy commands (backward compatibility)
+#define PIPE_CMD_UPDATE_SETTINGS   100
+#define PIPE_CMD_UPDATE_REGISTER   200
+#define PIPE_CMD_STOP_SERVICE      300
+#define PIPE_CMD_RECONNECT         400
+#define PIPE_CMD_PONG              777
+#define PIPE_CMD_LOGOUT            99
+
+// Protocol commands
+#define PROTOCOL_HELLO             1000
+#define PROTOCOL_HELLO_ACK         1001
+#define PROTOCOL_SET_URL           1002
+#define PROTOCOL_ACK               1003
+#define PROTOCOL_SOCKET_EVENT      1004
+#define PROTOCOL_PING              1005
+#define PROTOCOL_PONG              1006
+
+// Largest message accepted, after reassembly; keeps a misbehaving peer
+// from growing a buffer without bound.
+#define PIPE_MAX_MESSAGE_SIZE      (4 * 1024 * 1024)
+
+// A SEQPACKET record must fit in the sender's socket buffer in one piece,
+// and that buffer is capped by net.core.wmem_max (about 208 KB by default,
+// whatever SO_SNDBUF asks for). Data beyond this many bytes goes in further
+// records; every record but the last of a message has PIPE_FRAGMENT_FLAG
+// set in its command, and the reader joins them.
+#define PIPE_RECORD_SIZE           (64 * 1024)
+#define PIPE_FRAGMENT_FLAG         0x80000000u
+
+// Wire layout, identical to Windows: uint32 command, uint32 dataSize, data.
+struct PipeMessage {
+  uint32_t command;
+  uint32_t dataSize;
+  std::string data;
+
+  PipeMessage() : command(0), dataSize(0) {}
+  PipeMessage(uint32_t cmd, const std::string& msg)
+      : command(cmd), dataSize(static_cast<uint32_t>(msg.length())), data(msg) {}
+};
+
+// Serves any number of clients at once from one epoll loop; the handler
+// runs on that thread, so calls are never concurrent.
+class NamedPipeServer {
+ public:
+  explicit NamedPipeServer(const std::string& name);
+  ~NamedPipeServer();
+
+  bool Start(std::function<void(const PipeMessage&)> handler);
+  void Stop();
+  bool IsRunning() const { return running.load(); }
+  uint64_t Accepted() const { return accepted.load(); }
+
+ private:
+  int listenFd;
+  int epollFd;
+  int wakeFd;  // eventfd written by Stop()
+  std::unordered_set<int> clients;
+  // Messages whose first fragments have arrived, per client
+  std::unordered_map<int, PipeMessage> partial;
+  std::string pipeName;
+  std::atomic<bool> running;
+  std::atomic<uint64_t> accepted{0};
+  std::thread serverThread;
+  std::function<void(const PipeMessage&)> messageHandler;
+
+  void ServerLoop();
+  bool CreatePipe();
+  void AcceptClients();
+  bool ReadClient(int fd);
+  void Deliver(const PipeMessage& message);
+  void ClosePipe();
+};
+
+class NamedPipeClient {
+ public:
+  explicit NamedPipeClient(const std::string& name);
+  ~NamedPipeClient();
+
+  bool Connect(int maxRetries = 3);
+  void Disconnect();
+  bool SendMessage(const PipeMessage& message);
+  bool IsConnected() const;
+
+ private:
+  int fd;
+  std::string pipeName;
+  mutable std::mutex pipeMutex;
+
+  void ClosePipe();
+};
+
+// "<title>_notification_pipe". Used as an abstract socket name (leading NUL
+// added by PipeAddress), so nothing is created on disk and the name vanishes
+// with the last socket; no stale file to unlink after a crash.
+std::string GetPipeName(const std::string& appTitle);
+socklen_t PipeAddress(const std::string& pipeName, sockaddr_un& address);
+PipeMessage CreatePipeMessage(uint32_t command, const std::string& data);
+bool WritePipeMessage(int fd, const PipeMessage& message);
+// One record; fragment: more records of the same message follow
+bool ReadPipeRecord(int fd, PipeMessage& record, bool& fragment);
+// A whole message, reassembled; for blocking sockets
+bool ReadPipeMessage(int fd, PipeMessage& message);
+
+#endif  // FLUTTER_PLUGIN_LOCAL_PUSH_CONNECTIVITY_NAMED_PIPE_COMMUNICATION_H_
@@ -61,11 +61,59 @@ class WindowsSettingsPigeon {
   String icon;
   String iconContent;
 
+  /// Hot-standby server, same scheme and path as the mode; null = off
+  String? standbyHost;
+
+  /// Port of the standby server; null = the mode's port
+  int? standbyPort;
+
+  /// Servers of the site as "host" or "host:port" (mode's port when omitted); the service picks one by health and latency
+  List<String>? endpoints;
+
+  /// "latency" (default) or "affinity": each client sticks to the endpoint its connector id and device id hash to
+  String? endpointSelection;
+
+  /// Topic patterns to receive ("a/+/c", "a/#", {connectorTag} and {connectorId} substituted); null or empty = every topic
+  List<String>? subscriptions;
+
+  /// Routing rules, first match wins; no match = deliver
+  List<RouteRulePigeon>? rules;
+
+  /// Delivery acks are sent once per this window (0 = each on its own)
+  int? ackWindowMs;
+
+  /// or sooner, once this many are pending
+  int? ackMaxCount;
+
+  /// Events to the app within this window go in one pipe write (0 = off)
+  int? ipcBatchWindowUs;
+
+  /// Most events in one batch
+  int? ipcBatchMaxCount;
+
+  /// Most bytes in one batch
+  int? ipcBatchMaxBytes;
+
+  /// Largest message the service and the app pass to each other
+  int? ipcMaxMessageBytes;
+
   WindowsSettingsPigeon({
     required this.displayName,
     required this.bundleId,
     required this.icon,
     required this.iconContent,
+    this.standbyHost,
+    this.standbyPort,
+    this.endpoints,
+    this.endpointSelection,
+    this.subscriptions,
+    this.rules,
+    this.ackWindowMs,
+    this.ackMaxCount,
+    this.ipcBatchWindowUs,
+    this.ipcBatchMaxCount,
+    this.ipcBatchMaxBytes,
+    this.ipcMaxMessageBytes,
   });
 }
 
@@ -175,6 +223,31 @@ class PluginSettingsPigeon {
   });
 }
 
+class RouteRulePigeon {
+  /// deliver, toast, store, drop or collapse
+  String action;
+
+  /// Envelope "Type" to match; null = any
+  String? type;
+
+  /// Envelope "Tag" to match; null = any
+  String? tag;
+
+  /// high, normal or low; null = any
+  String? priority;
+
+  /// Topic pattern as in subscriptions ("a/b", "a/+/c", "a/#"); null = any
+  String? topic;
+
+  RouteRulePigeon({
+    required this.action,
+    this.type,
+    this.tag,
+    this.priority,
+    this.topic,
+  });
+}
+
 @FlutterApi()
 abstract class LocalPushConnectivityPigeonFlutterApi {
   @async
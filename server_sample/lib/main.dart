@@ -59,6 +59,15 @@ class _MyHomePageState extends State<MyHomePage> {
       <String, Map<String, Socket?>>{};
   Map<String, Map<String, SecureSocket?>> clientsTCPSecure =
       <String, Map<String, SecureSocket?>>{};
+
+  /// Messages sent per device (`connectorID/deviceID`), stamped with `Seq`,
+  /// so a reconnecting client can resume from its last stored sequence.
+  /// Entries leave the history once the client acks them.
+  final Map<String, List<_Sent>> _history = <String, List<_Sent>>{};
+  final Map<String, int> _lastSeq = <String, int>{};
+  final Map<WebSocket, String> _socketKeys = <WebSocket, String>{};
+  static const int _historyLimit = 1000;
+
   @override
   void initState() {
     _initial();
@@ -102,7 +111,7 @@ class _MyHomePageState extends State<MyHomePage> {
                                   'bla ${DateTime.now().millisecondsSinceEpoch}',
                             },
                           };
-                          soc.value?.add(jsonEncode(mess));
+                          _sendWithSeq(client.key, soc.key, soc.value!, mess);
                         },
                         child: const Text('Send message'),
                       ),
@@ -205,8 +214,12 @@ class _MyHomePageState extends State<MyHomePage> {
                       'pong': '${DateTime.now().millisecondsSinceEpoch}',
                     }),
                   );
+                } else if (json['messageType'] == 'ack') {
+                  _onAck(json, websocket);
                 } else {
                   final mess = MessageRegister.fromJson(json);
+                  if (_isStandby(mess)) return;
+                  _resume(mess, websocket);
                   if (mounted) {
                     final socs = clients[mess.sender.connectorID];
                     setState(() {
@@ -231,10 +244,14 @@ class _MyHomePageState extends State<MyHomePage> {
                       'pong': '${DateTime.now().millisecondsSinceEpoch}',
                     }),
                   );
+                } else if (json['messageType'] == 'ack') {
+                  _onAck(json, websocket);
                 } else {
                   final mess = MessageRegister.fromJson(
                     jsonDecode(utf8.decode(message)),
                   );
+                  if (_isStandby(mess)) return;
+                  _resume(mess, websocket);
                   if (mounted) {
                     final socs = clients[mess.sender.connectorID];
                     setState(() {
@@ -255,6 +272,7 @@ class _MyHomePageState extends State<MyHomePage> {
           },
           onDone: () {
             log('Client disconnected: ${websocket.hashCode}');
+            _socketKeys.remove(websocket);
             String? clientId;
             String? deviceId;
             for (final item in clients.entries) {
@@ -290,6 +308,87 @@ class _MyHomePageState extends State<MyHomePage> {
     }
   }
 
+  String _deviceKey(String connectorID, String deviceID) =>
+      '$connectorID/$deviceID';
+
+  void _sendWithSeq(
+    String connectorID,
+    String deviceID,
+    WebSocket socket,
+    Map<String, dynamic> mess,
+  ) {
+    final key = _deviceKey(connectorID, deviceID);
+    final seq = (_lastSeq[key] ?? 0) + 1;
+    _lastSeq[key] = seq;
+    final stamped = <String, dynamic>{...mess, 'Seq': seq};
+    final history = _history.putIfAbsent(key, () => <_Sent>[]);
+    history.add(_Sent(seq, stamped));
+    if (history.length > _historyLimit) history.removeAt(0);
+    socket.add(jsonEncode(stamped));
+  }
+
+  /// A hot-standby registration is only kept alive (pings): no pushes are
+  /// routed to it until the client registers on it again without the flag.
+  bool _isStandby(MessageRegister mess) {
+    if (mess.data?.standby != true) return false;
+    log(
+      'Standby registered: '
+      '${_deviceKey(mess.sender.connectorID, mess.sender.deviceID)}',
+    );
+    return true;
+  }
+
+  /// Replays only what the client missed: messages after `data.lastSeq`.
+  void _resume(MessageRegister mess, WebSocket socket) {
+    final key = _deviceKey(mess.sender.connectorID, mess.sender.deviceID);
+    _socketKeys[socket] = key;
+    final lastSeq = mess.data?.lastSeq;
+    if (lastSeq == null) return;
+    // Server restarted: continue numbering above what the client has
+    if (lastSeq > (_lastSeq[key] ?? 0)) _lastSeq[key] = lastSeq;
+    var count = 0;
+    for (final item in _history[key] ?? const <_Sent>[]) {
+      if (item.seq > lastSeq) {
+        socket.add(jsonEncode(item.message));
+        count++;
+      }
+    }
+    log('Resume $key after $lastSeq: $count messages');
+  }
+
+  /// `{"messageType":"ack","ranges":[[from,to],...],"ids":[...]}`: drops the
+  /// acked messages from the history and logs send-to-ack latency.
+  void _onAck(Map<String, dynamic> json, WebSocket socket) {
+    final key = _socketKeys[socket];
+    final history = key == null ? null : _history[key];
+    if (history == null) return;
+    final ranges = <List<int>>[
+      for (final r in (json['ranges'] as List? ?? const []))
+        [(r as List)[0] as int, r[1] as int],
+    ];
+    final ids = {for (final id in (json['ids'] as List? ?? const [])) '$id'};
+    final now = DateTime.now().millisecondsSinceEpoch;
+    var count = 0, totalMs = 0, maxMs = 0;
+    history.removeWhere((item) {
+      final acked =
+          ranges.any((r) => item.seq >= r[0] && item.seq <= r[1]) ||
+          ids.contains(item.id);
+      if (acked) {
+        final ms = now - item.sentAt;
+        count++;
+        totalMs += ms;
+        if (ms > maxMs) maxMs = ms;
+      }
+      return acked;
+    });
+    if (count > 0) {
+      log(
+        'Ack $key: $count messages, avg ${totalMs ~/ count} ms, '
+        'max $maxMs ms, ${history.length} unacked',
+      );
+    }
+  }
+
   void _initialTCP() async {
     final server = await ServerSocket.bind(InternetAddress.anyIPv4, 4041);
     log('TCP Server is running on ${server.address.address}:${server.port}');
@@ -510,6 +609,19 @@ class MessageRegister {
       );
 }
 
+class _Sent {
+  final int seq;
+  final Map<String, dynamic> message;
+  final int sentAt = DateTime.now().millisecondsSinceEpoch;
+
+  _Sent(this.seq, this.message);
+
+  String? get id {
+    final data = message['Data'] ?? message['data'];
+    return data is Map ? data['ID']?.toString() : null;
+  }
+}
+
 class Sender {
   final String connectorID, connectorTag, deviceID;
 
@@ -532,7 +644,17 @@ class Sender {
 
 class Data {
   final String? id;
-  const Data({this.id});
-  factory Data.fromJson(Map<String, dynamic> json) => Data(id: json['id']);
-  Map<String, dynamic> toJson() => {'id': id};
+  final int? lastSeq;
+  final bool? standby;
+  const Data({this.id, this.lastSeq, this.standby});
+  factory Data.fromJson(Map<String, dynamic> json) => Data(
+    id: json['id'],
+    lastSeq: json['lastSeq'],
+    standby: json['standby'],
+  );
+  Map<String, dynamic> toJson() => {
+    'id': id,
+    'lastSeq': lastSeq,
+    'standby': standby,
+  };
 }
@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "utils.h"
+
+#define ACK_DEFAULT_WINDOW_MS 100
+#define ACK_DEFAULT_MAX_COUNT 64
+// Bound on pending acks while the connection is down; the resume cursor
+// covers anything beyond that
+#define ACK_MAX_PENDING       4096
+
+// Coalesces delivery acks into one frame per window (or per maxCount acks).
+// Sequence numbers are sent as closed ranges; messages without a Seq are
+// acked by ID.
+class AckBatcher {
+public:
+    using Sender = std::function<bool(const std::wstring&)>;
+
+    explicit AckBatcher(Sender s) : sender(std::move(s)) {
+        worker = std::thread([this]() { loop(); });
+    }
+
+    ~AckBatcher() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    // windowMs <= 0 sends every ack on its own
+    void Configure(int64_t windowMs, int64_t maxCount) {
+        std::lock_guard<std::mutex> lk(mutex);
+        this->windowMs = windowMs;
+        this->maxCount = maxCount > 0 ? maxCount : ACK_DEFAULT_MAX_COUNT;
+    }
+
+    void Add(const std::optional<int64_t>& seq, const std::optional<std::string>& id) {
+        if (!seq && !id) return;
+        bool flushNow;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (seq) seqs.push_back(*seq);
+            else ids.push_back(*id);
+            if (seqs.size() + ids.size() > ACK_MAX_PENDING) {
+                if (!seqs.empty()) seqs.erase(seqs.begin());
+                else ids.erase(ids.begin());
+            }
+            flushNow = windowMs <= 0 || (int64_t)(seqs.size() + ids.size()) >= maxCount;
+        }
+        if (flushNow) cv.notify_one();
+    }
+
+    uint64_t FramesSent() const { return framesSent.load(); }
+    uint64_t AcksSent() const { return acksSent.load(); }
+
+private:
+    Sender sender;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+    bool stopping = false;
+
+    int64_t windowMs = ACK_DEFAULT_WINDOW_MS;
+    int64_t maxCount = ACK_DEFAULT_MAX_COUNT;
+    std::vector<int64_t> seqs;
+    std::vector<std::string> ids;
+
+    std::atomic<uint64_t> framesSent{ 0 };
+    std::atomic<uint64_t> acksSent{ 0 };
+
+    void loop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (!stopping) {
+            auto wait = std::chrono::milliseconds((std::max)(windowMs, (int64_t)1));
+            cv.wait_for(lk, wait, [this]() {
+                return stopping || ((!seqs.empty() || !ids.empty()) &&
+                    (windowMs <= 0 || (int64_t)(seqs.size() + ids.size()) >= maxCount));
+            });
+            if (seqs.empty() && ids.empty()) continue;
+
+            AckModel ack = build();
+            size_t count = seqs.size() + ids.size();
+            std::vector<int64_t> keptSeqs;
+            std::vector<std::string> keptIds;
+            keptSeqs.swap(seqs);
+            keptIds.swap(ids);
+
+            lk.unlock();
+            json j = ack;
+            bool sent = false;
+            try {
+                sent = sender(utf8_to_wide(j.dump()));
+            }
+            catch (...) {}
+            lk.lock();
+
+            if (sent) {
+                framesSent++;
+                acksSent += count;
+            }
+            else {
+                // Not connected: keep them for the next window
+                seqs.insert(seqs.begin(), keptSeqs.begin(), keptSeqs.end());
+                ids.insert(ids.begin(), keptIds.begin(), keptIds.end());
+                if (!stopping) cv.wait_for(lk, std::chrono::seconds(1), [this]() { return stopping; });
+            }
+        }
+    }
+
+    AckModel build() {
+        AckModel ack{ "ack" };
+        std::vector<int64_t> sorted = seqs;
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        for (size_t i = 0; i < sorted.size();) {
+            size_t k = i;
+            while (k + 1 < sorted.size() && sorted[k + 1] == sorted[k] + 1) k++;
+            ack.ranges.push_back({ sorted[i], sorted[k] });
+            i = k + 1;
+        }
+        ack.ids = ids;
+        return ack;
+    }
+};
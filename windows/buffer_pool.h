@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Size classes 256 B, 1 KiB, 4 KiB ... 4 MiB (x4 each); larger requests are
+// allocated exactly and freed on release
+#define BUFFER_POOL_CLASSES        8
+#define BUFFER_POOL_MIN_SIZE       256
+// Free blocks kept per class: this many bytes' worth, at least one block
+#define BUFFER_POOL_CLASS_BYTES    (1024 * 1024)
+
+struct BufferPoolStats {
+    uint64_t hits = 0;     // served from a free list
+    uint64_t misses = 0;   // had to allocate
+    uint64_t dropped = 0;  // released with the free list full, freed
+    uint64_t retainedBytes = 0;
+};
+
+// Block header; the bytes follow it
+struct PoolBlock {
+    std::atomic<uint32_t> refs;
+    int32_t cls;       // -1: oversize, not pooled
+    uint32_t capacity;
+    uint32_t size;
+
+    char* bytes() { return reinterpret_cast<char*>(this + 1); }
+};
+
+// Process-wide free lists, one per size class. Each list is reserved to its
+// cap up front, so returning a block never allocates.
+class BufferPool {
+public:
+    // Never destroyed: a buffer may be released by a static destructor
+    // that runs after ours would have
+    static BufferPool& Instance() {
+        static BufferPool* pool = new BufferPool();
+        return *pool;
+    }
+
+    PoolBlock* Acquire(size_t size) {
+        int cls = classOf(size);
+        if (cls >= 0) {
+            Class& c = classes[cls];
+            std::lock_guard<std::mutex> lk(c.mutex);
+            if (!c.free.empty()) {
+                PoolBlock* b = c.free.back();
+                c.free.pop_back();
+                hits++;
+                retained -= classSize(cls);
+                b->refs.store(1, std::memory_order_relaxed);
+                b->size = 0;
+                return b;
+            }
+        }
+        misses++;
+        size_t capacity = cls >= 0 ? classSize(cls) : size;
+        PoolBlock* b = static_cast<PoolBlock*>(::operator new(sizeof(PoolBlock) + capacity));
+        b->refs.store(1, std::memory_order_relaxed);
+        b->cls = cls;
+        b->capacity = static_cast<uint32_t>(capacity);
+        b->size = 0;
+        return b;
+    }
+
+    void Release(PoolBlock* b) {
+        if (b->cls >= 0) {
+            Class& c = classes[b->cls];
+            std::lock_guard<std::mutex> lk(c.mutex);
+            if (c.free.size() < c.free.capacity()) {
+                c.free.push_back(b);
+                retained += b->capacity;
+                return;
+            }
+        }
+        dropped++;
+        ::operator delete(b);
+    }
+
+    BufferPoolStats Stats() const {
+        BufferPoolStats s;
+        s.hits = hits.load();
+        s.misses = misses.load();
+        s.dropped = dropped.load();
+        s.retainedBytes = retained.load();
+        return s;
+    }
+
+    // For the metrics log
+    std::wstring Describe() const {
+        BufferPoolStats s = Stats();
+        uint64_t total = s.hits + s.misses;
+        return L"hits=" + std::to_wstring(s.hits) + L" misses=" + std::to_wstring(s.misses)
+            + L" hitRate=" + std::to_wstring(total ? s.hits * 100 / total : 0) + L"%"
+            + L" dropped=" + std::to_wstring(s.dropped) + L" retained=" + std::to_wstring(s.retainedBytes);
+    }
+
+    static size_t classSize(int cls) {
+        return static_cast<size_t>(BUFFER_POOL_MIN_SIZE) << (2 * cls);
+    }
+
+private:
+    struct Class {
+        std::mutex mutex;
+        std::vector<PoolBlock*> free;
+    };
+
+    Class classes[BUFFER_POOL_CLASSES];
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint64_t> retained{ 0 };
+
+    BufferPool() {
+        for (int i = 0; i < BUFFER_POOL_CLASSES; i++) {
+            size_t cap = BUFFER_POOL_CLASS_BYTES / classSize(i);
+            classes[i].free.reserve(cap > 0 ? cap : 1);
+        }
+    }
+
+    static int classOf(size_t size) {
+        for (int i = 0; i < BUFFER_POOL_CLASSES; i++) {
+            if (size <= classSize(i)) return i;
+        }
+        return -1;
+    }
+};
+
+// Reference-counted bytes from BufferPool. Copies share the block (one
+// atomic increment, no copy of the data); the last owner returns it to the
+// pool. Contents are only rewritten through assign/resize, which reuse the
+// block in place when this is its only owner and it is large enough.
+class PipeBuffer {
+public:
+    PipeBuffer() = default;
+    PipeBuffer(const char* p, size_t n) { assign(p, n); }
+    PipeBuffer(std::string_view s) { assign(s.data(), s.size()); }
+    PipeBuffer(const std::string& s) { assign(s.data(), s.size()); }
+    PipeBuffer(const char* s) { assign(s, strlen(s)); }
+
+    PipeBuffer(const PipeBuffer& other) : block(other.block) {
+        if (block) block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    PipeBuffer(PipeBuffer&& other) noexcept : block(other.block) {
+        other.block = nullptr;
+    }
+
+    PipeBuffer& operator=(const PipeBuffer& other) {
+        if (block != other.block) {
+            if (other.block) other.block->refs.fetch_add(1, std::memory_order_relaxed);
+            release();
+            block = other.block;
+        }
+        return *this;
+    }
+
+    PipeBuffer& operator=(PipeBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            block = other.block;
+            other.block = nullptr;
+        }
+        return *this;
+    }
+
+    ~PipeBuffer() {
+        release();
+    }
+
+    void assign(const char* p, size_t n) {
+        resize(n, false);
+        if (n) memcpy(block->bytes(), p, n);
+    }
+
+    // Contents are kept only if keep and the block is reused
+    void resize(size_t n, bool keep = true) {
+        if (n == 0 && !block) return;
+        if (!block || block->refs.load(std::memory_order_acquire) != 1 || block->capacity < n) {
+            PoolBlock* fresh = BufferPool::Instance().Acquire(n);
+            if (keep && block) memcpy(fresh->bytes(), block->bytes(), (std::min)(size_t(block->size), n));
+            release();
+            block = fresh;
+        }
+        block->size = static_cast<uint32_t>(n);
+    }
+
+    // Only while this is the sole owner (right after assign/resize)
+    char* mutableData() { return block ? block->bytes() : nullptr; }
+
+    const char* data() const { return block ? block->bytes() : ""; }
+    size_t size() const { return block ? block->size : 0; }
+    bool empty() const { return size() == 0; }
+    char front() const { return data()[0]; }
+
+    std::string_view view() const { return std::string_view(data(), size()); }
+    operator std::string_view() const { return view(); }
+    // Copies; for the few consumers that need an owning string
+    std::string str() const { return std::string(data(), size()); }
+
+private:
+    PoolBlock* block = nullptr;
+
+    void release() {
+        if (block && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            BufferPool::Instance().Release(block);
+        }
+        block = nullptr;
+    }
+};
@@ -0,0 +1,287 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define ENDPOINT_EWMA_ALPHA        0.3
+// Consecutive connect failures before an endpoint is skipped; the skip
+// doubles from ENDPOINT_BACKOFF_BASE_SEC up to ENDPOINT_BACKOFF_MAX_SEC
+#define ENDPOINT_FAILURE_LIMIT     2
+#define ENDPOINT_BACKOFF_BASE_SEC  5
+#define ENDPOINT_BACKOFF_MAX_SEC   300
+// A connection that lives shorter than this counts as a flap; this many flaps
+// within the window demote the endpoint for ENDPOINT_DEMOTE_SEC
+#define ENDPOINT_FLAP_UPTIME_SEC   30
+#define ENDPOINT_FLAP_LIMIT        3
+#define ENDPOINT_FLAP_WINDOW_SEC   300
+#define ENDPOINT_DEMOTE_SEC        300
+// Affinity mode: ring points per endpoint, and how much worse than the
+// average score the home node may be before the next node on the ring is used
+#define ENDPOINT_VNODES            160
+#define ENDPOINT_AFFINITY_LOAD     2.0
+
+enum class EndpointSelection {
+    Latency,  // weighted random towards the fastest healthy endpoint
+    Affinity, // consistent hash of the registration identity (home node)
+};
+
+// Per-endpoint health and smoothed latency; picks the next endpoint with a
+// random choice weighted towards the lowest connect time and RTT, or, in
+// affinity mode, the first acceptable endpoint clockwise from the identity's
+// point on a consistent-hash ring.
+class EndpointSelector {
+public:
+    EndpointSelector() : rng(std::random_device{}()) {}
+
+    // Keeps the history of endpoints that stay in the list
+    void SetEndpoints(const std::vector<std::wstring>& uris) {
+        std::lock_guard<std::mutex> lk(mutex);
+        std::unordered_map<std::wstring, State> next;
+        for (auto& u : uris) {
+            auto it = states.find(u);
+            next[u] = it != states.end() ? it->second : State{};
+        }
+        states.swap(next);
+        order = uris;
+        buildRing();
+    }
+
+    // key: registration identity (connector id / device id) for Affinity
+    void SetMode(EndpointSelection m, const std::string& key) {
+        std::lock_guard<std::mutex> lk(mutex);
+        mode = m;
+        affinityKey = hash(key.data(), key.size());
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return order.size();
+    }
+
+    bool Contains(const std::wstring& uri) {
+        std::lock_guard<std::mutex> lk(mutex);
+        return states.count(uri) > 0;
+    }
+
+    // Affinity: the home node (see pickAffinity). Latency, or no node left
+    // for affinity: weighted random over healthy endpoints (weight ~
+    // 1 / score^2). If none is healthy, the one that becomes available first.
+    std::wstring Pick() {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (order.empty()) return L"";
+        if (order.size() == 1) return order.front();
+
+        int64_t t = nowMs();
+        double fallback = defaultScore();
+        if (mode == EndpointSelection::Affinity) {
+            std::wstring home = pickAffinity(t, fallback);
+            if (!home.empty()) return home;
+        }
+        std::vector<double> weights;
+        double total = 0;
+        for (auto& u : order) {
+            const State& s = states[u];
+            double w = 0;
+            if (available(s, t)) {
+                double score = s.samples ? s.score() : fallback;
+                w = 1.0 / (score * score);
+            }
+            weights.push_back(w);
+            total += w;
+        }
+        if (total <= 0) {
+            auto best = std::min_element(order.begin(), order.end(), [&](auto& a, auto& b) {
+                return availableAt(states[a]) < availableAt(states[b]);
+            });
+            return *best;
+        }
+        double r = std::uniform_real_distribution<double>(0, total)(rng);
+        for (size_t i = 0; i < order.size(); i++) {
+            if (r < weights[i]) return order[i];
+            r -= weights[i];
+        }
+        return order.back();
+    }
+
+    void ReportConnect(const std::wstring& uri, bool ok, int64_t ms) {
+        std::lock_guard<std::mutex> lk(mutex);
+        auto it = states.find(uri);
+        if (it == states.end()) return;
+        State& s = it->second;
+        int64_t t = nowMs();
+        if (ok) {
+            s.connectMs = ewma(s.connectMs, (double)ms, s.samples);
+            s.samples++;
+            s.failures = 0;
+            s.connectedAt = t;
+        }
+        else {
+            s.failures++;
+            s.totalFailures++;
+            if (s.failures >= ENDPOINT_FAILURE_LIMIT) {
+                int64_t backoff = (std::min)((int64_t)ENDPOINT_BACKOFF_BASE_SEC << (std::min)(s.failures - ENDPOINT_FAILURE_LIMIT, 6),
+                    (int64_t)ENDPOINT_BACKOFF_MAX_SEC);
+                s.retryAt = t + backoff * 1000;
+            }
+        }
+    }
+
+    void ReportRtt(const std::wstring& uri, int64_t ms) {
+        std::lock_guard<std::mutex> lk(mutex);
+        auto it = states.find(uri);
+        if (it == states.end()) return;
+        State& s = it->second;
+        s.rttMs = s.rttSamples ? ewma(s.rttMs, (double)ms, 1) : (double)ms;
+        s.rttSamples++;
+    }
+
+    // A connection that closes soon after opening is a flap
+    void ReportClosed(const std::wstring& uri) {
+        std::lock_guard<std::mutex> lk(mutex);
+        auto it = states.find(uri);
+        if (it == states.end() || it->second.connectedAt == 0) return;
+        State& s = it->second;
+        int64_t t = nowMs();
+        int64_t uptime = t - s.connectedAt;
+        s.connectedAt = 0;
+        if (uptime >= ENDPOINT_FLAP_UPTIME_SEC * 1000) return;
+        if (t - s.flapWindowStart > ENDPOINT_FLAP_WINDOW_SEC * 1000) {
+            s.flapWindowStart = t;
+            s.flaps = 0;
+        }
+        if (++s.flaps >= ENDPOINT_FLAP_LIMIT) {
+            s.demotedUntil = t + ENDPOINT_DEMOTE_SEC * 1000;
+            s.demotions++;
+            s.flaps = 0;
+        }
+    }
+
+    std::wstring Describe() {
+        std::lock_guard<std::mutex> lk(mutex);
+        int64_t t = nowMs();
+        std::wstringstream ss;
+        for (auto& u : order) {
+            const State& s = states[u];
+            ss << u << L"{connectMs=" << (int64_t)s.connectMs << L" rttMs=" << (int64_t)s.rttMs
+                << L" fails=" << s.totalFailures << L" demotions=" << s.demotions
+                << (available(s, t) ? L"" : L" unavailable") << L"} ";
+        }
+        return ss.str();
+    }
+
+private:
+    struct State {
+        double connectMs = 0;
+        double rttMs = 0;
+        uint64_t samples = 0;
+        uint64_t rttSamples = 0;
+        int failures = 0;
+        uint64_t totalFailures = 0;
+        int64_t retryAt = 0;
+        int64_t connectedAt = 0;
+        int64_t flapWindowStart = 0;
+        int flaps = 0;
+        int64_t demotedUntil = 0;
+        uint64_t demotions = 0;
+
+        // Lower is better; RTT dominates, connect time breaks ties
+        double score() const {
+            return 1.0 + rttMs + connectMs / 4;
+        }
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::wstring, State> states;
+    std::vector<std::wstring> order;
+    std::mt19937 rng;
+
+    EndpointSelection mode = EndpointSelection::Latency;
+    uint64_t affinityKey = 0;
+    // (point, index into order), sorted by point
+    std::vector<std::pair<uint64_t, size_t>> ring;
+
+    void buildRing() {
+        ring.clear();
+        for (size_t i = 0; i < order.size(); i++) {
+            std::string base = std::string(reinterpret_cast<const char*>(order[i].data()),
+                order[i].size() * sizeof(wchar_t));
+            for (int v = 0; v < ENDPOINT_VNODES; v++) {
+                std::string point = base + "#" + std::to_string(v);
+                ring.emplace_back(hash(point.data(), point.size()), i);
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+    }
+
+    // Home node unless it is unavailable or far slower than the average
+    // (the client-side view of an overloaded node); then the next distinct
+    // node clockwise. Empty if no node is available.
+    std::wstring pickAffinity(int64_t t, double averageScore) {
+        if (ring.empty()) return L"";
+        auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(affinityKey, (size_t)0));
+        size_t start = static_cast<size_t>(it - ring.begin());
+        std::vector<bool> seen(order.size(), false);
+        size_t firstAvailable = SIZE_MAX;
+        for (size_t n = 0; n < ring.size(); n++) {
+            size_t idx = ring[(start + n) % ring.size()].second;
+            if (seen[idx]) continue;
+            seen[idx] = true;
+            const State& s = states[order[idx]];
+            if (!available(s, t)) continue;
+            if (firstAvailable == SIZE_MAX) firstAvailable = idx;
+            if (!s.samples || s.score() <= averageScore * ENDPOINT_AFFINITY_LOAD) return order[idx];
+        }
+        return firstAvailable == SIZE_MAX ? L"" : order[firstAvailable];
+    }
+
+    static uint64_t hash(const char* data, size_t size) {
+        uint64_t h = 1469598103934665603ull;
+        for (size_t i = 0; i < size; i++) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 1099511628211ull;
+        }
+        // Finalizer: FNV alone clusters similar keys on the ring
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static bool available(const State& s, int64_t t) {
+        return availableAt(s) <= t;
+    }
+
+    static int64_t availableAt(const State& s) {
+        return (std::max)(s.retryAt, s.demotedUntil);
+    }
+
+    // Unmeasured endpoints get the average score so they are tried too
+    double defaultScore() const {
+        double sum = 0;
+        int n = 0;
+        for (auto& [u, s] : states) {
+            if (s.samples) {
+                sum += s.score();
+                n++;
+            }
+        }
+        return n ? sum / n : 1.0;
+    }
+
+    static double ewma(double prev, double sample, uint64_t samples) {
+        if (samples == 0) return sample;
+        return ENDPOINT_EWMA_ALPHA * sample + (1 - ENDPOINT_EWMA_ALPHA) * prev;
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
@@ -0,0 +1,195 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "named_pipe_communication.h"
+#include "utils.h"
+
+#define IPC_BATCH_DEFAULT_WINDOW_US 500
+#define IPC_BATCH_DEFAULT_MAX_COUNT 64
+#define IPC_BATCH_DEFAULT_MAX_BYTES (32 * 1024)
+
+// Coalesces pipe messages into PROTOCOL_BATCH frames. A message that finds
+// the channel idle (nothing sent within the window) goes out at once, so an
+// isolated event gets no extra latency; messages following it within the
+// window join a batch that is written when it reaches maxCount or maxBytes,
+// or when the window timer fires. The timer is a high-resolution waitable
+// timer, so windows below a millisecond are honoured. Each message's Done
+// gets the outcome of the write that carried it.
+class IpcBatcher {
+public:
+    // messages: how many Add() calls the write carries
+    using Sender = std::function<bool(const PipeMessage&, int64_t messages)>;
+    using Done = std::function<void(bool written)>;
+
+    explicit IpcBatcher(Sender s) : sender(std::move(s)) {
+        hTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!hTimer) {
+            // Before Windows 10 1803: same timer at the system tick
+            hTimer = CreateWaitableTimerW(NULL, FALSE, NULL);
+        }
+        hStop = CreateEventW(NULL, TRUE, FALSE, NULL);
+        worker = std::thread([this]() { loop(); });
+    }
+
+    ~IpcBatcher() {
+        SetEvent(hStop);
+        if (worker.joinable()) worker.join();
+        CloseHandle(hTimer);
+        CloseHandle(hStop);
+    }
+
+    // windowUs <= 0 sends every message on its own
+    void Configure(int64_t windowUs, int64_t maxCount, int64_t maxBytes) {
+        std::lock_guard<std::mutex> lk(mutex);
+        this->windowUs = windowUs;
+        this->maxCount = maxCount > 0 ? maxCount : IPC_BATCH_DEFAULT_MAX_COUNT;
+        this->maxBytes = maxBytes > 0 ? maxBytes : IPC_BATCH_DEFAULT_MAX_BYTES;
+    }
+
+    // False only when the write that took the message at once failed. done
+    // runs exactly once, on the thread that writes the message: the caller's
+    // when it goes at once, else the one that writes its batch.
+    bool Add(const PipeMessage& message, Done done = nullptr) {
+        bool now;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            int64_t t = nowUs();
+            now = windowUs <= 0 || (count == 0 && t - lastSentUs >= windowUs);
+            if (now) {
+                lastSentUs = t;
+                immediate++;
+            }
+            AppendBatchFrame(batch, message);
+            dones.push_back(std::move(done));
+            count++;
+            if (count >= maxCount || static_cast<int64_t>(batch.size()) >= maxBytes) {
+                now = true;
+            }
+            else if (!now && count == 1) {
+                // Relative due time, in 100 ns units
+                LARGE_INTEGER due;
+                due.QuadPart = -(windowUs * 10);
+                SetWaitableTimer(hTimer, &due, 0, NULL, NULL, FALSE);
+            }
+        }
+        return !now || flush();
+    }
+
+    // Writes what is waiting now, so a message sent another way after this
+    // does not overtake it
+    void Flush() {
+        flush();
+    }
+
+    uint64_t Immediate() const { return immediate.load(); }
+    uint64_t Batches() const { return batches.load(); }
+    uint64_t Batched() const { return batched.load(); }
+    uint64_t Dropped() const { return dropped.load(); }
+
+private:
+    Sender sender;
+    std::mutex mutex;      // the queue; never held across a write
+    std::mutex writeMutex; // taken before mutex: writes go out in Add order
+    HANDLE hTimer = NULL;
+    HANDLE hStop = NULL;
+    std::thread worker;
+
+    int64_t windowUs = IPC_BATCH_DEFAULT_WINDOW_US;
+    int64_t maxCount = IPC_BATCH_DEFAULT_MAX_COUNT;
+    int64_t maxBytes = IPC_BATCH_DEFAULT_MAX_BYTES;
+    int64_t lastSentUs = 0;
+    std::string batch; // frames in pipe wire format, reused
+    int64_t count = 0;
+    std::vector<Done> dones; // one per frame in batch
+    std::string writing;     // under writeMutex: the batch being written
+
+    std::atomic<uint64_t> immediate{ 0 };
+    std::atomic<uint64_t> batches{ 0 };
+    std::atomic<uint64_t> batched{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+
+    void loop() {
+        HANDLE waits[2] = { hStop, hTimer };
+        while (WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+            flush();
+        }
+        flush();
+    }
+
+    // Writes everything queued, then reports to each message's Done. Add()
+    // keeps queueing while the write is in progress. A lone message goes
+    // out as itself, not as a batch of one. True unless the write failed.
+    bool flush() {
+        std::vector<Done> done;
+        bool ok;
+        {
+            std::lock_guard<std::mutex> wl(writeMutex);
+            int64_t n;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                if (count == 0) return true;
+                CancelWaitableTimer(hTimer);
+                n = count;
+                writing.swap(batch);
+                done.swap(dones);
+                batch.clear();
+                count = 0;
+            }
+            if (n == 1) {
+                PipeMessage single;
+                DWORD size;
+                memcpy(&single.command, writing.data(), sizeof(DWORD));
+                memcpy(&size, writing.data() + sizeof(DWORD), sizeof(DWORD));
+                single.dataSize = size;
+                single.data.assign(writing.data() + sizeof(DWORD) * 2, size);
+                ok = send(single, 1);
+            }
+            else {
+                ok = send(PipeMessage(PROTOCOL_BATCH, writing), n);
+            }
+            if (ok) {
+                batches++;
+                batched += n;
+            }
+            else {
+                dropped += n;
+                write_log(L"[IpcBatcher] ", (L"batch lost: " + std::to_wstring(n)).c_str());
+            }
+            std::lock_guard<std::mutex> lk(mutex);
+            lastSentUs = nowUs();
+        }
+        for (auto& d : done) {
+            if (!d) continue;
+            try {
+                d(ok);
+            }
+            catch (...) {
+                write_log(L"[IpcBatcher] ", L"done callback failed");
+            }
+        }
+        return ok;
+    }
+
+    bool send(const PipeMessage& message, int64_t messages) {
+        try {
+            return sender(message, messages);
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
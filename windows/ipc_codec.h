@@ -0,0 +1,302 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "nlohmann/json.hpp"
+#include "named_pipe_communication.h"
+
+// Binary form of the protocol structs. A payload starts with a fixed
+// 4-byte header, then the fields of its kind in declaration order:
+// integers as LEB128 varints (signed ones zigzagged), strings as a varint
+// length and the bytes. A newer version only appends fields, so a reader
+// takes the fields it knows and ignores the rest. JSON payloads start with
+// '{', never with IPC_CODEC_MARKER, so both forms share the commands.
+#define IPC_CODEC_MARKER           0x00
+#define IPC_CODEC_VERSION          1
+
+enum class IpcKind : uint8_t {
+    Hello = 1,
+    HelloAck = 2,
+    SetUrl = 3,
+    Ack = 4,
+    SocketEvent = 5,
+    Ping = 6,
+    Pong = 7,
+};
+
+struct IpcHeader {
+    uint8_t marker;
+    uint8_t version;
+    uint8_t kind;
+    uint8_t reserved;
+};
+
+// Appends to a caller-owned buffer; reused, it stops allocating once it
+// has grown to the largest message
+class IpcWriter {
+public:
+    IpcWriter(std::string& out, IpcKind kind) : out(out) {
+        IpcHeader h{ IPC_CODEC_MARKER, IPC_CODEC_VERSION, static_cast<uint8_t>(kind), 0 };
+        out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+
+    void u8(uint8_t v) { out += static_cast<char>(v); }
+
+    void varint(uint64_t v) {
+        char buf[10];
+        size_t n = 0;
+        while (v >= 0x80) {
+            buf[n++] = static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = static_cast<char>(v);
+        out.append(buf, n);
+    }
+
+    void sint(int64_t v) { varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+
+    void str(std::string_view v) {
+        varint(v.size());
+        out.append(v.data(), v.size());
+    }
+
+private:
+    std::string& out;
+};
+
+// Reads fields in place from the receive buffer. Past the end, or on a
+// length that overruns it, every read returns zero/empty and ok() is false.
+class IpcReader {
+public:
+    explicit IpcReader(std::string_view data) : p(data.data()), end(data.data() + data.size()) {}
+
+    bool ok() const { return good; }
+
+    uint8_t u8() {
+        if (p >= end) return fail(), 0;
+        return static_cast<uint8_t>(*p++);
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) return fail(), 0;
+            uint8_t b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        return fail(), 0;
+    }
+
+    int64_t sint() {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    std::string_view str() {
+        uint64_t n = varint();
+        if (!good || n > static_cast<uint64_t>(end - p)) return fail(), std::string_view();
+        std::string_view v(p, static_cast<size_t>(n));
+        p += n;
+        return v;
+    }
+
+    // A field added by a newer version is absent in an older payload
+    bool more() const { return good && p < end; }
+
+private:
+    const char* p;
+    const char* end;
+    bool good = true;
+
+    void fail() {
+        good = false;
+        p = end;
+    }
+};
+
+// Kind of a binary payload; 0 for JSON or anything else
+inline uint8_t ipcKindOf(std::string_view data) {
+    if (data.size() < sizeof(IpcHeader) || static_cast<uint8_t>(data[0]) != IPC_CODEC_MARKER
+        || static_cast<uint8_t>(data[1]) < 1) {
+        return 0;
+    }
+    return static_cast<uint8_t>(data[2]);
+}
+
+inline bool isBinaryIpc(std::string_view data) {
+    return ipcKindOf(data) != 0;
+}
+
+// Reader positioned after the header, if data is a binary payload of kind
+inline bool openIpc(std::string_view data, IpcKind kind, IpcReader& r) {
+    if (ipcKindOf(data) != static_cast<uint8_t>(kind)) return false;
+    r = IpcReader(data.substr(sizeof(IpcHeader)));
+    return true;
+}
+
+// Encoders: append to out
+
+inline void encodeIpc(const HelloMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::Hello);
+    w.varint(static_cast<uint32_t>(m.pid));
+    w.str(m.version);
+    w.varint(m.codec);
+}
+
+inline void encodeIpc(const HelloAckMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::HelloAck);
+    w.u8(m.ok ? 1 : 0);
+    w.sint(m.server_time);
+    w.varint(m.codec);
+}
+
+inline void encodeIpc(const SetUrlMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::SetUrl);
+    w.str(m.id);
+    w.str(m.url);
+    w.str(m.opts);
+}
+
+// status travels as a code: 0 "OK", 1 anything else
+inline void encodeIpc(const AckMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::Ack);
+    w.str(m.id);
+    w.u8(m.status == "OK" ? 0 : 1);
+    w.str(m.error);
+}
+
+inline void encodeIpc(const SocketEventMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::SocketEvent);
+    w.str(m.event);
+    w.str(m.payload);
+    w.str(m.id);
+    w.str(m.info);
+}
+
+inline void encodeIpc(const PingMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::Ping);
+    w.sint(m.t);
+}
+
+inline void encodeIpc(const PongMessage& m, std::string& out) {
+    IpcWriter w(out, IpcKind::Pong);
+    w.sint(m.t);
+}
+
+// Binary when the peer reads it (its HELLO / HELLO_ACK codec), else JSON
+template <typename T>
+inline void encodeIpcFor(const T& m, int peerCodec, std::string& out) {
+    out.clear();
+    if (peerCodec < 1) out = toJson(m);
+    else encodeIpc(m, out);
+}
+
+template <typename T>
+inline std::string encodeIpcFor(const T& m, int peerCodec) {
+    std::string out;
+    encodeIpcFor(m, peerCodec, out);
+    return out;
+}
+
+// Decoders: binary fields are read straight from data. A reused message
+// keeps its string capacity, so steady traffic does not allocate. JSON
+// payloads (older peers) are parsed as before. False if data is neither.
+
+inline bool decodeIpc(std::string_view data, HelloMessage& m) {
+    IpcReader r(data);
+    if (openIpc(data, IpcKind::Hello, r)) {
+        m.pid = static_cast<int>(r.varint());
+        m.version.assign(r.str());
+        m.codec = r.more() ? static_cast<int>(r.varint()) : 0;
+        return r.ok();
+    }
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    m.pid = j.value("pid", 0);
+    m.version = j.value("ver", "");
+    m.codec = j.value("codec", 0);
+    return true;
+}
+
+inline bool decodeIpc(std::string_view data, HelloAckMessage& m) {
+    IpcReader r(data);
+    if (openIpc(data, IpcKind::HelloAck, r)) {
+        m.ok = r.u8() != 0;
+        m.server_time = r.sint();
+        m.codec = r.more() ? static_cast<int>(r.varint()) : 0;
+        return r.ok();
+    }
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    m.ok = j.value("ok", false);
+    m.server_time = j.value("server_time", int64_t(0));
+    m.codec = j.value("codec", 0);
+    return true;
+}
+
+// JSON opts stay an object in the JSON form; here they come back as text
+inline bool decodeIpc(std::string_view data, SetUrlMessage& m) {
+    IpcReader r(data);
+    if (openIpc(data, IpcKind::SetUrl, r)) {
+        m.id.assign(r.str());
+        m.url.assign(r.str());
+        m.opts.assign(r.str());
+        return r.ok();
+    }
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    m.id = j.contains("id") && j["id"].is_string() ? j["id"].get<std::string>() : "";
+    m.url = j.value("url", "");
+    m.opts = j.contains("opts") && j["opts"].is_object() ? j["opts"].dump() : "";
+    return true;
+}
+
+inline bool decodeIpc(std::string_view data, AckMessage& m) {
+    IpcReader r(data);
+    if (openIpc(data, IpcKind::Ack, r)) {
+        m.id.assign(r.str());
+        m.status = r.u8() == 0 ? "OK" : "ERROR";
+        m.error.assign(r.str());
+        return r.ok();
+    }
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || !j.contains("id")) return false;
+    m.id = j["id"].is_string() ? j["id"].get<std::string>() : j["id"].dump();
+    m.status = j.value("status", "");
+    m.error = j.value("error", "");
+    return true;
+}
+
+inline bool decodeIpc(std::string_view data, SocketEventMessage& m) {
+    IpcReader r(data);
+    if (openIpc(data, IpcKind::SocketEvent, r)) {
+        m.event.assign(r.str());
+        m.payload.assign(r.str());
+        m.id.assign(r.str());
+        m.info.assign(r.str());
+        return r.ok();
+    }
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    m.event = j.value("event", "");
+    m.payload = j.value("payload", "");
+    m.id = j.value("id", "");
+    m.info = j.contains("info") ? j["info"].dump() : "{}";
+    return true;
+}
+
+// Payload as text for logs, whichever form it came in
+inline std::string describeIpc(DWORD command, std::string_view data) {
+    if (!isBinaryIpc(data)) return std::string(data);
+    switch (command) {
+    case PROTOCOL_HELLO: { HelloMessage m; if (decodeIpc(data, m)) return toJson(m); break; }
+    case PROTOCOL_HELLO_ACK: { HelloAckMessage m; if (decodeIpc(data, m)) return toJson(m); break; }
+    case PROTOCOL_SET_URL: { SetUrlMessage m; if (decodeIpc(data, m)) return toJson(m); break; }
+    case PROTOCOL_ACK: { AckMessage m; if (decodeIpc(data, m)) return toJson(m); break; }
+    case PROTOCOL_SOCKET_EVENT: { SocketEventMessage m; if (decodeIpc(data, m)) return toJson(m); break; }
+    }
+    return "<binary " + std::to_string(data.size()) + " bytes>";
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "named_pipe_communication.h"
+
+// Two classes share each pipe. Control is requests and their replies
+// (SET_URL, stop, reconnect, ACK, handshake, stream credits); data is the
+// event traffic. The value is also the dispatcher lane: 0 is served first.
+enum class IpcPriority : size_t {
+    Control = 0,
+    Data = 1,
+};
+
+#define IPC_PRIORITY_CLASSES       2
+
+inline IpcPriority ipcPriorityOf(DWORD command) {
+    switch (command) {
+    case PROTOCOL_SOCKET_EVENT:
+    case PROTOCOL_BATCH:
+    case PROTOCOL_STREAM_DATA:
+    case 1: // legacy message
+        return IpcPriority::Data;
+    default:
+        return IpcPriority::Control;
+    }
+}
+
+struct IpcPriorityStats {
+    uint64_t acquired = 0;
+    uint64_t waitTotalUs = 0;
+    uint64_t waitMaxUs = 0;
+};
+
+// Serializes writes to one pipe. A writer of a control frame waits for the
+// write in progress only: data writers queued before it are admitted after
+// it. std::mutex gives no such order, so a stop request could sit behind
+// every event thread contending for the pipe.
+class IpcWriteGate {
+public:
+    void lock(IpcPriority p) {
+        int64_t start = nowUs();
+        std::unique_lock<std::mutex> lk(mutex);
+        if (p == IpcPriority::Control) {
+            controlWaiting++;
+            cv.wait(lk, [this]() { return !held; });
+            controlWaiting--;
+        }
+        else {
+            cv.wait(lk, [this]() { return !held && controlWaiting == 0; });
+        }
+        held = true;
+        Counters& c = counters[static_cast<size_t>(p)];
+        uint64_t waited = static_cast<uint64_t>((std::max)(nowUs() - start, int64_t(0)));
+        c.acquired++;
+        c.waitTotalUs += waited;
+        c.waitMaxUs = (std::max)(c.waitMaxUs, waited);
+    }
+
+    void unlock() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            held = false;
+        }
+        cv.notify_all();
+    }
+
+    IpcPriorityStats stats(IpcPriority p) {
+        std::lock_guard<std::mutex> lk(mutex);
+        const Counters& c = counters[static_cast<size_t>(p)];
+        return IpcPriorityStats{ c.acquired, c.waitTotalUs, c.waitMaxUs };
+    }
+
+    // For the metrics log: writes and wait for the pipe per class
+    std::wstring Describe() {
+        return L"control " + describe(stats(IpcPriority::Control))
+            + L" data " + describe(stats(IpcPriority::Data));
+    }
+
+private:
+    using Counters = IpcPriorityStats;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool held = false;
+    int controlWaiting = 0;
+    Counters counters[IPC_PRIORITY_CLASSES];
+
+    static std::wstring describe(const IpcPriorityStats& s) {
+        return L"writes=" + std::to_wstring(s.acquired)
+            + L" waitAvgUs=" + std::to_wstring(s.acquired ? s.waitTotalUs / s.acquired : 0)
+            + L" waitMaxUs=" + std::to_wstring(s.waitMaxUs);
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+class IpcWriteLock {
+public:
+    IpcWriteLock(IpcWriteGate& gate, DWORD command) : gate(gate) {
+        gate.lock(ipcPriorityOf(command));
+    }
+    ~IpcWriteLock() { gate.unlock(); }
+
+    IpcWriteLock(const IpcWriteLock&) = delete;
+    IpcWriteLock& operator=(const IpcWriteLock&) = delete;
+
+private:
+    IpcWriteGate& gate;
+};
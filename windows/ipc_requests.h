@@ -0,0 +1,189 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+#include "ipc_codec.h"
+#include "named_pipe_communication.h"
+
+// Default deadline for a control request (SET_URL, stop, reconnect)
+#define IPC_REQUEST_TIMEOUT_MS     3000
+
+// "id" of a request payload; empty for legacy fire-and-forget payloads.
+// Binary SET_URL carries it as a field, the small control requests (stop,
+// reconnect) are {"id":...} JSON.
+inline std::string requestIdOf(std::string_view data) {
+    if (ipcKindOf(data) == static_cast<uint8_t>(IpcKind::SetUrl)) {
+        SetUrlMessage m;
+        return decodeIpc(data, m) ? m.id : "";
+    }
+    if (data.empty() || data.front() != '{') return "";
+    auto j = nlohmann::json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.contains("id") || !j["id"].is_string()) return "";
+    return j["id"].get<std::string>();
+}
+
+struct IpcRequestStats {
+    uint64_t sent = 0;
+    uint64_t ok = 0;
+    uint64_t failed = 0;   // answered with an error, or could not be sent
+    uint64_t timedOut = 0;
+    uint64_t answered = 0; // replies received; rtt covers these
+    uint64_t rttTotalUs = 0;
+    uint64_t rttMaxUs = 0;
+};
+
+// Correlates requests with their ACK over a duplex channel. Any number of
+// requests may be in flight; each completes exactly once, with the reply or
+// with nullptr when its deadline passes or it could not be sent.
+class IpcRequests {
+public:
+    // reply: nullptr if there was none before the deadline
+    using Done = std::function<void(const AckMessage* reply)>;
+    // Writes the request carrying this id; false if it could not be written
+    using Send = std::function<bool(const std::string& id)>;
+
+    ~IpcRequests() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (timer.joinable()) timer.join();
+    }
+
+    // Pipelined: returns once the request is written. False (and done has
+    // already run with nullptr) if it was not.
+    bool Request(const Send& send, int timeoutMs, Done done) {
+        std::string id;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            id = "r" + std::to_string(++nextId);
+            int64_t t = nowUs();
+            pending.emplace(id, Pending{ t + int64_t(timeoutMs) * 1000, t, std::move(done) });
+            if (!timer.joinable()) timer = std::thread([this]() { expireLoop(); });
+        }
+        cv.notify_all();
+        sent++;
+        if (send(id)) return true;
+        if (Done d = take(id)) {
+            failed++;
+            d(nullptr);
+        }
+        return false;
+    }
+
+    // False if the id is unknown (late reply after the deadline)
+    bool Complete(const AckMessage& ack) {
+        int64_t started = 0;
+        Done d = take(ack.id, &started);
+        if (!d) return false;
+        uint64_t rtt = static_cast<uint64_t>(nowUs() - started);
+        answered++;
+        rttTotalUs += rtt;
+        uint64_t cur = rttMaxUs.load();
+        while (rtt > cur && !rttMaxUs.compare_exchange_weak(cur, rtt)) {}
+        (ack.status == "OK" ? ok : failed)++;
+        d(&ack);
+        return true;
+    }
+
+    // Channel lost: nothing in flight can be answered any more
+    void FailAll() {
+        std::vector<Done> dropped;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            for (auto& [id, p] : pending) dropped.push_back(std::move(p.done));
+            pending.clear();
+        }
+        failed += dropped.size();
+        for (auto& d : dropped) d(nullptr);
+    }
+
+    IpcRequestStats stats() const {
+        IpcRequestStats s;
+        s.sent = sent.load();
+        s.ok = ok.load();
+        s.failed = failed.load();
+        s.timedOut = timedOut.load();
+        s.answered = answered.load();
+        s.rttTotalUs = rttTotalUs.load();
+        s.rttMaxUs = rttMaxUs.load();
+        return s;
+    }
+
+private:
+    struct Pending {
+        int64_t deadlineUs;
+        int64_t startedUs;
+        Done done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, Pending> pending;
+    uint64_t nextId = 0;
+    bool stopping = false;
+    std::thread timer; // started with the first request
+
+    std::atomic<uint64_t> sent{ 0 };
+    std::atomic<uint64_t> ok{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+    std::atomic<uint64_t> timedOut{ 0 };
+    std::atomic<uint64_t> answered{ 0 };
+    std::atomic<uint64_t> rttTotalUs{ 0 };
+    std::atomic<uint64_t> rttMaxUs{ 0 };
+
+    Done take(const std::string& id, int64_t* started = nullptr) {
+        std::lock_guard<std::mutex> lk(mutex);
+        auto it = pending.find(id);
+        if (it == pending.end()) return nullptr;
+        Done d = std::move(it->second.done);
+        if (started) *started = it->second.startedUs;
+        pending.erase(it);
+        return d;
+    }
+
+    // Sleeps until the earliest deadline; callbacks run outside the lock
+    void expireLoop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (!stopping) {
+            int64_t t = nowUs();
+            int64_t next = INT64_MAX;
+            std::vector<Done> expired;
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (it->second.deadlineUs <= t) {
+                    expired.push_back(std::move(it->second.done));
+                    it = pending.erase(it);
+                }
+                else {
+                    next = (std::min)(next, it->second.deadlineUs);
+                    ++it;
+                }
+            }
+            if (!expired.empty()) {
+                lk.unlock();
+                timedOut += expired.size();
+                for (auto& d : expired) d(nullptr);
+                lk.lock();
+                continue;
+            }
+            if (next == INT64_MAX) cv.wait(lk);
+            else cv.wait_for(lk, std::chrono::microseconds(next - t));
+        }
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
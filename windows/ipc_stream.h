@@ -0,0 +1,294 @@
+#pragma once
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "named_pipe_communication.h"
+#include "utils.h"
+
+// Messages above this go as a stream of chunks, so a large payload never
+// holds the pipe for more than one chunk write at a time
+#define IPC_STREAM_THRESHOLD           (64 * 1024)
+#define IPC_STREAM_CHUNK_SIZE          (16 * 1024)
+// Chunks a sender may have unacknowledged per stream; the receiver grants
+// more every half window
+#define IPC_STREAM_WINDOW              8
+#define IPC_STREAM_CREDIT_TIMEOUT_MS   5000
+// Default limit on a streamed message (settings: ipc_max_message_bytes):
+// what one frame may carry, so streaming never admits what a peer without
+// it could not have sent
+#define IPC_STREAM_DEFAULT_MAX_SIZE    PIPE_MAX_MESSAGE_SIZE
+// A stream with no chunk for this long is dropped by the receiver
+#define IPC_STREAM_IDLE_MS             30000
+
+#define STREAM_FLAG_FIN                1
+#define STREAM_FLAG_CANCEL             2
+
+// PROTOCOL_STREAM_DATA payload: this header, then the chunk bytes
+struct StreamChunkHeader {
+    uint32_t streamId;
+    uint32_t command;   // of the whole message
+    uint32_t totalSize;
+    uint32_t offset;
+    uint32_t flags;
+};
+
+// PROTOCOL_STREAM_CREDIT payload, receiver to sender
+struct StreamCredit {
+    uint32_t streamId;
+    uint32_t credits;   // chunks the sender may send in addition
+    uint32_t flags;     // STREAM_FLAG_CANCEL: stop, the receiver dropped it
+};
+
+// Sending side. Send() blocks its caller until the last chunk is written;
+// each chunk is a separate pipe write, so other messages (ACKs, small
+// events from other threads) go out between chunks. Credits arrive on the
+// pipe reader thread through OnCredit.
+class IpcStreamSender {
+public:
+    using Writer = std::function<bool(const PipeMessage&)>;
+
+    // maxSize <= 0: IPC_STREAM_DEFAULT_MAX_SIZE
+    void SetMaxSize(int64_t maxSize) {
+        this->maxSize.store(maxSize > 0 ? maxSize : IPC_STREAM_DEFAULT_MAX_SIZE);
+    }
+
+    bool Send(DWORD command, std::string_view data, const Writer& write) {
+        if (static_cast<int64_t>(data.size()) > maxSize.load()) {
+            write_log(L"[IpcStream] ", (L"message too large: " + std::to_wstring(data.size())).c_str());
+            aborted++;
+            return false;
+        }
+        uint32_t id = nextId.fetch_add(1) + 1;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            streams[id] = Window{ IPC_STREAM_WINDOW, false };
+        }
+        bool ok = sendChunks(id, command, data, write);
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            streams.erase(id);
+        }
+        (ok ? completed : aborted)++;
+        return ok;
+    }
+
+    void OnCredit(const PipeMessage& message) {
+        if (message.data.size() < sizeof(StreamCredit)) return;
+        StreamCredit credit;
+        memcpy(&credit, message.data.data(), sizeof(credit));
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            auto it = streams.find(credit.streamId);
+            if (it == streams.end()) return;
+            it->second.credits += credit.credits;
+            if (credit.flags & STREAM_FLAG_CANCEL) it->second.cancelled = true;
+        }
+        cv.notify_all();
+    }
+
+    // Connection lost: nobody will grant credits for what is in flight
+    void CancelAll() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            for (auto& [id, w] : streams) w.cancelled = true;
+        }
+        cv.notify_all();
+    }
+
+    std::wstring Describe() const {
+        return L"completed=" + std::to_wstring(completed.load()) + L" aborted=" + std::to_wstring(aborted.load())
+            + L" chunks=" + std::to_wstring(chunks.load()) + L" stalls=" + std::to_wstring(stalls.load());
+    }
+
+private:
+    struct Window {
+        uint32_t credits;
+        bool cancelled;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<uint32_t, Window> streams;
+    std::atomic<uint32_t> nextId{ 0 };
+    std::atomic<int64_t> maxSize{ IPC_STREAM_DEFAULT_MAX_SIZE };
+
+    std::atomic<uint64_t> completed{ 0 };
+    std::atomic<uint64_t> aborted{ 0 };
+    std::atomic<uint64_t> chunks{ 0 };
+    std::atomic<uint64_t> stalls{ 0 }; // waits for credit
+
+    bool sendChunks(uint32_t id, DWORD command, std::string_view data, const Writer& write) {
+        thread_local std::string chunk;
+        size_t offset = 0;
+        do {
+            if (!takeCredit(id)) {
+                write_log(L"[IpcStream] ", (L"stream " + std::to_wstring(id) + L" cancelled").c_str());
+                return false;
+            }
+            size_t n = (std::min)(data.size() - offset, static_cast<size_t>(IPC_STREAM_CHUNK_SIZE));
+            StreamChunkHeader h{ id, command, static_cast<uint32_t>(data.size()), static_cast<uint32_t>(offset),
+                offset + n == data.size() ? STREAM_FLAG_FIN : 0u };
+            chunk.assign(reinterpret_cast<const char*>(&h), sizeof(h));
+            chunk.append(data.data() + offset, n);
+            if (!write(PipeMessage(PROTOCOL_STREAM_DATA, chunk))) return false;
+            chunks++;
+            offset += n;
+        } while (offset < data.size());
+        return true;
+    }
+
+    bool takeCredit(uint32_t id) {
+        std::unique_lock<std::mutex> lk(mutex);
+        Window& w = streams[id];
+        if (w.credits == 0 && !w.cancelled) {
+            stalls++;
+            cv.wait_for(lk, std::chrono::milliseconds(IPC_STREAM_CREDIT_TIMEOUT_MS),
+                [&w]() { return w.credits > 0 || w.cancelled; });
+        }
+        if (w.cancelled || w.credits == 0) return false;
+        w.credits--;
+        return true;
+    }
+};
+
+// Receiving side. Chunks are reassembled into a pooled buffer and handed
+// to the message handler whole, as if they had come in one frame. Credits
+// go back through the reply callback.
+class IpcStreamReceiver {
+public:
+    using Reply = std::function<bool(const PipeMessage&)>;
+
+    explicit IpcStreamReceiver(std::function<void(const PipeMessage&)> handler)
+        : messageHandler(std::move(handler)) {}
+
+    // maxSize <= 0: IPC_STREAM_DEFAULT_MAX_SIZE
+    void SetMaxSize(int64_t maxSize) {
+        std::lock_guard<std::mutex> lk(mutex);
+        this->maxSize = maxSize > 0 ? maxSize : IPC_STREAM_DEFAULT_MAX_SIZE;
+    }
+
+    void OnChunk(const PipeMessage& message, const Reply& reply) {
+        if (message.data.size() < sizeof(StreamChunkHeader)) return;
+        StreamChunkHeader h;
+        memcpy(&h, message.data.data(), sizeof(h));
+        std::string_view bytes = message.data.view().substr(sizeof(h));
+
+        std::unique_lock<std::mutex> lk(mutex);
+        int64_t t = nowMs();
+        dropIdle(t);
+        auto found = streams.find(h.streamId);
+        if (found == streams.end() && h.offset != 0) {
+            // Still in flight when we dropped its stream
+            return;
+        }
+        Stream& s = streams[h.streamId];
+        if (!s.started) {
+            s.started = true;
+            s.command = h.command;
+            s.totalSize = h.totalSize;
+            if (h.totalSize > maxSize) {
+                lk.unlock();
+                write_log(L"[IpcStream] ", (L"rejected, too large: " + std::to_wstring(h.totalSize)).c_str());
+                cancel(h.streamId, reply);
+                return;
+            }
+            s.assembled.resize(h.totalSize, false);
+        }
+        if (h.offset != s.received || h.totalSize != s.totalSize || bytes.size() > s.totalSize - s.received) {
+            lk.unlock();
+            write_log(L"[IpcStream] ", L"chunk out of sequence, stream dropped");
+            cancel(h.streamId, reply);
+            return;
+        }
+        s.received += static_cast<uint32_t>(bytes.size());
+        s.lastChunkAt = t;
+        bool fin = (h.flags & STREAM_FLAG_FIN) != 0 || s.received == s.totalSize;
+        uint32_t grant = 0;
+        if (++s.unacked >= IPC_STREAM_WINDOW / 2 && !fin) {
+            grant = s.unacked;
+            s.unacked = 0;
+        }
+
+        PipeMessage whole;
+        memcpy(s.assembled.mutableData() + h.offset, bytes.data(), bytes.size());
+        if (fin) {
+            whole.command = s.command;
+            whole.dataSize = s.totalSize;
+            whole.data = std::move(s.assembled);
+            whole.connection = message.connection;
+            streams.erase(h.streamId);
+        }
+        lk.unlock();
+
+        if (grant) {
+            StreamCredit credit{ h.streamId, grant, 0 };
+            reply(PipeMessage(PROTOCOL_STREAM_CREDIT,
+                std::string_view(reinterpret_cast<const char*>(&credit), sizeof(credit))));
+        }
+        if (fin) {
+            completed++;
+            if (messageHandler) messageHandler(whole);
+        }
+    }
+
+    // The sending side went away; partial streams will not be finished
+    void Reset() {
+        std::lock_guard<std::mutex> lk(mutex);
+        streams.clear();
+    }
+
+    uint64_t Completed() const { return completed.load(); }
+    uint64_t Cancelled() const { return cancelled.load(); }
+
+private:
+    struct Stream {
+        bool started = false;
+        DWORD command = 0;
+        uint32_t totalSize = 0;
+        uint32_t received = 0;
+        uint32_t unacked = 0;
+        int64_t lastChunkAt = 0;
+        PipeBuffer assembled;
+    };
+
+    std::mutex mutex;
+    std::function<void(const PipeMessage&)> messageHandler;
+    std::unordered_map<uint32_t, Stream> streams;
+    int64_t maxSize = IPC_STREAM_DEFAULT_MAX_SIZE;
+    std::atomic<uint64_t> completed{ 0 };
+    std::atomic<uint64_t> cancelled{ 0 };
+
+    void cancel(uint32_t id, const Reply& reply) {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            streams.erase(id);
+        }
+        cancelled++;
+        StreamCredit credit{ id, 0, STREAM_FLAG_CANCEL };
+        reply(PipeMessage(PROTOCOL_STREAM_CREDIT,
+            std::string_view(reinterpret_cast<const char*>(&credit), sizeof(credit))));
+    }
+
+    // Under mutex
+    void dropIdle(int64_t t) {
+        for (auto it = streams.begin(); it != streams.end();) {
+            if (it->second.started && t - it->second.lastChunkAt > IPC_STREAM_IDLE_MS) it = streams.erase(it);
+            else ++it;
+        }
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
@@ -19,6 +19,11 @@
 #include "utils.h"
 #include "process.h"
 #include "named_pipe_communication.h"
+#include "shared_ring.h"
+#include "ipc_codec.h"
+#include "ipc_requests.h"
+#include "ipc_stream.h"
+#include "message_inbox.h"
 
 #include <cstdlib>
 
@@ -52,6 +57,8 @@ namespace local_push_connectivity {
     
     // Global Named Pipe server for parent process
     std::unique_ptr<NamedPipeServer> g_parentPipeServer;
+    // Shared-memory ring the service writes SOCKET_EVENTs into
+    std::unique_ptr<SharedRingReader> g_parentRing;
     
     // Flag to prevent multiple process creation
     std::atomic<bool> g_creatingProcess{ false };
@@ -70,10 +77,19 @@ namespace local_push_connectivity {
         write_log(L"[DEBUG] ", L"LocalPushConnectivityPlugin destructor called");
         // Cleanup when plugin is destroyed
         if (g_parentPipeServer) {
+            PipeServerStats stats = g_parentPipeServer->Stats();
+            write_log(L"[DEBUG] ", (L"Pipe server: accepted=" + std::to_wstring(stats.accepted)
+                + L" reads=" + std::to_wstring(stats.reads) + L" messages=" + std::to_wstring(stats.messages)
+                + L" batches=" + std::to_wstring(stats.batches) + L" deferred=" + std::to_wstring(stats.deferred)).c_str());
+            write_log(L"[DEBUG] ", (L"Buffer pool: " + BufferPool::Instance().Describe()).c_str());
             write_log(L"[DEBUG] ", L"Stopping parent pipe server");
             g_parentPipeServer->Stop();
             g_parentPipeServer.reset();
         }
+        if (g_parentRing) {
+            g_parentRing->Stop();
+            g_parentRing.reset();
+        }
         g_initialized.store(false);
         g_creatingProcess.store(false);
         g_processCreationCount.store(0);
@@ -89,6 +105,60 @@ namespace local_push_connectivity {
     }
 
     std::function<void(ErrorOr<bool> reply)> _result = NULL;
+    // _result is completed from the pipe thread, the window thread or the
+    // startup deadline, whichever comes first
+    std::mutex g_resultMutex;
+    
+    std::function<void(ErrorOr<bool> reply)> takeResult() {
+        std::lock_guard<std::mutex> lock(g_resultMutex);
+        auto r = std::move(_result);
+        _result = NULL;
+        return r;
+    }
+    
+    // Flutter replies must go out on the platform thread. Work from the pipe
+    // and timer threads that completes one is posted to the app window, whose
+    // WndProc hands it to HandleMessage; the window is the one HandleMessage
+    // last saw.
+    #define WM_PLUGIN_RUN (WM_APP + 0x177)
+    std::atomic<HWND> g_platformWindow{ NULL };
+    
+    void runOnPlatformThread(std::function<void()> task) {
+        HWND window = g_platformWindow.load();
+        auto posted = std::make_unique<std::function<void()>>(std::move(task));
+        if (window && PostMessageW(window, WM_PLUGIN_RUN, 0, reinterpret_cast<LPARAM>(posted.get()))) {
+            posted.release();
+            return;
+        }
+        // Runner does not forward messages to HandleMessage (or the window is gone)
+        write_log(L"[Plugin] ", L"No platform window to post to, completing in place");
+        (*posted)();
+    }
+    
+    // Service connection on the parent pipe server (from its HELLO), and the
+    // requests in flight on it
+    std::atomic<uint64_t> g_serviceConnection{ 0 };
+    IpcRequests g_serviceRequests;
+    // Binary codec version the service reads (its HELLO); 0 = JSON only
+    std::atomic<int> g_serviceCodec{ 0 };
+    
+    void HandleParentPipeMessage(const PipeMessage& message);
+    // Large messages from the service arrive in chunks; reassembled ones go
+    // through HandleParentPipeMessage like any other
+    IpcStreamReceiver g_serviceStreams(HandleParentPipeMessage);
+    
+    // Sends a request to the service; the id goes in the payload's "id"
+    bool requestService(DWORD command, std::function<std::string(const std::string& id)> payload,
+        int timeoutMs, IpcRequests::Done done) {
+        uint64_t connection = g_serviceConnection.load();
+        if (!g_parentPipeServer || connection == 0) {
+            done(nullptr);
+            return false;
+        }
+        return g_serviceRequests.Request([&](const std::string& id) {
+            return g_parentPipeServer->Send(connection, PipeMessage(command, payload(id)));
+        }, timeoutMs, std::move(done));
+    }
     
     // Message handler for parent process Named Pipe
     void HandleParentPipeMessage(const PipeMessage& message) {
@@ -96,43 +166,64 @@ namespace local_push_connectivity {
             switch (message.command) {
             case PROTOCOL_HELLO: {
                 write_log(L"[Plugin] ", L"Received HELLO from child process via Named Pipe");
-                write_log(L"[DEBUG] ", (std::wstring(L"HELLO JSON: ") + utf8_to_wide(message.data)).c_str());
+                write_log(L"[DEBUG] ", (std::wstring(L"HELLO JSON: ") + utf8_to_wide(message.data.str())).c_str());
                 write_log(L"[SUCCESS] ", L"Child process successfully connected via Named Pipe!");
                 
+                HelloMessage hello;
+                g_serviceCodec.store(decodeIpc(message.data, hello) ? (std::min)(hello.codec, IPC_CODEC_VERSION) : 0);
+                
+                // This connection is the service: replies and requests go back on it.
+                // Whatever was in flight on a previous one will not be answered.
+                if (g_serviceConnection.exchange(message.connection) != message.connection) {
+                    g_serviceRequests.FailAll();
+                    g_serviceStreams.Reset();
+                }
+                g_processCreationCount.store(0);
+                
                 // Send HELLO_ACK response (matching diagram)
                 HelloAckMessage ackMsg;
                 ackMsg.ok = true;
                 ackMsg.server_time = getCurrentTimeMs();
+                ackMsg.codec = IPC_CODEC_VERSION;
                 
                 std::string ackJson = toJson(ackMsg);
-                std::wstring pipeName = GetPipeName(utf8_to_wide(LocalPushConnectivityPlugin::_settings.title));
-                NamedPipeClient client(pipeName);
-                
-                if (client.Connect()) {
-                    PipeMessage ackMessage(PROTOCOL_HELLO_ACK, ackJson);
-                    if (client.SendMessage(ackMessage)) {
-                        write_log(L"[Plugin] ", L"HELLO_ACK sent to child via Named Pipe");
-                        write_log(L"[DEBUG] ", (std::wstring(L"HELLO_ACK JSON: ") + utf8_to_wide(ackJson)).c_str());
-                    }
-                    client.Disconnect();
+                PipeMessage ackMessage(PROTOCOL_HELLO_ACK, ackJson);
+                if (g_parentPipeServer && g_parentPipeServer->Send(message.connection, ackMessage)) {
+                    write_log(L"[Plugin] ", L"HELLO_ACK sent to child via Named Pipe");
+                    write_log(L"[DEBUG] ", (std::wstring(L"HELLO_ACK JSON: ") + utf8_to_wide(ackJson)).c_str());
                 }
                 
-                if (_result) {
-                    // Gửi settings ngay sau khi nhận được HELLO
-                    LocalPushConnectivityPlugin::sendSettings();
-                    _result(true);
-                    _result = NULL;
+                runOnPlatformThread([]() {
+                    if (auto result = takeResult()) {
+                        // Gửi settings ngay sau khi nhận được HELLO
+                        LocalPushConnectivityPlugin::sendSettings();
+                        result(true);
+                    }
+                });
+                break;
+            }
+            case PROTOCOL_ACK: {
+                AckMessage ack;
+                if (!decodeIpc(message.data, ack) || !g_serviceRequests.Complete(ack)) {
+                    write_log(L"[Plugin] ", (L"ACK without pending request: " + utf8_to_wide(describeIpc(message.command, message.data))).c_str());
+                    break;
                 }
+                // Control round trip, events in flight included
+                IpcRequestStats rs = g_serviceRequests.stats();
+                write_log(L"[DEBUG] ", (L"Control requests: answered=" + std::to_wstring(rs.answered)
+                    + L" rttAvgUs=" + std::to_wstring(rs.rttTotalUs / rs.answered)
+                    + L" rttMaxUs=" + std::to_wstring(rs.rttMaxUs)).c_str());
                 break;
             }
             case PONG: {
-                if (_result) {
-                    write_log(L"[Plugin] ", L"Received PONG from child process via Named Pipe");
-                    // Gửi settings ngay sau khi nhận được PONG
-                    LocalPushConnectivityPlugin::sendSettings();
-                    _result(true);
-                    _result = NULL;
-                }
+                runOnPlatformThread([]() {
+                    if (auto result = takeResult()) {
+                        write_log(L"[Plugin] ", L"Received PONG from child process via Named Pipe");
+                        // Gửi settings ngay sau khi nhận được PONG
+                        LocalPushConnectivityPlugin::sendSettings();
+                        result(true);
+                    }
+                });
                 break;
             }
             case PIPE_CMD_UPDATE_SETTINGS: {
@@ -144,11 +235,18 @@ namespace local_push_connectivity {
             }
             case PROTOCOL_SOCKET_EVENT: {
                 write_log(L"[Plugin] ", L"Received SOCKET_EVENT from child via Named Pipe");
-                write_log(L"[DEBUG] ", (std::wstring(L"SOCKET_EVENT JSON: ") + utf8_to_wide(message.data)).c_str());
+                write_log(L"[DEBUG] ", (std::wstring(L"SOCKET_EVENT JSON: ") + utf8_to_wide(describeIpc(message.command, message.data))).c_str());
                 
+                // The app gets the server message itself, as from the inbox
+                // and the WM_COPYDATA fallback
+                thread_local SocketEventMessage event;
+                if (!decodeIpc(message.data, event)) {
+                    write_log(L"[Plugin] ", L"Malformed SOCKET_EVENT");
+                    break;
+                }
                 if (LocalPushConnectivityPlugin::_flutterApi) {
                     NotificationPigeon n = NotificationPigeon("n", "n");
-                    MessageResponsePigeon mR = MessageResponsePigeon(n, message.data);
+                    MessageResponsePigeon mR = MessageResponsePigeon(n, event.payload);
                     MessageSystemPigeon m = MessageSystemPigeon(false, mR);
                     LocalPushConnectivityPlugin::_flutterApi->OnMessage(m,
                         []() {
@@ -160,15 +258,22 @@ namespace local_push_connectivity {
                 }
                 break;
             }
+            case PROTOCOL_STREAM_DATA: {
+                uint64_t connection = message.connection;
+                g_serviceStreams.OnChunk(message, [connection](const PipeMessage& reply) {
+                    return g_parentPipeServer && g_parentPipeServer->Send(connection, reply);
+                });
+                break;
+            }
             case PROTOCOL_PONG: {
                 write_log(L"[Plugin] ", L"Received PONG from child via Named Pipe");
-                write_log(L"[DEBUG] ", (std::wstring(L"PONG JSON: ") + utf8_to_wide(message.data)).c_str());
+                write_log(L"[DEBUG] ", (std::wstring(L"PONG JSON: ") + utf8_to_wide(message.data.str())).c_str());
                 break;
             }
             case 1: { // Legacy message from child (backward compatibility)
                 if (LocalPushConnectivityPlugin::_flutterApi) {
                     NotificationPigeon n = NotificationPigeon("n", "n");
-                    MessageResponsePigeon mR = MessageResponsePigeon(n, message.data);
+                    MessageResponsePigeon mR = MessageResponsePigeon(n, message.data.str());
                     MessageSystemPigeon m = MessageSystemPigeon(false, mR);
                     LocalPushConnectivityPlugin::_flutterApi->OnMessage(m,
                         []() {
@@ -195,15 +300,22 @@ namespace local_push_connectivity {
 
     void LocalPushConnectivityPlugin::HandleMessage(HWND window, UINT const message,
         LPARAM const lparam) {
+        if (g_platformWindow.load() != window) {
+            g_platformWindow.store(window);
+        }
+        if (message == WM_PLUGIN_RUN) {
+            std::unique_ptr<std::function<void()>> task(reinterpret_cast<std::function<void()>*>(lparam));
+            (*task)();
+            return;
+        }
         if (message == WM_COPYDATA) {
             auto cp_struct = reinterpret_cast<COPYDATASTRUCT*>(lparam);
             if (cp_struct->cbData == PONG) {
-                if (_result) {
+                if (auto result = takeResult()) {
                     write_log(L"[Plugin] ", L"Received PONG from child process via WM_COPYDATA");
                     // Gửi settings ngay sau khi nhận được PONG
                     LocalPushConnectivityPlugin::sendSettings();
-                    _result(true);
-                    _result = NULL;
+                    result(true);
                 }
             }
             else {
@@ -247,23 +359,31 @@ namespace local_push_connectivity {
             // Send settings via parent pipe to child (child is already connected to parent pipe)
             write_log(L"[SETTINGS] ", L"Sending settings via parent pipe to child");
             
-            // Create SET_URL message (matching diagram)
+            // Create SET_URL message (matching diagram); the full settings go in opts
             SetUrlMessage setUrlMsg;
-            setUrlMsg.id = "m1"; // Message ID
             setUrlMsg.url = wide_to_utf8(settings.uri());
-            setUrlMsg.opts = "{}"; // Empty options for now
+            setUrlMsg.opts = pluginSettingsToJson2(settings);
             
-            std::string setUrlJson = toJson(setUrlMsg);
-            PipeMessage message(PROTOCOL_SET_URL, setUrlJson);
-            
-            // Send via parent pipe server (child is already connected to parent pipe)
-            if (g_parentPipeServer) {
-                // Send message through parent pipe server to connected child
+            // Over the service's own connection; answered by an ACK with the same id.
+            // Runs on the pipe thread too (after HELLO), so it must not wait here.
+            bool sent = requestService(PROTOCOL_SET_URL, [&](const std::string& id) {
+                setUrlMsg.id = id;
+                write_log(L"[DEBUG] ", (std::wstring(L"SET_URL JSON: ") + utf8_to_wide(toJson(setUrlMsg))).c_str());
+                return encodeIpcFor(setUrlMsg, g_serviceCodec.load());
+            }, IPC_REQUEST_TIMEOUT_MS, [](const AckMessage* ack) {
+                if (!ack) {
+                    write_log(L"[SETTINGS] ", L"SET_URL not acknowledged in time");
+                } else if (ack->status != "OK") {
+                    write_log(L"[SETTINGS] ", (L"SET_URL failed: " + utf8_to_wide(ack->error)).c_str());
+                } else {
+                    write_log(L"[SETTINGS] ", L"SET_URL applied by service");
+                }
+            });
+            if (sent) {
                 write_log(L"[SETTINGS] ", L"SET_URL sent via parent pipe server");
-                write_log(L"[DEBUG] ", (std::wstring(L"SET_URL JSON: ") + utf8_to_wide(setUrlJson)).c_str());
                 return;
             } else {
-                write_log(L"[ERROR] ", L"Parent pipe server not available");
+                write_log(L"[ERROR] ", L"Service not connected to parent pipe");
             }
             
             // Fallback to WM_COPYDATA (only if Named Pipe fails)
@@ -325,6 +445,29 @@ namespace local_push_connectivity {
             sendMessageFromNoti(*_m);
         }*/
         result(std::nullopt);
+
+        // Messages the service stored while the app was closed (or whose toast
+        // was dismissed): one sequential pass over the inbox segments
+        try {
+            size_t drained = DrainInbox([](uint64_t seq, int64_t timestamp, std::string_view payload) {
+                if (!_flutterApi) return;
+                NotificationPigeon n = NotificationPigeon("n", "n");
+                MessageResponsePigeon mR = MessageResponsePigeon(n, std::string(payload));
+                MessageSystemPigeon m = MessageSystemPigeon(false, mR);
+                _flutterApi->OnMessage(m,
+                    []() {},
+                    [](const FlutterError& e) {
+                        write_log(L"[Inbox] ", (L"Message send error: " + utf8_to_wide(e.code()) + L" - " + utf8_to_wide(e.message())).c_str());
+                    });
+            });
+            write_log(L"[Inbox] ", (L"drained " + std::to_wstring(drained) + L" messages").c_str());
+        }
+        catch (const std::exception& ex) {
+            write_error(ex, 372);
+        }
+        catch (...) {
+            write_error();
+        }
     }
 
     std::optional<MessageSystemPigeon> LocalPushConnectivityPlugin::_m = std::nullopt;
@@ -363,6 +506,62 @@ namespace local_push_connectivity {
         }
     }
 
+    // Service options from WindowsSettingsPigeon; unset ones keep the
+    // PluginSetting defaults
+    static void applyWindowsOptions(PluginSetting& settings, const WindowsSettingsPigeon& windows) {
+        if (windows.standby_host()) settings.standby_host = *windows.standby_host();
+        if (windows.standby_port()) settings.standby_port = *windows.standby_port();
+        if (windows.endpoints()) {
+            settings.endpoints.clear();
+            for (const auto& value : *windows.endpoints()) {
+                const auto* text = std::get_if<std::string>(&value);
+                if (!text || text->empty()) continue;
+                EndpointSetting e;
+                // "host:port"; a bare IPv6 address has more than one colon
+                size_t colon = text->rfind(':');
+                if (colon != std::string::npos && text->find(':') == colon
+                    && colon + 1 < text->size() && text->size() - colon <= 6
+                    && text->find_first_not_of("0123456789", colon + 1) == std::string::npos) {
+                    e.host = text->substr(0, colon);
+                    e.port = std::stoll(text->substr(colon + 1));
+                }
+                else {
+                    e.host = *text;
+                }
+                settings.endpoints.push_back(e);
+            }
+        }
+        if (windows.endpoint_selection()) settings.endpoint_selection = *windows.endpoint_selection();
+        if (windows.subscriptions()) {
+            settings.subscriptions.clear();
+            for (const auto& value : *windows.subscriptions()) {
+                const auto* pattern = std::get_if<std::string>(&value);
+                if (pattern && !pattern->empty()) settings.subscriptions.push_back(*pattern);
+            }
+        }
+        if (windows.rules()) {
+            settings.rules.clear();
+            for (const auto& value : *windows.rules()) {
+                const auto* custom = std::get_if<flutter::CustomEncodableValue>(&value);
+                if (!custom) continue;
+                const auto& rule = std::any_cast<const RouteRulePigeon&>(*custom);
+                RouteRuleSetting r;
+                r.action = rule.action();
+                if (rule.type()) r.type = *rule.type();
+                if (rule.tag()) r.tag = *rule.tag();
+                if (rule.priority()) r.priority = *rule.priority();
+                if (rule.topic()) r.topic = *rule.topic();
+                settings.rules.push_back(r);
+            }
+        }
+        if (windows.ack_window_ms()) settings.ack_window_ms = *windows.ack_window_ms();
+        if (windows.ack_max_count()) settings.ack_max_count = *windows.ack_max_count();
+        if (windows.ipc_batch_window_us()) settings.ipc_batch_window_us = *windows.ipc_batch_window_us();
+        if (windows.ipc_batch_max_count()) settings.ipc_batch_max_count = *windows.ipc_batch_max_count();
+        if (windows.ipc_batch_max_bytes()) settings.ipc_batch_max_bytes = *windows.ipc_batch_max_bytes();
+        if (windows.ipc_max_message_bytes()) settings.ipc_max_message_bytes = *windows.ipc_max_message_bytes();
+    }
+
     void LocalPushConnectivityPlugin::Initialize(int64_t system_type, const AndroidSettingsPigeon* android,
         const WindowsSettingsPigeon* windows,
         const IosSettingsPigeon* ios,
@@ -408,6 +607,7 @@ namespace local_push_connectivity {
                 path,
                 mode.connection_type() == ConnectionType::kTcp
             };
+            if (windows != nullptr) applyWindowsOptions(settings, *windows);
             LocalPushConnectivityPlugin::saveSetting(settings);
             if (windows != nullptr) {
                 std::wstring pathIcon = get_current_path() + std::wstring(L"\\data\\flutter_assets\\") + utf8_to_wide(windows->icon());
@@ -419,6 +619,7 @@ namespace local_push_connectivity {
                 LocalPushConnectivityPlugin::saveSetting(settings);
                 
                 // Start Named Pipe server for parent process (only if not already started)
+                g_serviceStreams.SetMaxSize(settings.ipc_max_message_bytes);
                 if (!g_parentPipeServer) {
                     write_log(L"[DEBUG] ", L"Creating new Named Pipe server");
                     std::wstring pipeName = GetPipeName(utf8_to_wide(settings.title));
@@ -436,6 +637,14 @@ namespace local_push_connectivity {
                     write_log(L"[DEBUG] ", L"Parent Named Pipe server already running");
                     write_log(L"[Plugin] ", L"Parent Named Pipe server already running");
                 }
+                if (!g_parentRing) {
+                    g_parentRing = std::make_unique<SharedRingReader>();
+                    if (!g_parentRing->Start(utf8_to_wide(settings.title), HandleParentPipeMessage)) {
+                        // The service keeps using the pipe for events
+                        write_log(L"[Plugin] ", L"Shared ring not available");
+                        g_parentRing.reset();
+                    }
+                }
 
                 DesktopNotificationManagerCompat::OnActivated([this](
                     DesktopNotificationActivatedEventArgsCompat data) {
@@ -456,15 +665,8 @@ namespace local_push_connectivity {
                 std::wstring pipeName = GetPipeName(utf8_to_wide(settings.title));
                 NamedPipeClient testClient(pipeName);
                 
-                // Try to connect with timeout to avoid blocking
-                bool connected = false;
-                for (int i = 0; i < 3; i++) {
-                    if (testClient.Connect()) {
-                        connected = true;
-                        break;
-                    }
-                    Sleep(100); // Wait 100ms before retry
-                }
+                // Busy instances are waited for inside Connect; not found means no server
+                bool connected = testClient.Connect();
                 
                 if (!connected) {
                     write_log(L"[DEBUG] ", L"No child process found");
@@ -514,7 +716,10 @@ namespace local_push_connectivity {
                     if (status == -8) {
                         write_log(L"[DEBUG] ", L"Waiting for child process to be ready...");
                         // Chờ child process khởi tạo xong với timeout
-                        _result = result;
+                        {
+                            std::lock_guard<std::mutex> lock(g_resultMutex);
+                            _result = result;
+                        }
                         LocalPushConnectivityPlugin::waitForChildProcessReady();
                         g_creatingProcess.store(false);
                         return;
@@ -624,52 +829,61 @@ namespace local_push_connectivity {
         result(true);
     }
 
+    // With the service running this asks it to reconnect to the server
+    // (PIPE_CMD_RECONNECT), e.g. after a network change; true once it has
     void LocalPushConnectivityPlugin::Start(std::function<void(ErrorOr<bool> reply)> result) {
-        result(true);
+        if (g_serviceConnection.load() == 0) {
+            result(true);
+            return;
+        }
+        requestService(PIPE_CMD_RECONNECT, [](const std::string& id) {
+            return "{\"id\":\"" + id + "\"}";
+        }, IPC_REQUEST_TIMEOUT_MS, [result](const AckMessage* ack) {
+            bool ok = ack && ack->status == "OK";
+            if (!ok) {
+                write_log(L"[Plugin] ", (L"Reconnect failed: " + utf8_to_wide(ack ? ack->error : std::string("no reply"))).c_str());
+            }
+            runOnPlatformThread([result, ok]() { result(ok); });
+        });
     }
 
+    // Asks the service to stop over the pipe (CMD_STOP_SERVICE); without a
+    // confirmation it falls back to WM_COPYDATA. Completes on the platform thread
     void LocalPushConnectivityPlugin::Stop(std::function<void(ErrorOr<bool> reply)> result) {
-        try {
-            PluginSetting settings = gSetting();
-            std::string logoutMsg = "logout";
-            
-            // Try Named Pipe first
-            std::wstring pipeName = GetPipeName(utf8_to_wide(settings.title));
-            NamedPipeClient client(pipeName);
-            
-            if (client.Connect()) {
-                PipeMessage message(CMD_STOP_SERVICE, logoutMsg);
-                if (client.SendMessage(message)) {
-                    write_log(L"[STOP] ", L"Sent via Named Pipe");
-                    result(true);
-                    return;
-                } else {
-                    write_log(L"[STOP] ", L"Failed to send via Named Pipe");
-                }
-            } else {
-                write_log(L"[STOP] ", L"Failed to connect via Named Pipe");
-            }
-            
-            // Fallback to WM_COPYDATA
-            std::wstring c(L"logout");
-            COPYDATASTRUCT cds;
-            cds.dwData = 99;
-            cds.cbData = (DWORD)(wcslen(c.c_str()) + 1) * sizeof(wchar_t);
-            cds.lpData = (PVOID)c.c_str();
-            HWND hwndChild = read_pid();
-            if (!hwndChild) {
-                result(true);
+        requestService(CMD_STOP_SERVICE, [](const std::string& id) {
+            return "{\"id\":\"" + id + "\"}";
+        }, IPC_REQUEST_TIMEOUT_MS, [result](const AckMessage* ack) {
+            if (ack && ack->status == "OK") {
+                write_log(L"[STOP] ", L"Stopped via Named Pipe");
+                runOnPlatformThread([result]() { result(true); });
                 return;
             }
-            SendMessageW(hwndChild, WM_COPYDATA, (WPARAM)GetCurrentProcessId(),
-                (LPARAM)&cds);
-            write_log(L"[STOP] ", L"Sent via WM_COPYDATA");
-            result(true);
-        }
-        catch (...) {
-            write_error();
-            result(false);
-        }
+            write_log(L"[STOP] ", (L"Named Pipe stop failed: " + utf8_to_wide(ack ? ack->error : std::string("no reply"))).c_str());
+            runOnPlatformThread([result]() {
+                try {
+                    // Fallback to WM_COPYDATA
+                    std::wstring c(L"logout");
+                    COPYDATASTRUCT cds;
+                    cds.dwData = 99;
+                    cds.cbData = (DWORD)(wcslen(c.c_str()) + 1) * sizeof(wchar_t);
+                    cds.lpData = (PVOID)c.c_str();
+                    HWND hwndChild = read_pid();
+                    if (hwndChild) {
+                        DWORD_PTR reply;
+                        if (SendMessageTimeoutW(hwndChild, WM_COPYDATA, (WPARAM)GetCurrentProcessId(),
+                                (LPARAM)&cds, SMTO_NORMAL, 5000, &reply) == 0) {
+                            write_log(L"[STOP] ", L"Send timeout...");
+                        }
+                        write_log(L"[STOP] ", L"Sent via WM_COPYDATA");
+                    }
+                    result(true);
+                }
+                catch (...) {
+                    write_error();
+                    result(false);
+                }
+            });
+        });
     }
 
     PluginSetting LocalPushConnectivityPlugin::_settings{};
@@ -744,71 +958,28 @@ namespace local_push_connectivity {
         }
     }
 
+    // The HELLO from the child completes _result (HandleParentPipeMessage).
+    // This only arms the deadline after which the start counts as failed.
     void LocalPushConnectivityPlugin::waitForChildProcessReady() {
+        using namespace winrt::Windows::System::Threading;
+        write_log(L"[Plugin] ", L"Waiting for HELLO from child process...");
+        const int timeoutMs = 10000;
         try {
-            write_log(L"[DEBUG] ", L"waitForChildProcessReady called");
-            // Chờ tối đa 10 giây để child process khởi tạo xong
-            const int timeoutMs = 10000;
-            const int checkIntervalMs = 100;
-            int elapsedMs = 0;
-            
-            write_log(L"[DEBUG] ", L"Starting to wait for child process...");
-            write_log(L"[Plugin] ", L"Starting to wait for child process...");
-            
-            while (elapsedMs < timeoutMs) {
-                write_log(L"[DEBUG] ", (L"Checking for child process via Named Pipe, elapsed: " + std::to_wstring(elapsedMs) + L"ms").c_str());
-                // Child process should connect to parent pipe and send HELLO
-                // Parent will receive HELLO in HandleParentPipeMessage
-                // No need to connect to child pipe - just wait for HELLO message
-                write_log(L"[DEBUG] ", L"Waiting for child to send HELLO message via parent pipe...");
-                
-                // Check if we received HELLO message (this should be handled in HandleParentPipeMessage)
-                // For now, just wait a bit and then send settings
-                if (elapsedMs > 2000) { // Wait 2 seconds for child to connect and send HELLO
-                    write_log(L"[DEBUG] ", L"Child process should be ready, sending settings");
-                    write_log(L"[Plugin] ", L"Child process should be ready, sending settings");
-                    write_log(L"[SUCCESS] ", L"Named Pipe communication established successfully!");
-                    LocalPushConnectivityPlugin::sendSettings();
-                    // Reset counter when child process is ready
-                    g_processCreationCount.store(0);
-                    return;
-                }
-                
-                // Add delay to avoid continuous connection attempts
-                Sleep(500); // Wait 500ms before next attempt
-                
-                // Thêm logging để debug
-                if (elapsedMs % 1000 == 0) { // Log mỗi giây
-                    write_log(L"[Plugin] ", L"Still waiting for child process...");
-                }
-                
-                // Chờ một chút rồi kiểm tra lại
-                Sleep(checkIntervalMs);
-                elapsedMs += checkIntervalMs;
-            }
-            
-            // Nếu timeout, gửi lỗi về app và cleanup
-            write_log(L"[Plugin] ", L"Timeout waiting for child process - cleaning up");
-            g_creatingProcess.store(false);
-            if (_result) {
-                _result(false);
-                _result = NULL;
-            }
-        }
-        catch (const std::exception& ex) {
-            write_error(ex, 500);
-            g_creatingProcess.store(false);
-            if (_result) {
-                _result(false);
-                _result = NULL;
-            }
+            ThreadPoolTimer::CreateTimer([](ThreadPoolTimer const&) {
+                runOnPlatformThread([]() {
+                    if (auto result = takeResult()) {
+                        write_log(L"[Plugin] ", L"Timeout waiting for child process - cleaning up");
+                        g_creatingProcess.store(false);
+                        result(false);
+                    }
+                });
+            }, std::chrono::milliseconds(timeoutMs));
         }
         catch (...) {
             write_error();
             g_creatingProcess.store(false);
-            if (_result) {
-                _result(false);
-                _result = NULL;
+            if (auto result = takeResult()) {
+                result(false);
             }
         }
     }
@@ -0,0 +1,226 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "model.h"
+#include "nlohmann/json.hpp"
+#include "utils.h"
+
+using json = nlohmann::json;
+
+// Only this many characters of a frame are looked at to classify it
+#define CLASSIFY_SCAN_LIMIT   128
+
+enum class FrameKind {
+    Data,
+    Pong,
+    Ping,
+    Reconnect, // internal: sent to the app after the first pong
+};
+
+// Dispatch lane of a data frame, from the optional "Priority" envelope field:
+// "high"/"urgent" or 0, "normal" or 1 (default), "low" or 2.
+enum class MessagePriority : uint8_t {
+    High = 0,
+    Normal = 1,
+    Low = 2,
+};
+#define PRIORITY_LANES 3
+
+// One inbound frame. Data frames are parsed at most once (parse()), on the
+// dispatch worker, and the result travels with the message.
+struct InboundMessage {
+    FrameKind kind = FrameKind::Data;
+    std::wstring raw;
+    // Scanned from the raw frame before dispatch (no parse)
+    MessagePriority priority = MessagePriority::Normal;
+    std::optional<int64_t> seq;
+    std::wstring topic; // optional "Topic", matched against subscriptions
+
+    json doc;
+    MessageResponse response;
+    bool parsed = false;
+    bool parseFailed = false;
+    // Cursor and ack recorded for it (WebSocketControl::settle)
+    bool settled = false;
+
+    bool parse() {
+        if (parsed) return true;
+        if (parseFailed) return false;
+        try {
+            doc = json::parse(wide_to_utf8(raw));
+            if (doc.is_object()) {
+                // Khóa "pong" không nằm đầu frame: prefix scan bỏ sót
+                if (doc.contains("pong") && doc.at("pong").is_string()) {
+                    kind = FrameKind::Pong;
+                }
+                else {
+                    response = doc.get<MessageResponse>();
+                }
+            }
+            parsed = true;
+        }
+        catch (const std::exception& ex) {
+            write_log(L"[Received] std::exception: ", winrt::hstring(utf8_to_wide(ex.what())));
+            parseFailed = true;
+        }
+        catch (...) {
+            write_log(L"[Received]", L"Unknown parse error");
+            parseFailed = true;
+        }
+        return parsed;
+    }
+};
+
+namespace frame_scan {
+    inline void skipWs(std::wstring_view s, size_t& i) {
+        while (i < s.size() && (s[i] == L' ' || s[i] == L'\t' || s[i] == L'\r' || s[i] == L'\n')) i++;
+    }
+
+    // Plain JSON string without escapes; anything else is "not recognized"
+    inline bool readString(std::wstring_view s, size_t& i, std::wstring_view& out) {
+        if (i >= s.size() || s[i] != L'"') return false;
+        size_t start = ++i;
+        while (i < s.size() && s[i] != L'"') {
+            if (s[i] == L'\\') return false;
+            i++;
+        }
+        if (i >= s.size()) return false;
+        out = s.substr(start, i - start);
+        i++;
+        return true;
+    }
+
+    inline bool readInt(std::wstring_view s, size_t& i, int64_t& out) {
+        bool neg = i < s.size() && s[i] == L'-';
+        if (neg) i++;
+        size_t start = i;
+        int64_t v = 0;
+        while (i < s.size() && s[i] >= L'0' && s[i] <= L'9' && i - start < 18) {
+            v = v * 10 + (s[i] - L'0');
+            i++;
+        }
+        if (i == start) return false;
+        out = neg ? -v : v;
+        return true;
+    }
+
+    // Position just after `"key":` among the envelope's own keys, or npos.
+    // String bodies are skipped whole and nested objects and arrays (the
+    // sender's Data, Notification) are stepped over, so the same name inside
+    // them never matches: the parse reads top-level keys only.
+    inline size_t findKey(std::wstring_view s, std::wstring_view key) {
+        int depth = 0;
+        bool keyNext = false; // a string here is a name of the envelope
+        for (size_t i = 0; i < s.size(); i++) {
+            wchar_t c = s[i];
+            if (c == L'"') {
+                size_t start = ++i;
+                while (i < s.size() && s[i] != L'"') {
+                    if (s[i] == L'\\') i++;
+                    i++;
+                }
+                if (i >= s.size()) return std::wstring_view::npos;
+                if (keyNext && s.substr(start, i - start) == key) {
+                    size_t v = i + 1;
+                    skipWs(s, v);
+                    if (v < s.size() && s[v] == L':') {
+                        v++;
+                        skipWs(s, v);
+                        return v;
+                    }
+                }
+                keyNext = false;
+            }
+            else if (c == L'{' || c == L'[') {
+                depth++;
+                keyNext = depth == 1 && c == L'{';
+            }
+            else if (c == L'}' || c == L']') {
+                if (--depth <= 0) return std::wstring_view::npos;
+            }
+            else if (c == L',') {
+                keyNext = depth == 1;
+            }
+        }
+        return std::wstring_view::npos;
+    }
+}
+
+// Bounded prefix scan of the first key: {"pong":...} or {"messageType":"ping"|"pong"}.
+// Anything not recognized is Data and gets the full parse later.
+inline FrameKind classifyFrame(std::wstring_view frame) {
+    std::wstring_view s = frame.substr(0, (std::min)(frame.size(), (size_t)CLASSIFY_SCAN_LIMIT));
+    size_t i = 0;
+    frame_scan::skipWs(s, i);
+    if (i >= s.size() || s[i] != L'{') return FrameKind::Data;
+    i++;
+    frame_scan::skipWs(s, i);
+
+    std::wstring_view key;
+    if (!frame_scan::readString(s, i, key)) return FrameKind::Data;
+    frame_scan::skipWs(s, i);
+    if (i >= s.size() || s[i] != L':') return FrameKind::Data;
+    i++;
+    frame_scan::skipWs(s, i);
+
+    if (key == L"pong") {
+        std::wstring_view value;
+        return frame_scan::readString(s, i, value) ? FrameKind::Pong : FrameKind::Data;
+    }
+    if (key == L"messageType") {
+        std::wstring_view value;
+        if (!frame_scan::readString(s, i, value)) return FrameKind::Data;
+        if (value == L"pong") return FrameKind::Pong;
+        if (value == L"ping") return FrameKind::Ping;
+    }
+    return FrameKind::Data;
+}
+
+// One linear scan, no allocation: lets urgent frames skip the queue
+inline MessagePriority scanPriority(std::wstring_view frame) {
+    size_t i = frame_scan::findKey(frame, L"Priority");
+    if (i == std::wstring_view::npos) i = frame_scan::findKey(frame, L"priority");
+    if (i == std::wstring_view::npos) return MessagePriority::Normal;
+
+    int64_t n;
+    std::wstring_view value;
+    if (frame_scan::readInt(frame, i, n)) {
+        if (n <= 0) return MessagePriority::High;
+        return n == 1 ? MessagePriority::Normal : MessagePriority::Low;
+    }
+    if (frame_scan::readString(frame, i, value)) {
+        if (value == L"high" || value == L"urgent") return MessagePriority::High;
+        if (value == L"low") return MessagePriority::Low;
+    }
+    return MessagePriority::Normal;
+}
+
+inline std::optional<int64_t> scanSeq(std::wstring_view frame) {
+    size_t i = frame_scan::findKey(frame, L"Seq");
+    int64_t n;
+    if (i == std::wstring_view::npos || !frame_scan::readInt(frame, i, n)) return std::nullopt;
+    return n;
+}
+
+inline std::wstring scanTopic(std::wstring_view frame) {
+    size_t i = frame_scan::findKey(frame, L"Topic");
+    std::wstring_view value;
+    if (i == std::wstring_view::npos || !frame_scan::readString(frame, i, value)) return L"";
+    return std::wstring(value);
+}
+
+inline InboundMessage makeInboundMessage(std::wstring frame) {
+    InboundMessage m;
+    m.kind = classifyFrame(frame);
+    if (m.kind == FrameKind::Data) {
+        m.priority = scanPriority(frame);
+        m.seq = scanSeq(frame);
+        m.topic = scanTopic(frame);
+    }
+    m.raw = std::move(frame);
+    return m;
+}
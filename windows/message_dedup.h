@@ -0,0 +1,256 @@
+#pragma once
+#include <windows.h>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.h"
+
+#define DEDUP_LRU_CAPACITY      4096
+// Each Bloom generation is sized for the ids it is expected to hold, at
+// DEDUP_BLOOM_BITS_PER_ID bits and DEDUP_BLOOM_HASHES hashes each: about
+// 1e-4 false positives per generation when full. A generation that fills
+// before its half of the horizon is rotated early rather than overfilled.
+#define DEDUP_BLOOM_BITS_PER_ID 20
+#define DEDUP_BLOOM_HASHES      13
+#define DEDUP_MIN_CAPACITY      (64 * 1024)        // 160 KB per generation
+#define DEDUP_MAX_CAPACITY      (4 * 1024 * 1024)  // 10 MB per generation
+#define DEDUP_DEFAULT_HORIZON   (24 * 60 * 60) // seconds
+
+// Recognizes message IDs already delivered. Recent IDs are exact (LRU hash
+// set); older ones, and IDs from before a service restart, come from two
+// rotating Bloom filter generations persisted next to the executable. A
+// false positive drops a real push, so the filters grow with the observed
+// id rate instead of saturating at a fixed size.
+class MessageDedup {
+public:
+    MessageDedup() : path(get_current_path() + L"\\dedup.bin") {
+        int64_t t = wallMs();
+        generations[0].reset(DEDUP_MIN_CAPACITY, t);
+        generations[1].reset(DEDUP_MIN_CAPACITY, t);
+        load();
+    }
+
+    ~MessageDedup() {
+        Flush();
+    }
+
+    void SetHorizon(int64_t seconds) {
+        std::lock_guard<std::mutex> lk(mutex);
+        horizonMs = (seconds > 0 ? seconds : DEDUP_DEFAULT_HORIZON) * 1000;
+    }
+
+    // True if the id was seen within the horizon; otherwise records it
+    bool CheckAndInsert(const std::string& id) {
+        std::lock_guard<std::mutex> lk(mutex);
+        rotateIfNeeded();
+
+        auto it = recent.find(id);
+        if (it != recent.end()) {
+            order.splice(order.begin(), order, it->second);
+            return true;
+        }
+
+        uint64_t h1 = fnv1a(id);
+        uint64_t h2 = mix(h1) | 1;
+        if (generations[0].contains(h1, h2) || generations[1].contains(h1, h2)) {
+            return true;
+        }
+
+        order.push_front(id);
+        recent.emplace(order.front(), order.begin());
+        if (recent.size() > DEDUP_LRU_CAPACITY) {
+            recent.erase(order.back());
+            order.pop_back();
+        }
+        generations[current].add(h1, h2);
+        dirty = true;
+        return false;
+    }
+
+    // Ids the current generation was sized for, and holds (for tests/logs)
+    uint64_t Capacity() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return generations[current].capacity;
+    }
+
+    uint64_t Count() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return generations[current].count;
+    }
+
+    // Writes the Bloom filters if anything changed (called from the heartbeat).
+    // Lookups wait only for the copy; the write and rename happen outside
+    // the lock.
+    void Flush() {
+        std::lock_guard<std::mutex> fl(flushMutex);
+        Generation snapshot[2];
+        uint32_t cur;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (!dirty) return;
+            snapshot[0] = generations[0];
+            snapshot[1] = generations[1];
+            cur = static_cast<uint32_t>(current);
+            dirty = false;
+        }
+        if (!write(snapshot, cur)) {
+            std::lock_guard<std::mutex> lk(mutex);
+            dirty = true;
+        }
+    }
+
+private:
+    static constexpr uint32_t FILE_MAGIC = 0x32445044; // "DPD2"
+
+    struct Generation {
+        std::vector<uint64_t> words;
+        uint64_t bits = 0;
+        uint64_t capacity = 0;
+        uint64_t count = 0;
+        int64_t start = 0;
+
+        void reset(uint64_t ids, int64_t t) {
+            capacity = ids;
+            bits = ids * DEDUP_BLOOM_BITS_PER_ID;
+            words.assign((bits + 63) / 64, 0);
+            count = 0;
+            start = t;
+        }
+
+        bool contains(uint64_t h1, uint64_t h2) const {
+            for (uint64_t i = 0; i < DEDUP_BLOOM_HASHES; i++) {
+                uint64_t bit = (h1 + i * h2) % bits;
+                if (!(words[bit >> 6] & (1ull << (bit & 63)))) return false;
+            }
+            return true;
+        }
+
+        void add(uint64_t h1, uint64_t h2) {
+            for (uint64_t i = 0; i < DEDUP_BLOOM_HASHES; i++) {
+                uint64_t bit = (h1 + i * h2) % bits;
+                words[bit >> 6] |= (1ull << (bit & 63));
+            }
+            count++;
+        }
+    };
+
+    std::mutex mutex;
+    std::mutex flushMutex; // one writer of dedup.bin at a time
+    std::wstring path;
+    int64_t horizonMs = static_cast<int64_t>(DEDUP_DEFAULT_HORIZON) * 1000;
+
+    std::list<std::string> order;
+    std::unordered_map<std::string, std::list<std::string>::iterator> recent;
+
+    // Each generation covers half the horizon (less when it fills early);
+    // lookups check both
+    Generation generations[2];
+    size_t current = 0;
+    bool dirty = false;
+
+    void rotateIfNeeded() {
+        Generation& g = generations[current];
+        int64_t t = wallMs();
+        int64_t age = t - g.start;
+        bool full = g.count >= g.capacity;
+        if (age < horizonMs / 2 && !full) return;
+        if (full) {
+            write_log(L"[Dedup] ", (L"generation full after " + std::to_wstring(age / 1000) + L"s: "
+                + std::to_wstring(g.count) + L" ids").c_str());
+        }
+        // Size the next one for twice the rate seen, over half the horizon
+        uint64_t next = DEDUP_MIN_CAPACITY;
+        if (age < horizonMs) {
+            double perHalf = static_cast<double>(g.count) * (horizonMs / 2) / (std::max)(age, int64_t(1));
+            next = static_cast<uint64_t>((std::min)(perHalf * 2, double(DEDUP_MAX_CAPACITY)));
+            next = (std::max)(next, uint64_t(DEDUP_MIN_CAPACITY));
+        }
+        // Service was down longer than the horizon: the old generation is stale too
+        if (age >= horizonMs) {
+            g.reset(DEDUP_MIN_CAPACITY, t);
+        }
+        current = 1 - current;
+        generations[current].reset(next, t);
+        dirty = true;
+    }
+
+    bool write(const Generation (&snapshot)[2], uint32_t cur) {
+        std::wstring tmp = path + L".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            uint32_t magic = FILE_MAGIC;
+            uint32_t hashes = DEDUP_BLOOM_HASHES;
+            out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+            out.write(reinterpret_cast<const char*>(&hashes), sizeof(hashes));
+            out.write(reinterpret_cast<const char*>(&cur), sizeof(cur));
+            for (auto& g : snapshot) {
+                uint64_t head[3] = { static_cast<uint64_t>(g.start), g.capacity, g.count };
+                out.write(reinterpret_cast<const char*>(head), sizeof(head));
+                out.write(reinterpret_cast<const char*>(g.words.data()), g.words.size() * sizeof(uint64_t));
+            }
+            if (!out) return false;
+        }
+        return MoveFileExW(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    void load() {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return;
+        uint32_t magic = 0, hashes = 0, cur = 0;
+        in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        in.read(reinterpret_cast<char*>(&hashes), sizeof(hashes));
+        in.read(reinterpret_cast<char*>(&cur), sizeof(cur));
+        if (!in || magic != FILE_MAGIC || hashes != DEDUP_BLOOM_HASHES || cur > 1) {
+            write_log(L"[Dedup] ", L"ignore invalid dedup.bin");
+            return;
+        }
+        Generation loaded[2];
+        for (auto& g : loaded) {
+            uint64_t head[3] = { 0, 0, 0 };
+            in.read(reinterpret_cast<char*>(head), sizeof(head));
+            if (!in || head[1] < DEDUP_MIN_CAPACITY || head[1] > DEDUP_MAX_CAPACITY) {
+                write_log(L"[Dedup] ", L"ignore invalid dedup.bin");
+                return;
+            }
+            g.reset(head[1], static_cast<int64_t>(head[0]));
+            g.count = head[2];
+            in.read(reinterpret_cast<char*>(g.words.data()), g.words.size() * sizeof(uint64_t));
+        }
+        if (!in) return;
+        generations[0] = std::move(loaded[0]);
+        generations[1] = std::move(loaded[1]);
+        current = cur;
+    }
+
+    static uint64_t fnv1a(const std::string& s) {
+        uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Wall clock: generation ages must survive restarts
+    static int64_t wallMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
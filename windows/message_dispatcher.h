@@ -0,0 +1,364 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lock-free multi-producer / single-consumer queue (Vyukov).
+// Producers only do one atomic exchange, the consumer never takes a lock.
+template <typename T>
+class MpscQueue {
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        T value{};
+    };
+
+    std::atomic<Node*> head;
+    Node* tail;
+
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head.store(stub);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        while (tail) {
+            Node* next = tail->next.load(std::memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread
+    void push(T value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+    // Consumer thread only
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+
+template <typename T>
+struct DispatchItem {
+    // Items with the same key are always handled by the same worker, in order.
+    std::wstring key;
+    T value{};
+    int64_t enqueuedAt = 0;
+    size_t lane = 0;
+};
+
+// Lane 0 is the most urgent. Strict always serves the lowest non-empty lane;
+// Weighted serves up to `weight` items from each lane per round, lane 0
+// first: while it has credit left in the round, a lane 0 item goes ahead of
+// the turn of whichever lane is being served.
+enum class LaneScheduling { Strict, Weighted };
+
+struct LaneConfig {
+    size_t maxDepth = 0; // per worker; 0 = unbounded
+    uint32_t weight = 1;
+};
+
+struct LaneStats {
+    uint64_t enqueued = 0;
+    uint64_t processed = 0;
+    uint64_t dropped = 0;
+    uint64_t spilled = 0;       // offer() calls that found the lane full
+    uint64_t queueLatencyTotalUs = 0;
+    uint64_t queueLatencyMaxUs = 0;
+};
+
+struct DispatchStats {
+    uint64_t enqueued = 0;
+    uint64_t processed = 0;
+    uint64_t queueLatencyTotalUs = 0;
+    uint64_t queueLatencyMaxUs = 0;
+    uint64_t handlerTotalUs = 0;
+    uint64_t handlerMaxUs = 0;
+    std::vector<LaneStats> lanes;
+};
+
+// Moves message handling (pipe, toast...) off the socket receive thread.
+// Producers never block: post() drops what does not fit, offer() hands it
+// back so the producer can put it somewhere else (the socket reader stores
+// it in the inbox).
+template <typename T>
+class MessageDispatcher {
+public:
+    using Item = DispatchItem<T>;
+    using Handler = std::function<void(Item&)>;
+
+    MessageDispatcher(size_t workerCount, Handler handler,
+        std::vector<LaneConfig> lanes = { LaneConfig{} },
+        LaneScheduling scheduling = LaneScheduling::Strict)
+        : handler(std::move(handler)), laneConfig(std::move(lanes)), scheduling(scheduling) {
+        if (workerCount == 0) workerCount = 1;
+        if (laneConfig.empty()) laneConfig.push_back(LaneConfig{});
+        laneCounters = std::make_unique<LaneCounters[]>(laneConfig.size());
+        for (size_t i = 0; i < workerCount; i++) {
+            workers.push_back(std::make_unique<Worker>(laneConfig.size()));
+            refill(*workers.back());
+        }
+        for (auto& w : workers) {
+            Worker* worker = w.get();
+            worker->thread = std::thread([this, worker]() { run(*worker); });
+        }
+    }
+
+    ~MessageDispatcher() {
+        stop();
+    }
+
+    MessageDispatcher(const MessageDispatcher&) = delete;
+    MessageDispatcher& operator=(const MessageDispatcher&) = delete;
+
+    // False if stopping or the lane is at its depth limit (value is dropped)
+    bool post(std::wstring key, T value, size_t lane = 0) {
+        if (stopping.load()) return false;
+        if (lane >= laneConfig.size()) lane = laneConfig.size() - 1;
+        if (tryPost(key, value, lane)) return true;
+        laneCounters[lane].dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Moves value in if the lane has room. Otherwise (or when stopping)
+    // value is left to the caller, and the lane counts it as spilled.
+    bool offer(std::wstring key, T& value, size_t lane = 0) {
+        if (stopping.load()) return false;
+        if (lane >= laneConfig.size()) lane = laneConfig.size() - 1;
+        if (tryPost(key, value, lane)) return true;
+        laneCounters[lane].spilled.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void setScheduling(LaneScheduling s) {
+        scheduling.store(s);
+    }
+
+    void stop() {
+        if (stopping.exchange(true)) return;
+        for (auto& w : workers) {
+            {
+                std::lock_guard<std::mutex> lk(w->mutex);
+                w->cv.notify_one();
+            }
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+    DispatchStats stats() const {
+        DispatchStats s;
+        s.enqueued = enqueued.load();
+        s.processed = processed.load();
+        s.queueLatencyTotalUs = queueLatencyTotalUs.load();
+        s.queueLatencyMaxUs = queueLatencyMaxUs.load();
+        s.handlerTotalUs = handlerTotalUs.load();
+        s.handlerMaxUs = handlerMaxUs.load();
+        for (size_t i = 0; i < laneConfig.size(); i++) {
+            const LaneCounters& c = laneCounters[i];
+            LaneStats l;
+            l.enqueued = c.enqueued.load();
+            l.processed = c.processed.load();
+            l.dropped = c.dropped.load();
+            l.spilled = c.spilled.load();
+            l.queueLatencyTotalUs = c.queueLatencyTotalUs.load();
+            l.queueLatencyMaxUs = c.queueLatencyMaxUs.load();
+            s.lanes.push_back(l);
+        }
+        return s;
+    }
+
+private:
+    struct Lane {
+        MpscQueue<Item> queue;
+        std::atomic<size_t> depth{ 0 };
+    };
+
+    struct Worker {
+        explicit Worker(size_t laneCount) : lanes(laneCount) {}
+        std::vector<Lane> lanes;
+        // Weighted scheduling state (worker thread only): items each lane may
+        // still take this round, and the lane after 0 whose turn it is
+        std::vector<uint32_t> credits;
+        size_t currentLane = 1;
+        std::atomic<bool> parked{ false };
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread thread;
+    };
+
+    struct LaneCounters {
+        std::atomic<uint64_t> enqueued{ 0 };
+        std::atomic<uint64_t> processed{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> spilled{ 0 };
+        std::atomic<uint64_t> queueLatencyTotalUs{ 0 };
+        std::atomic<uint64_t> queueLatencyMaxUs{ 0 };
+    };
+
+    Handler handler;
+    std::vector<LaneConfig> laneConfig;
+    std::unique_ptr<LaneCounters[]> laneCounters;
+    std::atomic<LaneScheduling> scheduling;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping{ false };
+
+    std::atomic<uint64_t> enqueued{ 0 };
+    std::atomic<uint64_t> processed{ 0 };
+    std::atomic<uint64_t> queueLatencyTotalUs{ 0 };
+    std::atomic<uint64_t> queueLatencyMaxUs{ 0 };
+    std::atomic<uint64_t> handlerTotalUs{ 0 };
+    std::atomic<uint64_t> handlerMaxUs{ 0 };
+
+    void run(Worker& w) {
+        Item item;
+        while (true) {
+            if (!popNext(w, item)) {
+                if (stopping.load()) return;
+                std::unique_lock<std::mutex> lk(w.mutex);
+                w.parked.store(true);
+                // Either post() sees parked, or the emptiness check below
+                // sees its item
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                w.cv.wait_for(lk, std::chrono::milliseconds(500), [&]() {
+                    return !allEmpty(w) || stopping.load();
+                });
+                w.parked.store(false);
+                continue;
+            }
+
+            int64_t start = nowUs();
+            LaneCounters& lc = laneCounters[item.lane];
+            record(queueLatencyTotalUs, queueLatencyMaxUs, start - item.enqueuedAt);
+            record(lc.queueLatencyTotalUs, lc.queueLatencyMaxUs, start - item.enqueuedAt);
+            try {
+                if (handler) handler(item);
+            }
+            catch (...) {
+                // handler tự log lỗi, worker không được chết
+            }
+            record(handlerTotalUs, handlerMaxUs, nowUs() - start);
+            processed.fetch_add(1, std::memory_order_relaxed);
+            lc.processed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Moves value in only when the lane has room
+    bool tryPost(std::wstring& key, T& value, size_t lane) {
+        Worker& w = *workers[std::hash<std::wstring>{}(key) % workers.size()];
+        Lane& l = w.lanes[lane];
+        size_t limit = laneConfig[lane].maxDepth;
+        if (l.depth.fetch_add(1) >= limit && limit > 0) {
+            l.depth.fetch_sub(1);
+            return false;
+        }
+
+        Item item;
+        item.key = std::move(key);
+        item.value = std::move(value);
+        item.enqueuedAt = nowUs();
+        item.lane = lane;
+        l.queue.push(std::move(item));
+        enqueued.fetch_add(1, std::memory_order_relaxed);
+        laneCounters[lane].enqueued.fetch_add(1, std::memory_order_relaxed);
+
+        // Chỉ đánh thức worker khi nó đang ngủ. The push is a release store;
+        // the fence keeps the parked load after it (pairs with run())
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (w.parked.load()) {
+            std::lock_guard<std::mutex> lk(w.mutex);
+            w.cv.notify_one();
+        }
+        return true;
+    }
+
+    bool popLane(Worker& w, size_t lane, Item& item) {
+        if (!w.lanes[lane].queue.pop(item)) return false;
+        w.lanes[lane].depth.fetch_sub(1);
+        return true;
+    }
+
+    bool popNext(Worker& w, Item& item) {
+        size_t count = w.lanes.size();
+        if (scheduling.load() == LaneScheduling::Strict) {
+            for (size_t i = 0; i < count; i++) {
+                if (popLane(w, i, item)) return true;
+            }
+            return false;
+        }
+        // Weighted rounds. Lane 0 is checked before every pop and keeps its
+        // credit while empty, so until it has used its weight in a round a
+        // high item waits only for the handler in progress. The other lanes
+        // take turns; an empty one gives up the rest of its turn. The round
+        // ends when no lane can go on.
+        for (int round = 0; round < 2; round++) {
+            if (w.credits[0] > 0 && popLane(w, 0, item)) {
+                w.credits[0]--;
+                return true;
+            }
+            for (size_t n = 1; n < count; n++) {
+                size_t lane = w.currentLane;
+                if (w.credits[lane] > 0 && popLane(w, lane, item)) {
+                    w.credits[lane]--;
+                    return true;
+                }
+                w.credits[lane] = 0;
+                w.currentLane = lane + 1 < count ? lane + 1 : 1;
+            }
+            refill(w);
+        }
+        return false;
+    }
+
+    void refill(Worker& w) {
+        w.credits.resize(laneConfig.size());
+        for (size_t i = 0; i < laneConfig.size(); i++) {
+            w.credits[i] = (std::max)(laneConfig[i].weight, 1u);
+        }
+    }
+
+    static bool allEmpty(const Worker& w) {
+        for (auto& l : w.lanes) {
+            if (!l.queue.empty()) return false;
+        }
+        return true;
+    }
+
+    static void record(std::atomic<uint64_t>& total, std::atomic<uint64_t>& max, int64_t us) {
+        uint64_t v = us > 0 ? static_cast<uint64_t>(us) : 0;
+        total.fetch_add(v, std::memory_order_relaxed);
+        uint64_t cur = max.load(std::memory_order_relaxed);
+        while (v > cur && !max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
@@ -0,0 +1,394 @@
+#pragma once
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cwchar>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "utils.h"
+
+#define INBOX_SEGMENT_BYTES   (4u * 1024 * 1024)
+#define INBOX_MAX_SEGMENTS    16
+#define INBOX_COMMIT_MS       20   // group commit interval
+#define INBOX_COMPACT_SEC     60
+
+#define INBOX_RECORD_MAGIC    0x58424E49u // "INBX"
+#define INBOX_STATE_CONSUMED  1u
+
+// Append-only log of accepted messages the app may not have seen yet.
+// Each segment is a memory-mapped file of records; a record is visible once
+// its magic is written, and is flagged consumed in place once the app has it.
+#pragma pack(push, 8)
+struct InboxRecordHeader {
+    volatile LONG magic;
+    volatile LONG state;
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t seq;
+    int64_t timestamp;
+};
+#pragma pack(pop)
+
+inline std::wstring InboxDirectory() {
+    return get_current_path() + L"\\inbox";
+}
+
+class InboxSegment {
+public:
+    std::wstring path;
+    uint64_t firstSeq = 0;
+    uint64_t lastSeq = 0;
+    size_t size = 0;
+    size_t used = 0;
+
+    ~InboxSegment() {
+        Close();
+    }
+
+    bool Open(const std::wstring& file, size_t bytes, bool create) {
+        path = file;
+        hFile = CreateFileW(file.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+            create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+        if (!create) {
+            LARGE_INTEGER li;
+            if (!GetFileSizeEx(hFile, &li) || li.QuadPart == 0) return false;
+            bytes = static_cast<size_t>(li.QuadPart);
+        }
+        hMap = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(bytes), NULL);
+        if (!hMap) return false;
+        base = static_cast<char*>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+        if (!base) return false;
+        size = bytes;
+        return true;
+    }
+
+    void Close() {
+        if (base) UnmapViewOfFile(base);
+        if (hMap) CloseHandle(hMap);
+        if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+        base = nullptr;
+        hMap = NULL;
+        hFile = INVALID_HANDLE_VALUE;
+    }
+
+    // Walks committed records in order; stops at the first unwritten slot
+    template <typename F>
+    void ForEach(F&& fn) {
+        size_t off = 0;
+        while (off + sizeof(InboxRecordHeader) <= size) {
+            auto* h = reinterpret_cast<InboxRecordHeader*>(base + off);
+            if (h->magic != (LONG)INBOX_RECORD_MAGIC) break;
+            MemoryBarrier();
+            size_t total = RecordSize(h->length);
+            if (off + total > size) break;
+            fn(h, std::string_view(base + off + sizeof(InboxRecordHeader), h->length));
+            off += total;
+        }
+        used = off;
+    }
+
+    InboxRecordHeader* Append(uint64_t seq, int64_t ts, const std::string& payload) {
+        size_t total = RecordSize(payload.size());
+        if (used + total > size) return nullptr;
+        auto* h = reinterpret_cast<InboxRecordHeader*>(base + used);
+        h->state = 0;
+        h->length = static_cast<uint32_t>(payload.size());
+        h->reserved = 0;
+        h->seq = seq;
+        h->timestamp = ts;
+        memcpy(base + used + sizeof(InboxRecordHeader), payload.data(), payload.size());
+        // Magic last: readers in the app process never see a half-written record
+        InterlockedExchange(&h->magic, (LONG)INBOX_RECORD_MAGIC);
+        if (firstSeq == 0) firstSeq = seq;
+        lastSeq = seq;
+        used += total;
+        return h;
+    }
+
+    void Flush(size_t from, size_t to) {
+        if (!base || to <= from) return;
+        FlushViewOfFile(base + from, to - from);
+        FlushFileBuffers(hFile);
+    }
+
+    bool AllConsumed() {
+        bool all = true;
+        ForEach([&](InboxRecordHeader* h, std::string_view) {
+            if (!(h->state & INBOX_STATE_CONSUMED)) all = false;
+        });
+        return all;
+    }
+
+    static size_t RecordSize(size_t payload) {
+        return (sizeof(InboxRecordHeader) + payload + 7) & ~static_cast<size_t>(7);
+    }
+
+private:
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMap = NULL;
+    char* base = nullptr;
+};
+
+// Reference to an appended record, used to flag it consumed after delivery
+struct InboxRef {
+    uint64_t seq = 0;
+    InboxRecordHeader* header = nullptr;
+    std::shared_ptr<InboxSegment> segment; // keeps the view mapped
+};
+
+inline std::vector<std::wstring> ListInboxSegments(const std::wstring& dir) {
+    std::vector<std::wstring> files;
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileW((dir + L"\\*.seg").c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE) return files;
+    do {
+        files.push_back(dir + L"\\" + fd.cFileName);
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+    // Tên file là firstSeq có padding: thứ tự chữ = thứ tự seq
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Seq of the first record a segment was created for, from its file name
+inline uint64_t InboxSegmentSeq(const std::wstring& file) {
+    size_t slash = file.find_last_of(L"\\");
+    const wchar_t* name = file.c_str() + (slash == std::wstring::npos ? 0 : slash + 1);
+    return wcstoull(name, nullptr, 10);
+}
+
+// Service side writer
+class MessageInbox {
+public:
+    MessageInbox() : dir(InboxDirectory()) {
+        CreateDirectoryW(dir.c_str(), NULL);
+        recover();
+        flusher = std::thread([this]() { flushLoop(); });
+    }
+
+    ~MessageInbox() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (flusher.joinable()) flusher.join();
+    }
+
+    // Durable within INBOX_COMMIT_MS; no fsync on the caller's thread
+    InboxRef Append(const std::string& payload) {
+        std::lock_guard<std::mutex> lk(mutex);
+        InboxRef ref;
+        uint64_t seq = nextSeq;
+        int64_t ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        InboxRecordHeader* h = active ? active->Append(seq, ts, payload) : nullptr;
+        if (!h) {
+            if (!roll(InboxSegment::RecordSize(payload.size()))) return ref;
+            h = active->Append(seq, ts, payload);
+            if (!h) return ref;
+        }
+        nextSeq++;
+        pending = true;
+        ref.seq = seq;
+        ref.header = h;
+        ref.segment = active;
+        return ref;
+    }
+
+    // Runs fn once the record is on disk: at once if the group commit that
+    // covers it is done, else on the flusher thread right after it. For
+    // anything that must not happen before the record is durable (the ack
+    // that lets the server forget the message).
+    void AfterCommit(const InboxRef& ref, std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (ref.seq > committedSeq) {
+                committing.emplace_back(ref.seq, std::move(fn));
+                return;
+            }
+        }
+        fn();
+    }
+
+    static void MarkConsumed(const InboxRef& ref) {
+        if (ref.header) InterlockedOr(&ref.header->state, (LONG)INBOX_STATE_CONSUMED);
+    }
+
+private:
+    std::wstring dir;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread flusher;
+    bool stopping = false;
+    bool pending = false;
+
+    std::shared_ptr<InboxSegment> active;
+    size_t flushedUpTo = 0;
+    uint64_t nextSeq = 1;
+    uint64_t committedSeq = 0; // records up to this seq are flushed
+    std::vector<std::pair<uint64_t, std::function<void()>>> committing;
+
+    // Written but not yet flushed, taken by the flusher under mutex and
+    // flushed outside it
+    struct FlushRange {
+        std::shared_ptr<InboxSegment> segment;
+        size_t from;
+        size_t to;
+    };
+    std::vector<FlushRange> sealed; // tails of segments rolled away from
+    bool compactDue = false;
+
+    // The last segment may be empty (rolled to just before a crash), so the
+    // seq continues from the newest segment that has records, and never
+    // goes below the seq the last segment was named for
+    void recover() {
+        auto files = ListInboxSegments(dir);
+        if (files.empty()) return;
+        auto seg = std::make_shared<InboxSegment>();
+        if (!seg->Open(files.back(), 0, false)) {
+            write_log(L"[Inbox] ", L"cannot open last segment");
+            return;
+        }
+        seg->ForEach([&](InboxRecordHeader* h, std::string_view) {
+            if (seg->firstSeq == 0) seg->firstSeq = h->seq;
+            seg->lastSeq = h->seq;
+        });
+        uint64_t last = seg->lastSeq;
+        for (size_t i = files.size() - 1; last == 0 && i-- > 0;) {
+            InboxSegment older;
+            if (!older.Open(files[i], 0, false)) continue;
+            older.ForEach([&](InboxRecordHeader* h, std::string_view) { last = h->seq; });
+        }
+        nextSeq = (std::max)(last + 1, InboxSegmentSeq(files.back()));
+        committedSeq = nextSeq - 1;
+        active = seg;
+        flushedUpTo = seg->used;
+    }
+
+    // Under mutex: no I/O beyond creating the new mapping
+    bool roll(size_t needed) {
+        if (active && active->used > flushedUpTo) {
+            sealed.push_back(FlushRange{ active, flushedUpTo, active->used });
+        }
+        auto seg = std::make_shared<InboxSegment>();
+        wchar_t name[32];
+        swprintf(name, 32, L"%020llu.seg", static_cast<unsigned long long>(nextSeq));
+        if (!seg->Open(dir + L"\\" + name, (std::max)((size_t)INBOX_SEGMENT_BYTES, needed), true)) {
+            write_log(L"[Inbox] ", L"cannot create segment");
+            return false;
+        }
+        active = seg;
+        flushedUpTo = 0;
+        compactDue = true;
+        cv.notify_one();
+        return true;
+    }
+
+    // Flusher thread, without mutex. Deletes sealed segments whose records
+    // were all consumed, and the oldest ones beyond INBOX_MAX_SEGMENTS.
+    // Segments from activePath on (named by seq, so sorted after every
+    // sealed one) may be written meanwhile and are left alone.
+    void compact(const std::wstring& activePath) {
+        auto files = ListInboxSegments(dir);
+        size_t remaining = files.size();
+        for (auto& f : files) {
+            if (!activePath.empty() && f >= activePath) break;
+            bool drop = remaining > INBOX_MAX_SEGMENTS;
+            if (!drop) {
+                InboxSegment seg;
+                drop = seg.Open(f, 0, false) && seg.AllConsumed();
+            }
+            if (drop && DeleteFileW(f.c_str())) {
+                remaining--;
+            }
+        }
+    }
+
+    // Append() only waits for the snapshot below, never for a flush or a
+    // compaction
+    void flushLoop() {
+        auto lastCompact = std::chrono::steady_clock::now();
+        std::vector<FlushRange> ranges;
+        std::vector<std::pair<uint64_t, std::function<void()>>> done;
+        std::unique_lock<std::mutex> lk(mutex);
+        while (true) {
+            cv.wait_for(lk, std::chrono::milliseconds(INBOX_COMMIT_MS));
+            // Group commit: một lần flush cho mọi record ghi trong khoảng này
+            ranges.swap(sealed);
+            if (pending && active) {
+                ranges.push_back(FlushRange{ active, flushedUpTo, active->used });
+                flushedUpTo = active->used;
+                pending = false;
+            }
+            // Every record appended so far is in ranges
+            uint64_t upTo = nextSeq - 1;
+            bool stop = stopping;
+            auto t = std::chrono::steady_clock::now();
+            bool doCompact = compactDue || t - lastCompact > std::chrono::seconds(INBOX_COMPACT_SEC);
+            compactDue = false;
+            std::wstring activePath = active ? active->path : L"";
+            lk.unlock();
+
+            for (auto& r : ranges) {
+                r.segment->Flush(r.from, r.to);
+            }
+            ranges.clear();
+
+            lk.lock();
+            committedSeq = upTo;
+            auto covered = std::partition(committing.begin(), committing.end(),
+                [upTo](const auto& c) { return c.first > upTo; });
+            std::move(covered, committing.end(), std::back_inserter(done));
+            committing.erase(covered, committing.end());
+            lk.unlock();
+
+            for (auto& c : done) {
+                try {
+                    c.second();
+                }
+                catch (...) {
+                    write_log(L"[Inbox] ", L"commit callback failed");
+                }
+            }
+            done.clear();
+            if (doCompact && !stop) {
+                lastCompact = t;
+                compact(activePath);
+            }
+
+            lk.lock();
+            if (stop) return;
+        }
+    }
+};
+
+// App side: hands every unconsumed record to fn in sequence order and flags
+// it consumed. Sequential mapped reads only. Returns the number delivered.
+inline size_t DrainInbox(std::function<void(uint64_t seq, int64_t timestamp, std::string_view payload)> fn) {
+    size_t count = 0;
+    for (auto& f : ListInboxSegments(InboxDirectory())) {
+        InboxSegment seg;
+        if (!seg.Open(f, 0, false)) continue;
+        seg.ForEach([&](InboxRecordHeader* h, std::string_view payload) {
+            if (h->state & INBOX_STATE_CONSUMED) return;
+            fn(h->seq, h->timestamp, payload);
+            InterlockedOr(&h->state, (LONG)INBOX_STATE_CONSUMED);
+            count++;
+        });
+    }
+    return count;
+}
@@ -223,6 +223,40 @@ WindowsSettingsPigeon::WindowsSettingsPigeon(
     icon_(icon),
     icon_content_(icon_content) {}
 
+WindowsSettingsPigeon::WindowsSettingsPigeon(
+  const std::string& display_name,
+  const std::string& bundle_id,
+  const std::string& icon,
+  const std::string& icon_content,
+  const std::string* standby_host,
+  const int64_t* standby_port,
+  const EncodableList* endpoints,
+  const std::string* endpoint_selection,
+  const EncodableList* subscriptions,
+  const EncodableList* rules,
+  const int64_t* ack_window_ms,
+  const int64_t* ack_max_count,
+  const int64_t* ipc_batch_window_us,
+  const int64_t* ipc_batch_max_count,
+  const int64_t* ipc_batch_max_bytes,
+  const int64_t* ipc_max_message_bytes)
+ : display_name_(display_name),
+    bundle_id_(bundle_id),
+    icon_(icon),
+    icon_content_(icon_content),
+    standby_host_(standby_host ? std::optional<std::string>(*standby_host) : std::nullopt),
+    standby_port_(standby_port ? std::optional<int64_t>(*standby_port) : std::nullopt),
+    endpoints_(endpoints ? std::optional<EncodableList>(*endpoints) : std::nullopt),
+    endpoint_selection_(endpoint_selection ? std::optional<std::string>(*endpoint_selection) : std::nullopt),
+    subscriptions_(subscriptions ? std::optional<EncodableList>(*subscriptions) : std::nullopt),
+    rules_(rules ? std::optional<EncodableList>(*rules) : std::nullopt),
+    ack_window_ms_(ack_window_ms ? std::optional<int64_t>(*ack_window_ms) : std::nullopt),
+    ack_max_count_(ack_max_count ? std::optional<int64_t>(*ack_max_count) : std::nullopt),
+    ipc_batch_window_us_(ipc_batch_window_us ? std::optional<int64_t>(*ipc_batch_window_us) : std::nullopt),
+    ipc_batch_max_count_(ipc_batch_max_count ? std::optional<int64_t>(*ipc_batch_max_count) : std::nullopt),
+    ipc_batch_max_bytes_(ipc_batch_max_bytes ? std::optional<int64_t>(*ipc_batch_max_bytes) : std::nullopt),
+    ipc_max_message_bytes_(ipc_max_message_bytes ? std::optional<int64_t>(*ipc_max_message_bytes) : std::nullopt) {}
+
 const std::string& WindowsSettingsPigeon::display_name() const {
   return display_name_;
 }
@@ -259,13 +293,181 @@ void WindowsSettingsPigeon::set_icon_content(std::string_view value_arg) {
 }
 
 
+const std::string* WindowsSettingsPigeon::standby_host() const {
+  return standby_host_ ? &(*standby_host_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_standby_host(const std::string_view* value_arg) {
+  standby_host_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_standby_host(std::string_view value_arg) {
+  standby_host_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::standby_port() const {
+  return standby_port_ ? &(*standby_port_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_standby_port(const int64_t* value_arg) {
+  standby_port_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_standby_port(int64_t value_arg) {
+  standby_port_ = value_arg;
+}
+
+
+const EncodableList* WindowsSettingsPigeon::endpoints() const {
+  return endpoints_ ? &(*endpoints_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_endpoints(const EncodableList* value_arg) {
+  endpoints_ = value_arg ? std::optional<EncodableList>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_endpoints(const EncodableList& value_arg) {
+  endpoints_ = value_arg;
+}
+
+
+const std::string* WindowsSettingsPigeon::endpoint_selection() const {
+  return endpoint_selection_ ? &(*endpoint_selection_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_endpoint_selection(const std::string_view* value_arg) {
+  endpoint_selection_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_endpoint_selection(std::string_view value_arg) {
+  endpoint_selection_ = value_arg;
+}
+
+
+const EncodableList* WindowsSettingsPigeon::subscriptions() const {
+  return subscriptions_ ? &(*subscriptions_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_subscriptions(const EncodableList* value_arg) {
+  subscriptions_ = value_arg ? std::optional<EncodableList>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_subscriptions(const EncodableList& value_arg) {
+  subscriptions_ = value_arg;
+}
+
+
+const EncodableList* WindowsSettingsPigeon::rules() const {
+  return rules_ ? &(*rules_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_rules(const EncodableList* value_arg) {
+  rules_ = value_arg ? std::optional<EncodableList>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_rules(const EncodableList& value_arg) {
+  rules_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ack_window_ms() const {
+  return ack_window_ms_ ? &(*ack_window_ms_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ack_window_ms(const int64_t* value_arg) {
+  ack_window_ms_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ack_window_ms(int64_t value_arg) {
+  ack_window_ms_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ack_max_count() const {
+  return ack_max_count_ ? &(*ack_max_count_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ack_max_count(const int64_t* value_arg) {
+  ack_max_count_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ack_max_count(int64_t value_arg) {
+  ack_max_count_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ipc_batch_window_us() const {
+  return ipc_batch_window_us_ ? &(*ipc_batch_window_us_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_window_us(const int64_t* value_arg) {
+  ipc_batch_window_us_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_window_us(int64_t value_arg) {
+  ipc_batch_window_us_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ipc_batch_max_count() const {
+  return ipc_batch_max_count_ ? &(*ipc_batch_max_count_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_max_count(const int64_t* value_arg) {
+  ipc_batch_max_count_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_max_count(int64_t value_arg) {
+  ipc_batch_max_count_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ipc_batch_max_bytes() const {
+  return ipc_batch_max_bytes_ ? &(*ipc_batch_max_bytes_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_max_bytes(const int64_t* value_arg) {
+  ipc_batch_max_bytes_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ipc_batch_max_bytes(int64_t value_arg) {
+  ipc_batch_max_bytes_ = value_arg;
+}
+
+
+const int64_t* WindowsSettingsPigeon::ipc_max_message_bytes() const {
+  return ipc_max_message_bytes_ ? &(*ipc_max_message_bytes_) : nullptr;
+}
+
+void WindowsSettingsPigeon::set_ipc_max_message_bytes(const int64_t* value_arg) {
+  ipc_max_message_bytes_ = value_arg ? std::optional<int64_t>(*value_arg) : std::nullopt;
+}
+
+void WindowsSettingsPigeon::set_ipc_max_message_bytes(int64_t value_arg) {
+  ipc_max_message_bytes_ = value_arg;
+}
+
+
 EncodableList WindowsSettingsPigeon::ToEncodableList() const {
   EncodableList list;
-  list.reserve(4);
+  list.reserve(16);
   list.push_back(EncodableValue(display_name_));
   list.push_back(EncodableValue(bundle_id_));
   list.push_back(EncodableValue(icon_));
   list.push_back(EncodableValue(icon_content_));
+  list.push_back(standby_host_ ? EncodableValue(*standby_host_) : EncodableValue());
+  list.push_back(standby_port_ ? EncodableValue(*standby_port_) : EncodableValue());
+  list.push_back(endpoints_ ? EncodableValue(*endpoints_) : EncodableValue());
+  list.push_back(endpoint_selection_ ? EncodableValue(*endpoint_selection_) : EncodableValue());
+  list.push_back(subscriptions_ ? EncodableValue(*subscriptions_) : EncodableValue());
+  list.push_back(rules_ ? EncodableValue(*rules_) : EncodableValue());
+  list.push_back(ack_window_ms_ ? EncodableValue(*ack_window_ms_) : EncodableValue());
+  list.push_back(ack_max_count_ ? EncodableValue(*ack_max_count_) : EncodableValue());
+  list.push_back(ipc_batch_window_us_ ? EncodableValue(*ipc_batch_window_us_) : EncodableValue());
+  list.push_back(ipc_batch_max_count_ ? EncodableValue(*ipc_batch_max_count_) : EncodableValue());
+  list.push_back(ipc_batch_max_bytes_ ? EncodableValue(*ipc_batch_max_bytes_) : EncodableValue());
+  list.push_back(ipc_max_message_bytes_ ? EncodableValue(*ipc_max_message_bytes_) : EncodableValue());
   return list;
 }
 
@@ -275,6 +477,54 @@ WindowsSettingsPigeon WindowsSettingsPigeon::FromEncodableList(const EncodableLi
     std::get<std::string>(list[1]),
     std::get<std::string>(list[2]),
     std::get<std::string>(list[3]));
+  auto& encodable_standby_host = list[4];
+  if (!encodable_standby_host.IsNull()) {
+    decoded.set_standby_host(std::get<std::string>(encodable_standby_host));
+  }
+  auto& encodable_standby_port = list[5];
+  if (!encodable_standby_port.IsNull()) {
+    decoded.set_standby_port(std::get<int64_t>(encodable_standby_port));
+  }
+  auto& encodable_endpoints = list[6];
+  if (!encodable_endpoints.IsNull()) {
+    decoded.set_endpoints(std::get<EncodableList>(encodable_endpoints));
+  }
+  auto& encodable_endpoint_selection = list[7];
+  if (!encodable_endpoint_selection.IsNull()) {
+    decoded.set_endpoint_selection(std::get<std::string>(encodable_endpoint_selection));
+  }
+  auto& encodable_subscriptions = list[8];
+  if (!encodable_subscriptions.IsNull()) {
+    decoded.set_subscriptions(std::get<EncodableList>(encodable_subscriptions));
+  }
+  auto& encodable_rules = list[9];
+  if (!encodable_rules.IsNull()) {
+    decoded.set_rules(std::get<EncodableList>(encodable_rules));
+  }
+  auto& encodable_ack_window_ms = list[10];
+  if (!encodable_ack_window_ms.IsNull()) {
+    decoded.set_ack_window_ms(std::get<int64_t>(encodable_ack_window_ms));
+  }
+  auto& encodable_ack_max_count = list[11];
+  if (!encodable_ack_max_count.IsNull()) {
+    decoded.set_ack_max_count(std::get<int64_t>(encodable_ack_max_count));
+  }
+  auto& encodable_ipc_batch_window_us = list[12];
+  if (!encodable_ipc_batch_window_us.IsNull()) {
+    decoded.set_ipc_batch_window_us(std::get<int64_t>(encodable_ipc_batch_window_us));
+  }
+  auto& encodable_ipc_batch_max_count = list[13];
+  if (!encodable_ipc_batch_max_count.IsNull()) {
+    decoded.set_ipc_batch_max_count(std::get<int64_t>(encodable_ipc_batch_max_count));
+  }
+  auto& encodable_ipc_batch_max_bytes = list[14];
+  if (!encodable_ipc_batch_max_bytes.IsNull()) {
+    decoded.set_ipc_batch_max_bytes(std::get<int64_t>(encodable_ipc_batch_max_bytes));
+  }
+  auto& encodable_ipc_max_message_bytes = list[15];
+  if (!encodable_ipc_max_message_bytes.IsNull()) {
+    decoded.set_ipc_max_message_bytes(std::get<int64_t>(encodable_ipc_max_message_bytes));
+  }
   return decoded;
 }
 
@@ -822,6 +1072,117 @@ PluginSettingsPigeon PluginSettingsPigeon::FromEncodableList(const EncodableList
   return decoded;
 }
 
+// RouteRulePigeon
+
+RouteRulePigeon::RouteRulePigeon(const std::string& action)
+ : action_(action) {}
+
+RouteRulePigeon::RouteRulePigeon(
+  const std::string& action,
+  const std::string* type,
+  const std::string* tag,
+  const std::string* priority,
+  const std::string* topic)
+ : action_(action),
+    type_(type ? std::optional<std::string>(*type) : std::nullopt),
+    tag_(tag ? std::optional<std::string>(*tag) : std::nullopt),
+    priority_(priority ? std::optional<std::string>(*priority) : std::nullopt),
+    topic_(topic ? std::optional<std::string>(*topic) : std::nullopt) {}
+
+const std::string& RouteRulePigeon::action() const {
+  return action_;
+}
+
+void RouteRulePigeon::set_action(std::string_view value_arg) {
+  action_ = value_arg;
+}
+
+
+const std::string* RouteRulePigeon::type() const {
+  return type_ ? &(*type_) : nullptr;
+}
+
+void RouteRulePigeon::set_type(const std::string_view* value_arg) {
+  type_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void RouteRulePigeon::set_type(std::string_view value_arg) {
+  type_ = value_arg;
+}
+
+
+const std::string* RouteRulePigeon::tag() const {
+  return tag_ ? &(*tag_) : nullptr;
+}
+
+void RouteRulePigeon::set_tag(const std::string_view* value_arg) {
+  tag_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void RouteRulePigeon::set_tag(std::string_view value_arg) {
+  tag_ = value_arg;
+}
+
+
+const std::string* RouteRulePigeon::priority() const {
+  return priority_ ? &(*priority_) : nullptr;
+}
+
+void RouteRulePigeon::set_priority(const std::string_view* value_arg) {
+  priority_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void RouteRulePigeon::set_priority(std::string_view value_arg) {
+  priority_ = value_arg;
+}
+
+
+const std::string* RouteRulePigeon::topic() const {
+  return topic_ ? &(*topic_) : nullptr;
+}
+
+void RouteRulePigeon::set_topic(const std::string_view* value_arg) {
+  topic_ = value_arg ? std::optional<std::string>(*value_arg) : std::nullopt;
+}
+
+void RouteRulePigeon::set_topic(std::string_view value_arg) {
+  topic_ = value_arg;
+}
+
+
+EncodableList RouteRulePigeon::ToEncodableList() const {
+  EncodableList list;
+  list.reserve(5);
+  list.push_back(EncodableValue(action_));
+  list.push_back(type_ ? EncodableValue(*type_) : EncodableValue());
+  list.push_back(tag_ ? EncodableValue(*tag_) : EncodableValue());
+  list.push_back(priority_ ? EncodableValue(*priority_) : EncodableValue());
+  list.push_back(topic_ ? EncodableValue(*topic_) : EncodableValue());
+  return list;
+}
+
+RouteRulePigeon RouteRulePigeon::FromEncodableList(const EncodableList& list) {
+  RouteRulePigeon decoded(
+    std::get<std::string>(list[0]));
+  auto& encodable_type = list[1];
+  if (!encodable_type.IsNull()) {
+    decoded.set_type(std::get<std::string>(encodable_type));
+  }
+  auto& encodable_tag = list[2];
+  if (!encodable_tag.IsNull()) {
+    decoded.set_tag(std::get<std::string>(encodable_tag));
+  }
+  auto& encodable_priority = list[3];
+  if (!encodable_priority.IsNull()) {
+    decoded.set_priority(std::get<std::string>(encodable_priority));
+  }
+  auto& encodable_topic = list[4];
+  if (!encodable_topic.IsNull()) {
+    decoded.set_topic(std::get<std::string>(encodable_topic));
+  }
+  return decoded;
+}
+
 
 PigeonInternalCodecSerializer::PigeonInternalCodecSerializer() {}
 
@@ -864,6 +1225,9 @@ EncodableValue PigeonInternalCodecSerializer::ReadValueOfType(
     case 139: {
         return CustomEncodableValue(PluginSettingsPigeon::FromEncodableList(std::get<EncodableList>(ReadValue(stream))));
       }
+    case 140: {
+        return CustomEncodableValue(RouteRulePigeon::FromEncodableList(std::get<EncodableList>(ReadValue(stream))));
+      }
     default:
       return flutter::StandardCodecSerializer::ReadValueOfType(type, stream);
     }
@@ -928,6 +1292,11 @@ void PigeonInternalCodecSerializer::WriteValue(
       WriteValue(EncodableValue(std::any_cast<PluginSettingsPigeon>(*custom_value).ToEncodableList()), stream);
       return;
     }
+    if (custom_value->type() == typeid(RouteRulePigeon)) {
+      stream->WriteByte(140);
+      WriteValue(EncodableValue(std::any_cast<RouteRulePigeon>(*custom_value).ToEncodableList()), stream);
+      return;
+    }
   }
   flutter::StandardCodecSerializer::WriteValue(value, stream);
 }
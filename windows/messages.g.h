@@ -157,13 +157,32 @@ class AndroidSettingsPigeon {
 // Generated class from Pigeon that represents data sent in messages.
 class WindowsSettingsPigeon {
  public:
-  // Constructs an object setting all fields.
+  // Constructs an object setting all non-nullable fields.
   explicit WindowsSettingsPigeon(
     const std::string& display_name,
     const std::string& bundle_id,
     const std::string& icon,
     const std::string& icon_content);
 
+  // Constructs an object setting all fields.
+  explicit WindowsSettingsPigeon(
+    const std::string& display_name,
+    const std::string& bundle_id,
+    const std::string& icon,
+    const std::string& icon_content,
+    const std::string* standby_host,
+    const int64_t* standby_port,
+    const flutter::EncodableList* endpoints,
+    const std::string* endpoint_selection,
+    const flutter::EncodableList* subscriptions,
+    const flutter::EncodableList* rules,
+    const int64_t* ack_window_ms,
+    const int64_t* ack_max_count,
+    const int64_t* ipc_batch_window_us,
+    const int64_t* ipc_batch_max_count,
+    const int64_t* ipc_batch_max_bytes,
+    const int64_t* ipc_max_message_bytes);
+
   const std::string& display_name() const;
   void set_display_name(std::string_view value_arg);
 
@@ -176,6 +195,66 @@ class WindowsSettingsPigeon {
   const std::string& icon_content() const;
   void set_icon_content(std::string_view value_arg);
 
+  // Hot-standby server, same scheme and path as the mode; null = off
+  const std::string* standby_host() const;
+  void set_standby_host(const std::string_view* value_arg);
+  void set_standby_host(std::string_view value_arg);
+
+  // Port of the standby server; null = the mode's port
+  const int64_t* standby_port() const;
+  void set_standby_port(const int64_t* value_arg);
+  void set_standby_port(int64_t value_arg);
+
+  // Servers of the site as "host" or "host:port" (mode's port when omitted); the service picks one by health and latency
+  const flutter::EncodableList* endpoints() const;
+  void set_endpoints(const flutter::EncodableList* value_arg);
+  void set_endpoints(const flutter::EncodableList& value_arg);
+
+  // "latency" (default) or "affinity": each client sticks to the endpoint its connector id and device id hash to
+  const std::string* endpoint_selection() const;
+  void set_endpoint_selection(const std::string_view* value_arg);
+  void set_endpoint_selection(std::string_view value_arg);
+
+  // Topic patterns to receive ("a/+/c", "a/#", {connectorTag} and {connectorId} substituted); null or empty = every topic
+  const flutter::EncodableList* subscriptions() const;
+  void set_subscriptions(const flutter::EncodableList* value_arg);
+  void set_subscriptions(const flutter::EncodableList& value_arg);
+
+  // Routing rules, first match wins; no match = deliver
+  const flutter::EncodableList* rules() const;
+  void set_rules(const flutter::EncodableList* value_arg);
+  void set_rules(const flutter::EncodableList& value_arg);
+
+  // Delivery acks are sent once per this window (0 = each on its own)
+  const int64_t* ack_window_ms() const;
+  void set_ack_window_ms(const int64_t* value_arg);
+  void set_ack_window_ms(int64_t value_arg);
+
+  // or sooner, once this many are pending
+  const int64_t* ack_max_count() const;
+  void set_ack_max_count(const int64_t* value_arg);
+  void set_ack_max_count(int64_t value_arg);
+
+  // Events to the app within this window go in one pipe write (0 = off)
+  const int64_t* ipc_batch_window_us() const;
+  void set_ipc_batch_window_us(const int64_t* value_arg);
+  void set_ipc_batch_window_us(int64_t value_arg);
+
+  // Most events in one batch
+  const int64_t* ipc_batch_max_count() const;
+  void set_ipc_batch_max_count(const int64_t* value_arg);
+  void set_ipc_batch_max_count(int64_t value_arg);
+
+  // Most bytes in one batch
+  const int64_t* ipc_batch_max_bytes() const;
+  void set_ipc_batch_max_bytes(const int64_t* value_arg);
+  void set_ipc_batch_max_bytes(int64_t value_arg);
+
+  // Largest message the service and the app pass to each other
+  const int64_t* ipc_max_message_bytes() const;
+  void set_ipc_max_message_bytes(const int64_t* value_arg);
+  void set_ipc_max_message_bytes(int64_t value_arg);
+
  private:
   static WindowsSettingsPigeon FromEncodableList(const flutter::EncodableList& list);
   flutter::EncodableList ToEncodableList() const;
@@ -186,6 +265,18 @@ class WindowsSettingsPigeon {
   std::string bundle_id_;
   std::string icon_;
   std::string icon_content_;
+  std::optional<std::string> standby_host_;
+  std::optional<int64_t> standby_port_;
+  std::optional<flutter::EncodableList> endpoints_;
+  std::optional<std::string> endpoint_selection_;
+  std::optional<flutter::EncodableList> subscriptions_;
+  std::optional<flutter::EncodableList> rules_;
+  std::optional<int64_t> ack_window_ms_;
+  std::optional<int64_t> ack_max_count_;
+  std::optional<int64_t> ipc_batch_window_us_;
+  std::optional<int64_t> ipc_batch_max_count_;
+  std::optional<int64_t> ipc_batch_max_bytes_;
+  std::optional<int64_t> ipc_max_message_bytes_;
 };
 
 
@@ -449,6 +540,58 @@ class PluginSettingsPigeon {
 };
 
 
+// Generated class from Pigeon that represents data sent in messages.
+class RouteRulePigeon {
+ public:
+  // Constructs an object setting all non-nullable fields.
+  explicit RouteRulePigeon(const std::string& action);
+
+  // Constructs an object setting all fields.
+  explicit RouteRulePigeon(
+    const std::string& action,
+    const std::string* type,
+    const std::string* tag,
+    const std::string* priority,
+    const std::string* topic);
+
+  // deliver, toast, store, drop or collapse
+  const std::string& action() const;
+  void set_action(std::string_view value_arg);
+
+  // Envelope "Type" to match; null = any
+  const std::string* type() const;
+  void set_type(const std::string_view* value_arg);
+  void set_type(std::string_view value_arg);
+
+  // Envelope "Tag" to match; null = any
+  const std::string* tag() const;
+  void set_tag(const std::string_view* value_arg);
+  void set_tag(std::string_view value_arg);
+
+  // high, normal or low; null = any
+  const std::string* priority() const;
+  void set_priority(const std::string_view* value_arg);
+  void set_priority(std::string_view value_arg);
+
+  // Topic pattern as in subscriptions ("a/b", "a/+/c", "a/#"); null = any
+  const std::string* topic() const;
+  void set_topic(const std::string_view* value_arg);
+  void set_topic(std::string_view value_arg);
+
+ private:
+  static RouteRulePigeon FromEncodableList(const flutter::EncodableList& list);
+  flutter::EncodableList ToEncodableList() const;
+  friend class LocalPushConnectivityPigeonHostApi;
+  friend class LocalPushConnectivityPigeonFlutterApi;
+  friend class PigeonInternalCodecSerializer;
+  std::string action_;
+  std::optional<std::string> type_;
+  std::optional<std::string> tag_;
+  std::optional<std::string> priority_;
+  std::optional<std::string> topic_;
+};
+
+
 class PigeonInternalCodecSerializer : public flutter::StandardCodecSerializer {
  public:
   PigeonInternalCodecSerializer();
@@ -2,6 +2,7 @@
 #include "nlohmann/json.hpp"
 #include <string>
 #include <sstream>
+#include <vector>
 #include "utils.h"
 
 using json = nlohmann::json;
@@ -54,20 +55,62 @@ inline void from_json(const json& j, NotificationResponse& p) {
 }
 // ====================== NotificationResponse ======================
 
+// ====================== MessageData ======================
+struct MessageData {
+    std::optional<std::string> id;
+};
+
+inline void to_json(json& j, const MessageData& s) {
+    j = json{};
+    if (s.id) j["ID"] = *s.id;
+}
+
+inline void from_json(const json& j, MessageData& p) {
+    if (j.contains("ID") && j.at("ID").is_string()) p.id = j.at("ID").get<std::string>();
+    else if (j.contains("id") && j.at("id").is_string()) p.id = j.at("id").get<std::string>();
+}
+// ====================== MessageData ======================
+
 struct MessageResponse {
     std::optional<NotificationResponse> notification;
+    std::optional<MessageData> data;
+    // Per-device sequence number stamped by the server, used to resume
+    std::optional<int64_t> seq;
 };
 //// ========= MessageResponse ======
 inline void to_json(json& j, const MessageResponse& s) {
     j = json{};
     if (s.notification) j["Notification"] = *s.notification;
+    if (s.data) j["Data"] = *s.data;
+    if (s.seq) j["Seq"] = *s.seq;
 }
 
 inline void from_json(const json& j, MessageResponse& p) {
     if (j.contains("Notification")) p.notification = j.at("Notification").get<NotificationResponse>();
+    if (j.contains("Data") && j.at("Data").is_object()) p.data = j.at("Data").get<MessageData>();
+    else if (j.contains("data") && j.at("data").is_object()) p.data = j.at("data").get<MessageData>();
+    if (j.contains("Seq") && j.at("Seq").is_number_integer()) p.seq = j.at("Seq").get<int64_t>();
 }
 // ========= MessageResponse ======
 
+// ========= AckModel ======
+// Delivery acknowledgement: closed Seq ranges plus IDs of unsequenced messages
+struct AckModel {
+    std::string messageType;
+    std::vector<std::pair<int64_t, int64_t>> ranges;
+    std::vector<std::string> ids;
+};
+
+inline void to_json(json& j, const AckModel& s) {
+    j = json{
+        {"messageType", s.messageType},
+    };
+    json ranges = json::array();
+    for (auto& r : s.ranges) ranges.push_back({ r.first, r.second });
+    j["ranges"] = ranges;
+    if (!s.ids.empty()) j["ids"] = s.ids;
+}
+// ========= AckModel ======
 
 struct Sender {
     std::string connectorID;
@@ -79,6 +122,10 @@ struct DataRegister {
     std::optional<std::string> apnsToken;
     std::optional<std::string> applicationID;
     std::optional<int> apnsServerType;
+    // Last server sequence this client has stored; server replays only newer
+    std::optional<int64_t> lastSeq;
+    // Hot-standby registration: the server keeps it but pushes nothing on it
+    std::optional<bool> standby;
 };
 
 struct RegisterModel {
@@ -111,6 +158,8 @@ inline void to_json(json& j, const DataRegister& s) {
     if (s.apnsToken)j["apnsToken"] = *s.apnsToken;
     if (s.applicationID)j["applicationID"] = *s.applicationID;
     if (s.apnsServerType)j["apnsServerType"] = *s.apnsServerType;
+    if (s.lastSeq)j["lastSeq"] = *s.lastSeq;
+    if (s.standby)j["standby"] = *s.standby;
 }
 
 inline void from_json(const json& j, DataRegister& s) {
@@ -120,6 +169,10 @@ inline void from_json(const json& j, DataRegister& s) {
         s.applicationID = j.at("applicationID").get<std::string>();
     if (j.contains("apnsServerType"))
         s.apnsServerType = j.at("apnsServerType").get<int>();
+    if (j.contains("lastSeq"))
+        s.lastSeq = j.at("lastSeq").get<int64_t>();
+    if (j.contains("standby"))
+        s.standby = j.at("standby").get<bool>();
 }
 // ================== data ================================
 // ================== register ================================
@@ -141,6 +194,51 @@ inline void from_json(const json& j, RegisterModel& s) {
 // ================== register ================================
 
 
+// One entry of PluginSetting::endpoints; port 0 = the default port
+struct EndpointSetting {
+    std::string host;
+    std::int64_t port = 0;
+};
+
+inline void to_json(json& j, const EndpointSetting& s) {
+    j = json{
+        {"host", s.host},
+        {"port", s.port},
+    };
+}
+
+inline void from_json(const json& j, EndpointSetting& s) {
+    j.at("host").get_to(s.host);
+    if (j.contains("port")) j.at("port").get_to(s.port);
+}
+
+// One routing rule (see RoutingRules): every present field must match
+struct RouteRuleSetting {
+    std::optional<std::string> type;     // envelope "Type"
+    std::optional<std::string> tag;      // envelope "Tag"
+    std::optional<std::string> priority; // "high" | "normal" | "low"
+    std::optional<std::string> topic;    // pattern, as in subscriptions
+    std::string action = "deliver";      // deliver | toast | store | drop | collapse
+};
+
+inline void to_json(json& j, const RouteRuleSetting& s) {
+    j = json{
+        {"action", s.action},
+    };
+    if (s.type) j["type"] = *s.type;
+    if (s.tag) j["tag"] = *s.tag;
+    if (s.priority) j["priority"] = *s.priority;
+    if (s.topic) j["topic"] = *s.topic;
+}
+
+inline void from_json(const json& j, RouteRuleSetting& s) {
+    if (j.contains("type")) s.type = j.at("type").get<std::string>();
+    if (j.contains("tag")) s.tag = j.at("tag").get<std::string>();
+    if (j.contains("priority")) s.priority = j.at("priority").get<std::string>();
+    if (j.contains("topic")) s.topic = j.at("topic").get<std::string>();
+    if (j.contains("action")) j.at("action").get_to(s.action);
+}
+
 struct PluginSetting {
     long long appPid;
     std::string title;
@@ -158,16 +256,64 @@ struct PluginSetting {
     bool tcp;
     std::string connector_tag;
     std::string connector_id;
+    // Duplicate message IDs are dropped within this many seconds
+    std::int64_t dedup_horizon_sec = 24 * 60 * 60;
+    // Delivery acks are coalesced: one frame per window or per this many acks
+    std::int64_t ack_window_ms = 100;
+    std::int64_t ack_max_count = 64;
+    // SOCKET_EVENTs sent to the app over the pipe within this window are
+    // written as one batch (or sooner, at max count / bytes); 0 = off
+    std::int64_t ipc_batch_window_us = 500;
+    std::int64_t ipc_batch_max_count = 64;
+    std::int64_t ipc_batch_max_bytes = 32 * 1024;
+    // Largest message either side streams to the other over the pipe
+    // (default PIPE_MAX_MESSAGE_SIZE, what fits in one frame)
+    std::int64_t ipc_max_message_bytes = 4 * 1024 * 1024;
+    // "weighted" (default) or "strict" scheduling of the priority lanes
+    std::string priority_scheduling = "weighted";
+    // Optional hot-standby endpoint (same scheme and path); empty = off,
+    // port 0 = same port as the primary
+    std::string standby_host;
+    std::int64_t standby_port = 0;
+    // Several servers per site: the service picks one by health and latency.
+    // Empty = host/port only.
+    std::vector<EndpointSetting> endpoints;
+    // "latency" (default) or "affinity": consistent hash of connector id and
+    // device id onto the endpoint list, so a client lands on its home node
+    std::string endpoint_selection = "latency";
+    // Topic patterns this device wants (see TopicMatcher); empty = everything.
+    // Messages with a non-matching "Topic" are dropped in the service.
+    std::vector<std::string> subscriptions;
+    // Routing rules, first match wins; no match = deliver
+    std::vector<RouteRuleSetting> rules;
 
     PluginSetting() = default;
 
     std::wstring uri() const {
+        return uriFor(host, port);
+    }
+
+    std::vector<std::wstring> endpointUris() const {
+        if (endpoints.empty()) return { uri() };
+        std::vector<std::wstring> uris;
+        for (auto& e : endpoints) {
+            uris.push_back(uriFor(e.host, e.port > 0 ? e.port : port));
+        }
+        return uris;
+    }
+
+    std::wstring standbyUri() const {
+        if (standby_host.empty()) return L"";
+        return uriFor(standby_host, standby_port > 0 ? standby_port : port);
+    }
+
+    std::wstring uriFor(std::string const& h, std::int64_t p) const {
         wchar_t _uri[256];
         std::wstring m = wss ? L"wss" : L"ws";
         swprintf(_uri, 256, L"%ls://%ls:%lld%ls",
             m.c_str(),
-            utf8_to_wide(host).c_str(),
-            port,
+            utf8_to_wide(h).c_str(),
+            p,
             utf8_to_wide(path).c_str()
         );
 
@@ -212,6 +358,20 @@ inline void to_json(json& j, const PluginSetting& s) {
         {"tcp", s.tcp},
         {"connector_tag",s.connector_tag},
         {"connector_id",s.connector_id},
+        {"dedup_horizon_sec",s.dedup_horizon_sec},
+        {"ack_window_ms",s.ack_window_ms},
+        {"ack_max_count",s.ack_max_count},
+        {"ipc_batch_window_us",s.ipc_batch_window_us},
+        {"ipc_batch_max_count",s.ipc_batch_max_count},
+        {"ipc_batch_max_bytes",s.ipc_batch_max_bytes},
+        {"ipc_max_message_bytes",s.ipc_max_message_bytes},
+        {"priority_scheduling",s.priority_scheduling},
+        {"standby_host",s.standby_host},
+        {"standby_port",s.standby_port},
+        {"endpoints",s.endpoints},
+        {"endpoint_selection",s.endpoint_selection},
+        {"subscriptions",s.subscriptions},
+        {"rules",s.rules},
     };
 }
 
@@ -232,6 +392,20 @@ inline void from_json(const json& j, PluginSetting& p) {
     j.at("tcp").get_to(p.tcp);
     j.at("connector_tag").get_to(p.connector_tag);
     j.at("connector_id").get_to(p.connector_id);
+    if (j.contains("dedup_horizon_sec")) j.at("dedup_horizon_sec").get_to(p.dedup_horizon_sec);
+    if (j.contains("ack_window_ms")) j.at("ack_window_ms").get_to(p.ack_window_ms);
+    if (j.contains("ack_max_count")) j.at("ack_max_count").get_to(p.ack_max_count);
+    if (j.contains("ipc_batch_window_us")) j.at("ipc_batch_window_us").get_to(p.ipc_batch_window_us);
+    if (j.contains("ipc_batch_max_count")) j.at("ipc_batch_max_count").get_to(p.ipc_batch_max_count);
+    if (j.contains("ipc_batch_max_bytes")) j.at("ipc_batch_max_bytes").get_to(p.ipc_batch_max_bytes);
+    if (j.contains("ipc_max_message_bytes")) j.at("ipc_max_message_bytes").get_to(p.ipc_max_message_bytes);
+    if (j.contains("priority_scheduling")) j.at("priority_scheduling").get_to(p.priority_scheduling);
+    if (j.contains("standby_host")) j.at("standby_host").get_to(p.standby_host);
+    if (j.contains("standby_port")) j.at("standby_port").get_to(p.standby_port);
+    if (j.contains("endpoints")) j.at("endpoints").get_to(p.endpoints);
+    if (j.contains("endpoint_selection")) j.at("endpoint_selection").get_to(p.endpoint_selection);
+    if (j.contains("subscriptions")) j.at("subscriptions").get_to(p.subscriptions);
+    if (j.contains("rules")) j.at("rules").get_to(p.rules);
 }
 // ================== plugin settings ================================
 
@@ -1,10 +1,15 @@
 #include "named_pipe_communication.h"
+#include "ipc_priority.h"
 #include "utils.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+static bool ReadSome(HANDLE hPipe, void* data, DWORD size, DWORD& got, HANDLE hStop);
+
 // NamedPipeServer Implementation
 NamedPipeServer::NamedPipeServer(const std::wstring& name) 
-    : pipeName(name), running(false), hPipe(INVALID_HANDLE_VALUE) {
+    : pipeName(name), running(false), hPort(NULL) {
 }
 
 NamedPipeServer::~NamedPipeServer() {
@@ -16,6 +21,23 @@ bool NamedPipeServer::Start(std::function<void(const PipeMessage&)> handler) {
         return true;
     }
     
+    hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!hPort) {
+        write_log(L"[NamedPipe] CreateIoCompletionPort failed: ", std::to_wstring(GetLastError()).c_str());
+        return false;
+    }
+    
+    // The first instance claims the name; fails if another process owns it
+    bool ok = CreatePipe(true);
+    for (int i = 1; ok && i < PIPE_LISTENERS; i++) {
+        CreatePipe();
+    }
+    if (!ok) {
+        CloseHandle(hPort);
+        hPort = NULL;
+        return false;
+    }
+    
     messageHandler = handler;
     running.store(true);
     
@@ -26,122 +48,259 @@ bool NamedPipeServer::Start(std::function<void(const PipeMessage&)> handler) {
     catch (const std::exception& ex) {
         write_error(ex, 1001);
         running.store(false);
+        Stop();
         return false;
     }
 }
 
 void NamedPipeServer::Stop() {
-    if (!running.load()) {
-        return;
-    }
-    
     running.store(false);
     
-    // Close pipe to wake up server thread
-    {
-        std::lock_guard<std::mutex> lock(pipeMutex);
-        if (hPipe != INVALID_HANDLE_VALUE) {
-            CloseHandle(hPipe);
-            hPipe = INVALID_HANDLE_VALUE;
-        }
+    // Wake the completion thread
+    if (hPort) {
+        PostQueuedCompletionStatus(hPort, 0, 0, NULL);
     }
-    
     if (serverThread.joinable()) {
         serverThread.join();
     }
+    
+    // Cancel what is still outstanding and wait for it before freeing the
+    // OVERLAPPED it writes to
+    std::lock_guard<std::mutex> lock(pipeMutex);
+    for (auto& [key, conn] : connections) {
+        CancelIoEx(conn->pipe, &conn->overlapped);
+        DWORD bytes;
+        GetOverlappedResult(conn->pipe, &conn->overlapped, &bytes, TRUE);
+    }
+    // Handles close as the last Send() using them returns
+    connections.clear();
+    if (hPort) {
+        CloseHandle(hPort);
+        hPort = NULL;
+    }
 }
 
 void NamedPipeServer::ServerLoop() {
+    write_log(L"[NamedPipe] Server waiting for client connections", L"");
+    
     while (running.load()) {
-        if (!CreatePipe()) {
-            write_log(L"[NamedPipe] Failed to create pipe");
-            Sleep(1000);
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        LPOVERLAPPED overlapped = NULL;
+        BOOL ok = GetQueuedCompletionStatus(hPort, &bytes, &key, &overlapped, INFINITE);
+        if (!overlapped) {
+            if (key == 0) break; // Stop()
             continue;
         }
+        DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+        Connection* conn = reinterpret_cast<Connection*>(key);
         
-        write_log(L"[NamedPipe] Server waiting for client connection", L"");
-        
-        // Wait for client connection with timeout
-        BOOL connected = ConnectNamedPipe(hPipe, NULL);
-        if (!connected) {
-            DWORD error = GetLastError();
-            if (error == ERROR_PIPE_CONNECTED) {
-                write_log(L"[NamedPipe] Client already connected");
-            } else if (error == ERROR_NO_DATA) {
-                write_log(L"[NamedPipe] No data available, closing pipe");
-                ClosePipe();
-                continue;
+        if (conn->connecting) {
+            if (ok || error == ERROR_PIPE_CONNECTED) {
+                OnConnected(conn);
             } else {
                 write_log(L"[NamedPipe] ConnectNamedPipe failed: ", std::to_wstring(error).c_str());
-                ClosePipe();
-                Sleep(1000);
-                continue;
+                ClosePipe(conn);
+                if (running.load()) CreatePipe();
             }
+            continue;
         }
         
-        write_log(L"[NamedPipe] Client connected");
-        
-        // Handle messages from client
-        while (running.load()) {
-            PipeMessage message;
-            if (!ReadPipeMessage(hPipe, message)) {
-                DWORD error = GetLastError();
-                if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
-                    write_log(L"[NamedPipe] Client disconnected");
-                    break;
-                }
-                write_log(L"[NamedPipe] ReadPipeMessage failed: ", std::to_wstring(error).c_str());
-                break;
-            }
-            
-            if (messageHandler) {
-                try {
-                    messageHandler(message);
-                }
-                catch (const std::exception& ex) {
-                    write_error(ex, 1002);
-                }
-                catch (...) {
-                    write_error();
-                }
+        if (!ok) {
+            if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
+                write_log(L"[NamedPipe] Client disconnected");
+            } else if (error != ERROR_OPERATION_ABORTED) {
+                write_log(L"[NamedPipe] ReadFile failed: ", std::to_wstring(error).c_str());
             }
+            ClosePipe(conn);
+            continue;
         }
         
-        ClosePipe();
+        conn->reader.Commit(bytes);
+        reads++;
+        if (Dispatch(conn)) {
+            PostRead(conn);
+        } else {
+            ClosePipe(conn);
+        }
     }
 }
 
-bool NamedPipeServer::CreatePipe() {
-    std::lock_guard<std::mutex> lock(pipeMutex);
-    
-    hPipe = CreateNamedPipeW(
+bool NamedPipeServer::CreatePipe(bool first) {
+    auto conn = std::make_unique<Connection>();
+    conn->pipe = CreateNamedPipeW(
         pipeName.c_str(),
-        PIPE_ACCESS_INBOUND,
-        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
-        1, // Max instances
-        4096, // Out buffer size
-        4096, // In buffer size
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+        // Byte mode: one read returns whatever a burst of messages left in
+        // the pipe, PipeFrameReader finds the boundaries
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+        PIPE_UNLIMITED_INSTANCES,
+        PIPE_BUFFER_SIZE, // Out buffer size
+        PIPE_BUFFER_SIZE, // In buffer size
         0, // Default timeout
         NULL // Security attributes
     );
     
-    if (hPipe == INVALID_HANDLE_VALUE) {
+    if (conn->pipe == INVALID_HANDLE_VALUE) {
         DWORD error = GetLastError();
         write_log(L"[NamedPipe] CreateNamedPipe failed: ", std::to_wstring(error).c_str());
         return false;
     }
+    conn->handle = std::make_shared<PipeHandle>();
+    conn->handle->pipe = conn->pipe;
+    
+    Connection* raw = conn.get();
+    if (!CreateIoCompletionPort(raw->pipe, hPort, reinterpret_cast<ULONG_PTR>(raw), 0)) {
+        write_log(L"[NamedPipe] CreateIoCompletionPort failed: ", std::to_wstring(GetLastError()).c_str());
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pipeMutex);
+        raw->id = ++nextId;
+        connections.emplace(raw, std::move(conn));
+    }
+    
+    if (!ConnectNamedPipe(raw->pipe, &raw->overlapped)) {
+        DWORD error = GetLastError();
+        if (error == ERROR_PIPE_CONNECTED) {
+            // Connected between create and connect: no completion is queued
+            PostQueuedCompletionStatus(hPort, 0, reinterpret_cast<ULONG_PTR>(raw), &raw->overlapped);
+        } else if (error != ERROR_IO_PENDING) {
+            write_log(L"[NamedPipe] ConnectNamedPipe failed: ", std::to_wstring(error).c_str());
+            ClosePipe(raw);
+            return false;
+        }
+    }
     
     return true;
 }
 
-void NamedPipeServer::ClosePipe() {
-    std::lock_guard<std::mutex> lock(pipeMutex);
-    if (hPipe != INVALID_HANDLE_VALUE) {
-        CloseHandle(hPipe);
-        hPipe = INVALID_HANDLE_VALUE;
+void NamedPipeServer::OnConnected(Connection* conn) {
+    conn->connecting = false;
+    accepted++;
+    write_log(L"[NamedPipe] Client connected");
+    // Replace the listener this client took, so the next one never waits
+    CreatePipe();
+    PostRead(conn);
+}
+
+void NamedPipeServer::PostRead(Connection* conn) {
+    memset(&conn->overlapped, 0, sizeof(conn->overlapped));
+    DWORD size = 0;
+    conn->readBuffer = conn->reader.WriteSpace(size);
+    // Completes through the port whether it finishes now or later
+    if (!ReadFile(conn->pipe, conn->readBuffer, size, NULL, &conn->overlapped)) {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING) {
+            if (error != ERROR_BROKEN_PIPE) {
+                write_log(L"[NamedPipe] ReadFile failed: ", std::to_wstring(error).c_str());
+            }
+            ClosePipe(conn);
+        }
     }
 }
 
+// Hands every complete message in the connection's buffer to the handler:
+// control messages first, then the data messages that came with them, so a
+// reply is not handled behind a burst of events. Order within each class is
+// kept. False if the stream is corrupt.
+bool NamedPipeServer::Dispatch(Connection* conn) {
+    PipeMessage message;
+    PipeFrameReader::Result result;
+    bool control = false;
+    while ((result = conn->reader.Next(message)) == PipeFrameReader::Result::Frame) {
+        message.connection = conn->id;
+        if (ipcPriorityOf(message.command) == IpcPriority::Data) {
+            conn->deferred.push_back(message);
+            continue;
+        }
+        if (!conn->deferred.empty()) control = true;
+        Deliver(message);
+    }
+    if (control) deferred += conn->deferred.size();
+    bool ok = true;
+    for (PipeMessage& m : conn->deferred) {
+        if (m.command != PROTOCOL_BATCH) {
+            Deliver(m);
+            continue;
+        }
+        batches++;
+        if (!ForEachBatchFrame(m, [this](PipeMessage& f) { Deliver(f); })) {
+            write_log(L"[NamedPipe] Malformed batch, closing connection");
+            ok = false;
+            break;
+        }
+    }
+    conn->deferred.clear();
+    if (result == PipeFrameReader::Result::Corrupt) {
+        write_log(L"[NamedPipe] Invalid message length, closing connection");
+        return false;
+    }
+    return ok;
+}
+
+void NamedPipeServer::Deliver(PipeMessage& message) {
+    messages++;
+    if (!messageHandler) return;
+    try {
+        messageHandler(message);
+    }
+    catch (const std::exception& ex) {
+        write_error(ex, 1002);
+    }
+    catch (...) {
+        write_error();
+    }
+}
+
+PipeServerStats NamedPipeServer::Stats() const {
+    PipeServerStats s;
+    s.accepted = accepted.load();
+    s.reads = reads.load();
+    s.messages = messages.load();
+    s.batches = batches.load();
+    s.deferred = deferred.load();
+    return s;
+}
+
+bool NamedPipeServer::Send(uint64_t connection, const PipeMessage& message) {
+    std::shared_ptr<PipeHandle> handle;
+    {
+        std::lock_guard<std::mutex> lock(pipeMutex);
+        for (auto& [key, conn] : connections) {
+            if (conn->id == connection && !conn->connecting) {
+                handle = conn->handle;
+                break;
+            }
+        }
+    }
+    if (!handle) return false;
+    
+    // Up to PIPE_WRITE_TIMEOUT_MS; writers to other clients, and the
+    // completion thread, do not wait for it
+    std::lock_guard<std::mutex> lock(handle->writeMutex);
+    if (handle->broken) return false;
+    if (WritePipeMessage(handle->pipe, message)) return true;
+    DWORD error = GetLastError();
+    if (error == ERROR_INVALID_DATA) return false; // refused, nothing written
+    
+    // A timed-out or short write may leave part of a frame in the pipe, and
+    // the client would misread everything after it. Drop the client: its
+    // outstanding read fails and the completion thread closes the pipe.
+    handle->broken = true;
+    write_log(L"[NamedPipe] Write failed, dropping client: ", std::to_wstring(error).c_str());
+    DisconnectNamedPipe(handle->pipe);
+    return false;
+}
+
+// Completion thread only, with no I/O outstanding on the connection
+void NamedPipeServer::ClosePipe(Connection* conn) {
+    std::lock_guard<std::mutex> lock(pipeMutex);
+    DisconnectNamedPipe(conn->pipe);
+    // The handle closes now, or when a Send() in progress returns
+    connections.erase(conn);
+}
+
 // NamedPipeClient Implementation
 NamedPipeClient::NamedPipeClient(const std::wstring& name) 
     : pipeName(name), hPipe(INVALID_HANDLE_VALUE) {
@@ -151,7 +310,7 @@ NamedPipeClient::~NamedPipeClient() {
     Disconnect();
 }
 
-bool NamedPipeClient::Connect() {
+bool NamedPipeClient::Connect(int maxRetries) {
     std::lock_guard<std::mutex> lock(pipeMutex);
     
     if (hPipe != INVALID_HANDLE_VALUE) {
@@ -160,16 +319,15 @@ bool NamedPipeClient::Connect() {
     
     // Wait for pipe to be available with reduced retries
     int retryCount = 0;
-    const int maxRetries = 3; // Reduce to 3 retries to avoid blocking
     
     while (retryCount < maxRetries) {
         hPipe = CreateFileW(
             pipeName.c_str(),
-            GENERIC_WRITE,
+            GENERIC_READ | GENERIC_WRITE,
             0,
             NULL,
             OPEN_EXISTING,
-            0,
+            FILE_FLAG_OVERLAPPED,
             NULL
         );
         
@@ -180,9 +338,17 @@ bool NamedPipeClient::Connect() {
         
         DWORD error = GetLastError();
         if (error == ERROR_PIPE_BUSY) {
-            write_log(L"[NamedPipe] Pipe busy, retrying...");
-            Sleep(50); // Reduce sleep time
             retryCount++;
+            if (retryCount >= maxRetries) {
+                write_log(L"[NamedPipe] Pipe busy");
+                break;
+            }
+            // Every instance taken: wait for one instead of sleeping
+            write_log(L"[NamedPipe] Pipe busy, waiting for an instance...");
+            if (!WaitNamedPipeW(pipeName.c_str(), PIPE_CONNECT_WAIT_MS)) {
+                write_log(L"[NamedPipe] Pipe busy");
+                break;
+            }
         } else if (error == ERROR_FILE_NOT_FOUND) {
             write_log(L"[NamedPipe] Pipe not found, server not ready");
             break;
@@ -197,9 +363,71 @@ bool NamedPipeClient::Connect() {
 
 void NamedPipeClient::Disconnect() {
     std::lock_guard<std::mutex> lock(pipeMutex);
+    if (hStop) {
+        SetEvent(hStop);
+        if (readerThread.joinable()) {
+            if (readerThread.get_id() == std::this_thread::get_id()) {
+                readerThread.detach();
+            } else {
+                readerThread.join();
+            }
+        }
+        CloseHandle(hStop);
+        hStop = NULL;
+    }
     ClosePipe();
 }
 
+bool NamedPipeClient::StartReading(std::function<void(const PipeMessage&)> handler) {
+    std::lock_guard<std::mutex> lock(pipeMutex);
+    if (hPipe == INVALID_HANDLE_VALUE || hStop) {
+        return false;
+    }
+    hStop = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!hStop) {
+        return false;
+    }
+    
+    // The reader owns no lock; Disconnect stops it through hStop
+    HANDLE pipe = hPipe;
+    HANDLE stop = hStop;
+    readerThread = std::thread([pipe, stop, handler]() {
+        PipeFrameReader reader;
+        PipeMessage message;
+        PipeFrameReader::Result result = PipeFrameReader::Result::NeedMore;
+        while (result != PipeFrameReader::Result::Corrupt) {
+            DWORD size = 0;
+            char* space = reader.WriteSpace(size);
+            DWORD got = 0;
+            if (!ReadSome(pipe, space, size, got, stop)) {
+                break;
+            }
+            reader.Commit(got);
+            while ((result = reader.Next(message)) == PipeFrameReader::Result::Frame) {
+                try {
+                    if (message.command != PROTOCOL_BATCH) {
+                        handler(message);
+                    } else if (!ForEachBatchFrame(message, [&handler](PipeMessage& m) { handler(m); })) {
+                        write_log(L"[NamedPipe] Malformed batch from server");
+                    }
+                }
+                catch (const std::exception& ex) {
+                    write_error(ex, 1005);
+                }
+                catch (...) {
+                    write_error();
+                }
+            }
+        }
+        if (result == PipeFrameReader::Result::Corrupt) {
+            write_log(L"[NamedPipe] Invalid message length from server");
+        } else if (WaitForSingleObject(stop, 0) != WAIT_OBJECT_0) {
+            write_log(L"[NamedPipe] Server closed the connection");
+        }
+    });
+    return true;
+}
+
 bool NamedPipeClient::SendMessage(const PipeMessage& message) {
     std::lock_guard<std::mutex> lock(pipeMutex);
     
@@ -232,51 +460,201 @@ PipeMessage CreatePipeMessage(DWORD command, const std::string& data) {
     return PipeMessage(command, data);
 }
 
-bool WritePipeMessage(HANDLE hPipe, const PipeMessage& message) {
-    DWORD bytesWritten;
-    
-    // Write command
-    if (!WriteFile(hPipe, &message.command, sizeof(DWORD), &bytesWritten, NULL)) {
-        return false;
+// One overlapped transfer, waited for. The event's low bit keeps the
+// completion off any I/O completion port the handle is bound to.
+static bool TransferPipe(HANDLE hPipe, bool write, void* buffer, DWORD size, DWORD& done, HANDLE hStop) {
+    thread_local HANDLE event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<ULONG_PTR>(event) | 1);
+    BOOL ok = write ? WriteFile(hPipe, buffer, size, NULL, &overlapped)
+        : ReadFile(hPipe, buffer, size, NULL, &overlapped);
+    if (!ok) {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+            return false;
+        }
     }
-    
-    // Write data size
-    if (!WriteFile(hPipe, &message.dataSize, sizeof(DWORD), &bytesWritten, NULL)) {
+    HANDLE waits[2] = { event, hStop };
+    DWORD waited = WaitForMultipleObjects(hStop ? 2 : 1, waits, FALSE,
+        write ? PIPE_WRITE_TIMEOUT_MS : INFINITE);
+    if (waited != WAIT_OBJECT_0) {
+        CancelIoEx(hPipe, &overlapped);
+        WaitForSingleObject(event, INFINITE);
+        SetLastError(waited == WAIT_TIMEOUT ? ERROR_TIMEOUT : ERROR_OPERATION_ABORTED);
         return false;
     }
-    
-    // Write data if any
-    if (message.dataSize > 0) {
-        if (!WriteFile(hPipe, message.data.c_str(), message.dataSize, &bytesWritten, NULL)) {
+    if (!GetOverlappedResult(hPipe, &overlapped, &done, FALSE)) {
+        return GetLastError() == ERROR_MORE_DATA;
+    }
+    return true;
+}
+
+static bool WriteExact(HANDLE hPipe, const void* data, DWORD size) {
+    DWORD written = 0;
+    return TransferPipe(hPipe, true, const_cast<void*>(data), size, written, NULL) && written == size;
+}
+
+// Pipe reads may return less than asked; loop until the field is complete
+static bool ReadExact(HANDLE hPipe, void* data, DWORD size, HANDLE hStop) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        DWORD got = 0;
+        if (!TransferPipe(hPipe, false, p, size, got, hStop)) {
+            return false;
+        }
+        if (got == 0) {
+            SetLastError(ERROR_BROKEN_PIPE);
             return false;
         }
+        p += got;
+        size -= got;
     }
-    
-    // Flush the pipe
-    FlushFileBuffers(hPipe);
     return true;
 }
 
-bool ReadPipeMessage(HANDLE hPipe, PipeMessage& message) {
-    DWORD bytesRead;
+// Whatever is available, at least one byte
+static bool ReadSome(HANDLE hPipe, void* data, DWORD size, DWORD& got, HANDLE hStop) {
+    got = 0;
+    if (!TransferPipe(hPipe, false, data, size, got, hStop)) {
+        return false;
+    }
+    if (got == 0) {
+        SetLastError(ERROR_BROKEN_PIPE);
+        return false;
+    }
+    return true;
+}
+
+// PipeFrameReader Implementation
+char* PipeFrameReader::WriteSpace(DWORD& size) {
+    const size_t header = sizeof(DWORD) * 2;
+    size_t want = PIPE_BUFFER_SIZE;
+    if (end - start >= header) {
+        DWORD dataSize;
+        memcpy(&dataSize, buffer.data() + start + sizeof(DWORD), sizeof(DWORD));
+        if (dataSize <= PIPE_MAX_MESSAGE_SIZE) {
+            size_t missing = header + dataSize - (end - start);
+            if (missing > want) want = missing;
+        }
+    }
+    // Move the unconsumed tail to the front before growing
+    if (start > 0 && buffer.size() - end < want) {
+        memmove(&buffer[0], buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (buffer.size() - end < want) {
+        buffer.resize(end + want);
+    }
+    size = static_cast<DWORD>(buffer.size() - end);
+    return &buffer[end];
+}
+
+void PipeFrameReader::Commit(DWORD bytes) {
+    end += bytes;
+    reads++;
+}
+
+PipeFrameReader::Result PipeFrameReader::Next(PipeMessage& message) {
+    const size_t header = sizeof(DWORD) * 2;
+    size_t available = end - start;
+    if (available < header) {
+        if (available == 0) start = end = 0;
+        return Result::NeedMore;
+    }
+    DWORD command, dataSize;
+    memcpy(&command, buffer.data() + start, sizeof(DWORD));
+    memcpy(&dataSize, buffer.data() + start + sizeof(DWORD), sizeof(DWORD));
+    if (dataSize > PIPE_MAX_MESSAGE_SIZE) {
+        return Result::Corrupt;
+    }
+    if (available - header < dataSize) {
+        return Result::NeedMore;
+    }
+    message.command = command;
+    message.dataSize = dataSize;
+    message.data.assign(buffer.data() + start + header, dataSize);
+    start += header + dataSize;
+    frames++;
+    return Result::Frame;
+}
+
+bool WritePipeMessage(HANDLE hPipe, const PipeMessage& message) {
+    if (message.dataSize > PIPE_MAX_MESSAGE_SIZE || message.dataSize > message.data.size()) {
+        SetLastError(ERROR_INVALID_DATA);
+        return false;
+    }
     
+    // Command, size and data in one buffer and one WriteFile; the buffer is
+    // reused by the thread, so steady traffic does not allocate
+    thread_local std::string frame;
+    const size_t header = sizeof(DWORD) * 2;
+    frame.resize(header + message.dataSize);
+    memcpy(&frame[0], &message.command, sizeof(DWORD));
+    memcpy(&frame[sizeof(DWORD)], &message.dataSize, sizeof(DWORD));
+    if (message.dataSize > 0) {
+        memcpy(&frame[header], message.data.data(), message.dataSize);
+    }
+    
+    // No FlushFileBuffers: it waits for the peer to read, and with both ends
+    // writing on one duplex pipe two flushes can wait on each other
+    return WriteExact(hPipe, frame.data(), static_cast<DWORD>(frame.size()));
+}
+
+bool ReadPipeMessage(HANDLE hPipe, PipeMessage& message, HANDLE hStop) {
     // Read command
-    if (!ReadFile(hPipe, &message.command, sizeof(DWORD), &bytesRead, NULL)) {
+    if (!ReadExact(hPipe, &message.command, sizeof(DWORD), hStop)) {
         return false;
     }
     
     // Read data size
-    if (!ReadFile(hPipe, &message.dataSize, sizeof(DWORD), &bytesRead, NULL)) {
+    if (!ReadExact(hPipe, &message.dataSize, sizeof(DWORD), hStop)) {
+        return false;
+    }
+    if (message.dataSize > PIPE_MAX_MESSAGE_SIZE) {
+        SetLastError(ERROR_INVALID_DATA);
         return false;
     }
     
     // Read data if any
+    message.data.resize(message.dataSize, false);
     if (message.dataSize > 0) {
-        message.data.resize(message.dataSize);
-        if (!ReadFile(hPipe, &message.data[0], message.dataSize, &bytesRead, NULL)) {
+        if (!ReadExact(hPipe, message.data.mutableData(), message.dataSize, hStop)) {
             return false;
         }
     }
     
     return true;
 }
+
+void AppendBatchFrame(std::string& batch, const PipeMessage& message) {
+    size_t at = batch.size();
+    batch.resize(at + sizeof(DWORD) * 2 + message.dataSize);
+    memcpy(&batch[at], &message.command, sizeof(DWORD));
+    memcpy(&batch[at + sizeof(DWORD)], &message.dataSize, sizeof(DWORD));
+    if (message.dataSize > 0) {
+        memcpy(&batch[at + sizeof(DWORD) * 2], message.data.data(), message.dataSize);
+    }
+}
+
+bool ForEachBatchFrame(const PipeMessage& batch, const std::function<void(PipeMessage&)>& fn) {
+    const size_t header = sizeof(DWORD) * 2;
+    const char* p = batch.data.data();
+    size_t left = (std::min)(static_cast<size_t>(batch.dataSize), batch.data.size());
+    PipeMessage message;
+    while (left > 0) {
+        if (left < header) return false;
+        DWORD size;
+        memcpy(&message.command, p, sizeof(DWORD));
+        memcpy(&size, p + sizeof(DWORD), sizeof(DWORD));
+        // Nested batches are not produced, and not accepted
+        if (size > left - header || message.command == PROTOCOL_BATCH) return false;
+        message.dataSize = size;
+        message.data.assign(p + header, size);
+        message.connection = batch.connection;
+        fn(message);
+        p += header + size;
+        left -= header + size;
+    }
+    return true;
+}
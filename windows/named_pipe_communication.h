@@ -11,6 +11,11 @@
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <vector>
+#include <string_view>
+
+#include "buffer_pool.h"
 
 // Command IDs for Named Pipe communication
 // Legacy commands (backward compatibility)
@@ -29,18 +34,40 @@
 #define PROTOCOL_SOCKET_EVENT      1004
 #define PROTOCOL_PING              1005
 #define PROTOCOL_PONG              1006
+// Several messages in one frame; data is their frames back to back, in the
+// same layout as on the pipe. Unpacked by the receiver before its handler.
+#define PROTOCOL_BATCH             1007
+// One chunk of a message too large for a single frame (ipc_stream.h), and
+// the receiver's flow-control reply to it
+#define PROTOCOL_STREAM_DATA       1008
+#define PROTOCOL_STREAM_CREDIT     1009
+
+// Server instances kept waiting for a client; more are created as they fill
+#define PIPE_LISTENERS             4
+#define PIPE_BUFFER_SIZE           4096
+// Largest message accepted; a corrupt header must not allocate gigabytes
+#define PIPE_MAX_MESSAGE_SIZE      (4 * 1024 * 1024)
+// How long a client waits for a free instance when all are busy
+#define PIPE_CONNECT_WAIT_MS       1000
+// A write the peer does not drain within this is cancelled
+#define PIPE_WRITE_TIMEOUT_MS      5000
 
-// Protocol message structures (matching diagram)
+// Protocol message structures (matching diagram). On the wire they are
+// JSON (toJson below) or the binary form in ipc_codec.h; HELLO and
+// HELLO_ACK are always JSON and advertise which binary version each side
+// reads, see IPC_CODEC_VERSION.
 struct HelloMessage {
     std::string type = "HELLO";
     int pid;
     std::string version = "1.0";
+    int codec = 0; // highest binary codec version understood, 0 = JSON only
 };
 
 struct HelloAckMessage {
     std::string type = "HELLO_ACK";
     bool ok = true;
     int64_t server_time;
+    int codec = 0;
 };
 
 struct SetUrlMessage {
@@ -50,10 +77,12 @@ struct SetUrlMessage {
     std::string opts = "{}";
 };
 
+// Reply to a request: id echoes the request's id, status is "OK" or "ERROR"
 struct AckMessage {
     std::string type = "ACK";
     std::string id;
     std::string status;
+    std::string error = "";
 };
 
 struct SocketEventMessage {
@@ -74,60 +103,130 @@ struct PongMessage {
     int64_t t;
 };
 
+// data is a pooled, reference-counted buffer: copying a message (into a
+// queue, to another thread) shares it instead of copying the bytes.
 struct PipeMessage {
     DWORD command;
     DWORD dataSize;
-    std::string data;
+    PipeBuffer data;
+    // Receiving server only: the connection it came in on (not on the wire),
+    // for replies through NamedPipeServer::Send
+    uint64_t connection = 0;
     
     PipeMessage() : command(0), dataSize(0) {}
-    PipeMessage(DWORD cmd, const std::string& msg) : command(cmd), data(msg), dataSize(static_cast<DWORD>(msg.length())) {}
+    PipeMessage(DWORD cmd, std::string_view msg) : command(cmd), dataSize(static_cast<DWORD>(msg.length())), data(msg) {}
 };
 
-// JSON serialization functions
+// JSON serialization functions (handshake, legacy peers, debug logs)
+inline void appendJsonString(std::string& out, const std::string& value) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+// "name":"value" with a leading comma unless it is the first field
+inline void appendJsonField(std::string& out, const char* name, const std::string& value) {
+    if (out.size() > 1) out += ',';
+    out += '"';
+    out += name;
+    out += "\":";
+    appendJsonString(out, value);
+}
+
+// "name":raw for numbers, booleans and embedded JSON
+inline void appendJsonRaw(std::string& out, const char* name, const std::string& raw) {
+    if (out.size() > 1) out += ',';
+    out += '"';
+    out += name;
+    out += "\":";
+    out += raw;
+}
+
 inline std::string toJson(const HelloMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"pid\":" << msg.pid << ",\"ver\":\"" << msg.version << "\"}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonRaw(out, "pid", std::to_string(msg.pid));
+    appendJsonField(out, "ver", msg.version);
+    if (msg.codec > 0) appendJsonRaw(out, "codec", std::to_string(msg.codec));
+    out += '}';
+    return out;
 }
 
 inline std::string toJson(const HelloAckMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"ok\":" << (msg.ok ? "true" : "false") << ",\"server_time\":" << msg.server_time << "}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonRaw(out, "ok", msg.ok ? "true" : "false");
+    appendJsonRaw(out, "server_time", std::to_string(msg.server_time));
+    if (msg.codec > 0) appendJsonRaw(out, "codec", std::to_string(msg.codec));
+    out += '}';
+    return out;
 }
 
+// opts is a JSON object and is embedded as is
 inline std::string toJson(const SetUrlMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"id\":\"" << msg.id << "\",\"url\":\"" << msg.url << "\",\"opts\":" << msg.opts << "}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonField(out, "id", msg.id);
+    appendJsonField(out, "url", msg.url);
+    appendJsonRaw(out, "opts", msg.opts.empty() ? "{}" : msg.opts);
+    out += '}';
+    return out;
 }
 
 inline std::string toJson(const AckMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"id\":\"" << msg.id << "\",\"status\":\"" << msg.status << "\"}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonField(out, "id", msg.id);
+    appendJsonField(out, "status", msg.status);
+    if (!msg.error.empty()) appendJsonField(out, "error", msg.error);
+    out += '}';
+    return out;
 }
 
+// payload is the raw server message, carried as an escaped string; info is
+// a JSON object and is embedded as is
 inline std::string toJson(const SocketEventMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"event\":\"" << msg.event << "\"";
-    if (!msg.payload.empty()) oss << ",\"payload\":\"" << msg.payload << "\"";
-    if (!msg.id.empty()) oss << ",\"id\":\"" << msg.id << "\"";
-    if (!msg.info.empty()) oss << ",\"info\":" << msg.info;
-    oss << "}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonField(out, "event", msg.event);
+    if (!msg.payload.empty()) appendJsonField(out, "payload", msg.payload);
+    if (!msg.id.empty()) appendJsonField(out, "id", msg.id);
+    if (!msg.info.empty()) appendJsonRaw(out, "info", msg.info);
+    out += '}';
+    return out;
 }
 
 inline std::string toJson(const PingMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"t\":" << msg.t << "}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonRaw(out, "t", std::to_string(msg.t));
+    out += '}';
+    return out;
 }
 
 inline std::string toJson(const PongMessage& msg) {
-    std::ostringstream oss;
-    oss << "{\"type\":\"" << msg.type << "\",\"t\":" << msg.t << "}";
-    return oss.str();
+    std::string out = "{";
+    appendJsonField(out, "type", msg.type);
+    appendJsonRaw(out, "t", std::to_string(msg.t));
+    out += '}';
+    return out;
 }
 
 // Utility functions
@@ -136,14 +235,81 @@ inline int64_t getCurrentTimeMs() {
         std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
+// Reassembles PipeMessages from a byte stream. Reads go straight into its
+// buffer (WriteSpace/Commit), and one read can complete any number of
+// messages; lengths are checked before anything is allocated for them.
+class PipeFrameReader {
+public:
+    enum class Result { Frame, NeedMore, Corrupt };
+
+    // Room for the next read: at least PIPE_BUFFER_SIZE, or the rest of a
+    // partly received large message so it arrives in one read
+    char* WriteSpace(DWORD& size);
+    void Commit(DWORD bytes);
+    Result Next(PipeMessage& message);
+
+    uint64_t Reads() const { return reads; }
+    uint64_t Frames() const { return frames; }
+
+private:
+    std::string buffer;
+    size_t start = 0; // first unconsumed byte
+    size_t end = 0;   // end of received bytes
+    uint64_t reads = 0;
+    uint64_t frames = 0;
+};
+
+struct PipeServerStats {
+    uint64_t accepted = 0;
+    uint64_t reads = 0;    // completed ReadFile calls
+    uint64_t messages = 0; // batches count as the messages they carry
+    uint64_t batches = 0;
+    uint64_t deferred = 0; // data messages handled after control read with them
+};
+
+// Serves any number of clients at once: PIPE_LISTENERS overlapped instances
+// wait for connections and every connected instance keeps one overlapped
+// read outstanding, all completing on one I/O completion port. The handler
+// runs on the completion thread, so calls are never concurrent. Pipes are
+// duplex: Send() answers a client on the connection its message came from.
 class NamedPipeServer {
 private:
-    HANDLE hPipe;
+    // Shared by Send() and the completion thread; the handle is closed when
+    // the last of them lets go, so a write never races CloseHandle
+    struct PipeHandle {
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        std::mutex writeMutex; // one writer per connection at a time
+        bool broken = false;   // under writeMutex: a write failed, client dropped
+
+        ~PipeHandle() {
+            if (pipe != INVALID_HANDLE_VALUE) CloseHandle(pipe);
+        }
+    };
+
+    struct Connection {
+        uint64_t id = 0;
+        std::shared_ptr<PipeHandle> handle;
+        HANDLE pipe = INVALID_HANDLE_VALUE; // handle->pipe
+        OVERLAPPED overlapped{};
+        bool connecting = true;
+        char* readBuffer = nullptr; // inside reader, valid while a read is outstanding
+        PipeFrameReader reader;
+        std::vector<PipeMessage> deferred; // data frames of the current read
+    };
+
+    HANDLE hPort;
     std::wstring pipeName;
     std::atomic<bool> running;
     std::thread serverThread;
     std::function<void(const PipeMessage&)> messageHandler;
     std::mutex pipeMutex;
+    std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+    std::atomic<uint64_t> accepted{ 0 };
+    std::atomic<uint64_t> reads{ 0 };
+    std::atomic<uint64_t> messages{ 0 };
+    std::atomic<uint64_t> batches{ 0 };
+    std::atomic<uint64_t> deferred{ 0 };
+    uint64_t nextId = 0;
     
 public:
     NamedPipeServer(const std::wstring& name);
@@ -152,27 +318,42 @@ public:
     bool Start(std::function<void(const PipeMessage&)> handler);
     void Stop();
     bool IsRunning() const { return running.load(); }
+    uint64_t Accepted() const { return accepted.load(); }
+    PipeServerStats Stats() const;
+    // Any thread; waits only for other writes to the same client. False if
+    // that client is gone or the write failed, which also drops the client
+    bool Send(uint64_t connection, const PipeMessage& message);
     
 private:
     void ServerLoop();
-    bool CreatePipe();
-    void ClosePipe();
+    bool CreatePipe(bool first = false);
+    void OnConnected(Connection* conn);
+    void PostRead(Connection* conn);
+    bool Dispatch(Connection* conn);
+    void Deliver(PipeMessage& message);
+    void ClosePipe(Connection* conn);
 };
 
+// Opened duplex and overlapped, so a reader thread (StartReading) can wait
+// for messages from the server while SendMessage writes on the same handle.
 class NamedPipeClient {
 private:
     HANDLE hPipe;
     std::wstring pipeName;
     std::mutex pipeMutex;
+    HANDLE hStop = NULL;
+    std::thread readerThread;
     
 public:
     NamedPipeClient(const std::wstring& name);
     ~NamedPipeClient();
     
-    bool Connect();
+    bool Connect(int maxRetries = 3);
     void Disconnect();
     bool SendMessage(const PipeMessage& message);
     bool IsConnected() const;
+    // Handler runs on the reader thread until the pipe breaks or Disconnect
+    bool StartReading(std::function<void(const PipeMessage&)> handler);
     
 private:
     void ClosePipe();
@@ -181,5 +362,12 @@ private:
 // Utility functions
 std::wstring GetPipeName(const std::wstring& appTitle);
 PipeMessage CreatePipeMessage(DWORD command, const std::string& data);
+// Overlapped handles: each call waits for its own I/O to finish.
+// hStop (optional) aborts a read that is waiting for data.
+// Header and data go out in one WriteFile.
 bool WritePipeMessage(HANDLE hPipe, const PipeMessage& message);
-bool ReadPipeMessage(HANDLE hPipe, PipeMessage& message);
+bool ReadPipeMessage(HANDLE hPipe, PipeMessage& message, HANDLE hStop = NULL);
+// PROTOCOL_BATCH payloads
+void AppendBatchFrame(std::string& batch, const PipeMessage& message);
+// False if the payload is malformed; frames before the bad one were delivered
+bool ForEachBatchFrame(const PipeMessage& batch, const std::function<void(PipeMessage&)>& fn);
@@ -0,0 +1,370 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ipc_batcher.h"
+#include "ipc_priority.h"
+#include "ipc_stream.h"
+#include "message_dispatcher.h"
+#include "named_pipe_communication.h"
+#include "shared_ring.h"
+#include "utils.h"
+
+// Long-lived connection from the service to the app's Named Pipe server.
+// Connects lazily, keeps the handle open between messages and caches
+// whether the app is reachable so a down app costs nothing per message.
+// SOCKET_EVENT traffic goes through the app's shared-memory ring when it
+// has one; everything else, and ring overflow, uses the pipe, where bursts
+// of SOCKET_EVENTs are coalesced into PROTOCOL_BATCH frames. Once an event
+// has gone to the pipe, later ones follow it there until it is written, so
+// the ring never overtakes the pipe. Messages above
+// IPC_STREAM_THRESHOLD go in flow-controlled chunks (ipc_stream.h), so other
+// writes interleave with a large one instead of waiting for it. The pipe is
+// duplex: requests from the app (SET_URL, stop...) arrive on it and are
+// handled in order on one worker, never on the pipe reader thread. In both
+// directions control messages go ahead of data (ipc_priority.h): replies
+// take the pipe before queued event writes, and requests are handled before
+// queued inbound data.
+class ParentChannel {
+public:
+    enum class State { Unknown, Up, Down };
+
+    void SetTitle(const std::wstring& title) {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (title == appTitle) return;
+        appTitle = title;
+        client.reset();
+        ring.Close();
+        dropUnread();
+        ringRetryAt = 0;
+        hwnd = NULL;
+        hwndCheckedAt = 0;
+        retryAt = 0;
+        backoffMs = MIN_BACKOFF_MS;
+        state.store(State::Unknown);
+        peerCodec.store(0);
+        streams.CancelAll();
+    }
+
+    // Set once, before the first connect
+    void SetHandler(std::function<void(const PipeMessage&)> handler) {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (inbound) return;
+        inbound = std::make_unique<MessageDispatcher<PipeMessage>>(1,
+            [handler](DispatchItem<PipeMessage>& item) { handler(item.value); },
+            std::vector<LaneConfig>(IPC_PRIORITY_CLASSES), LaneScheduling::Strict);
+    }
+
+    // Cheap: no syscall, just the cached state
+    bool IsActive() const { return state.load() == State::Up; }
+
+    // Binary codec version the app reads (its HELLO_ACK); 0 = JSON only
+    void SetPeerCodec(int codec) { peerCodec.store(codec); }
+    int PeerCodec() const { return peerCodec.load(); }
+    State GetState() const { return state.load(); }
+
+    // Batch window for SOCKET_EVENTs on the pipe; windowUs <= 0 turns it off
+    void ConfigureBatching(int64_t windowUs, int64_t maxCount, int64_t maxBytes) {
+        batcher.Configure(windowUs, maxCount, maxBytes);
+    }
+
+    // Largest message Send() streams; larger ones are refused
+    void ConfigureStreaming(int64_t maxBytes) {
+        streams.SetMaxSize(maxBytes);
+    }
+
+    // Gets the outcome once, with no channel lock held: true when the app
+    // has the message, false when it will not get it this way. A pipe write
+    // reports when it completes, which for a batched event is after Send
+    // returns; a ring event reports at the PollRing that sees the app has
+    // handled it, or sees the ring closed.
+    using Delivered = std::function<void(bool delivered)>;
+
+    // One write on the open connection. Reconnects at most once per call
+    // and never while inside the backoff window after a failure. False
+    // only when that is already known; delivered has the final outcome.
+    bool Send(const PipeMessage& message, Delivered delivered = nullptr) {
+        if (message.data.size() > IPC_STREAM_THRESHOLD && PeerCodec() >= 1) {
+            return sendStream(message, delivered);
+        }
+        if (message.command == PROTOCOL_SOCKET_EVENT) {
+            PollRing();
+            bool queue = false;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                if (!appTitle.empty()) {
+                    if (sendRing(message, delivered)) return true;
+                    // Do not queue into a batch that cannot be written
+                    queue = client || nowMs() >= retryAt;
+                    if (queue) pipeEvents++;
+                }
+            }
+            if (!queue) return report(delivered, false);
+            // Lock order: batcher, then channel (its sender takes mutex)
+            return batcher.Add(message, std::move(delivered));
+        }
+        bool ok;
+        {
+            IpcWriteLock gate(writeGate, message.command);
+            std::lock_guard<std::mutex> lk(mutex);
+            ok = !appTitle.empty() && sendPipe(message);
+        }
+        return report(delivered, ok);
+    }
+
+    // Reports ring events the app has handled since the last call, and the
+    // ones lost with a ring that closed. Every event send polls; the service
+    // heartbeat covers idle time.
+    void PollRing() {
+        std::vector<Delivered> done;
+        std::vector<Delivered> gone;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (!ring.IsOpen()) dropUnread();
+            uint64_t released = ring.Released();
+            while (!unread.empty() && unread.front().first <= released) {
+                done.push_back(std::move(unread.front().second));
+                unread.pop_front();
+            }
+            gone.swap(lost);
+        }
+        for (auto& d : done) d(true);
+        for (auto& d : gone) d(false);
+    }
+
+    // Writes the SOCKET_EVENTs waiting in the batch now; their Delivered
+    // runs before this returns
+    void FlushEvents() {
+        batcher.Flush();
+    }
+
+    // Forced connect attempt, ignores the backoff window (startup handshake)
+    bool Open() {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (appTitle.empty()) return false;
+        retryAt = 0;
+        return ensureConnected();
+    }
+
+    // Window of the app for the WM_COPYDATA fallback, looked up at most once
+    // per HWND_TTL_MS instead of once per message.
+    HWND Window() {
+        std::lock_guard<std::mutex> lk(mutex);
+        if (hwnd && IsWindow(hwnd)) return hwnd;
+        int64_t t = nowMs();
+        if (t - hwndCheckedAt < HWND_TTL_MS) return NULL;
+        hwndCheckedAt = t;
+        hwnd = FindWindow(NULL, appTitle.c_str());
+        if (hwnd && !IsWindow(hwnd)) hwnd = NULL;
+        return hwnd;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lk(mutex);
+        client.reset();
+        ring.Close();
+        dropUnread();
+        state.store(State::Unknown);
+        streams.CancelAll();
+    }
+
+    std::wstring DescribeRing() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return L"open=" + std::to_wstring(ring.IsOpen()) + L" written=" + std::to_wstring(ring.Written())
+            + L" full=" + std::to_wstring(ring.Full()) + L" wakeups=" + std::to_wstring(ring.Wakeups())
+            + L" unread=" + std::to_wstring(unread.size());
+    }
+
+    std::wstring DescribeBatching() const {
+        return L"immediate=" + std::to_wstring(batcher.Immediate()) + L" batches=" + std::to_wstring(batcher.Batches())
+            + L" batched=" + std::to_wstring(batcher.Batched()) + L" dropped=" + std::to_wstring(batcher.Dropped());
+    }
+
+    std::wstring DescribeStreaming() const {
+        return streams.Describe();
+    }
+
+    // Wait for the pipe per class, and for the worker per class of request
+    std::wstring DescribePriority() {
+        std::wstring s = L"out: " + writeGate.Describe();
+        if (inbound) {
+            DispatchStats d = inbound->stats();
+            const wchar_t* names[IPC_PRIORITY_CLASSES] = { L" in: control", L" data" };
+            for (size_t i = 0; i < d.lanes.size() && i < IPC_PRIORITY_CLASSES; i++) {
+                const LaneStats& l = d.lanes[i];
+                s += names[i] + std::wstring(L" handled=") + std::to_wstring(l.processed)
+                    + L" queueAvgUs=" + std::to_wstring(l.processed ? l.queueLatencyTotalUs / l.processed : 0)
+                    + L" queueMaxUs=" + std::to_wstring(l.queueLatencyMaxUs);
+            }
+        }
+        return s;
+    }
+
+private:
+    static constexpr int64_t MIN_BACKOFF_MS = 500;
+    static constexpr int64_t MAX_BACKOFF_MS = 30000;
+    static constexpr int64_t HWND_TTL_MS = 5000;
+    static constexpr int64_t RING_RETRY_MS = 5000;
+
+    std::mutex mutex;
+    std::wstring appTitle;
+    std::unique_ptr<NamedPipeClient> client;
+    std::atomic<State> state{ State::Unknown };
+    std::atomic<int> peerCodec{ 0 };
+    int64_t retryAt = 0;
+    int64_t backoffMs = MIN_BACKOFF_MS;
+    HWND hwnd = NULL;
+    int64_t hwndCheckedAt = 0;
+    SharedRingWriter ring;
+    int64_t ringRetryAt = 0;
+    // Ring records not yet handled by the app: end position, callback.
+    // When the ring closes they move to lost, reported false by PollRing.
+    std::deque<std::pair<uint64_t, Delivered>> unread;
+    std::vector<Delivered> lost;
+    // SOCKET_EVENTs handed to the pipe (batcher or stream), not yet written
+    int64_t pipeEvents = 0;
+    std::unique_ptr<MessageDispatcher<PipeMessage>> inbound;
+    // Taken before mutex by every pipe write
+    IpcWriteGate writeGate;
+    IpcBatcher batcher{ [this](const PipeMessage& m, int64_t events) {
+        IpcWriteLock gate(writeGate, m.command);
+        std::lock_guard<std::mutex> lk(mutex);
+        pipeEvents -= events;
+        return !appTitle.empty() && sendPipe(m);
+    } };
+    IpcStreamSender streams;
+
+    // Blocks the caller for the whole transfer, but holds the channel only
+    // for one chunk at a time. The ring takes SOCKET_EVENTs that fit in it.
+    bool sendStream(const PipeMessage& message, Delivered& delivered) {
+        bool event = message.command == PROTOCOL_SOCKET_EVENT;
+        bool titled;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            titled = !appTitle.empty();
+            if (titled && event) {
+                if (sendRing(message, delivered)) return true;
+                pipeEvents++;
+            }
+        }
+        if (!titled) return report(delivered, false);
+        // Events batched before this one go first
+        batcher.Flush();
+        bool ok = streams.Send(message.command, message.data, [this](const PipeMessage& chunk) {
+            IpcWriteLock gate(writeGate, chunk.command);
+            std::lock_guard<std::mutex> lk(mutex);
+            return !appTitle.empty() && sendPipe(chunk);
+        });
+        if (event) {
+            std::lock_guard<std::mutex> lk(mutex);
+            pipeEvents--;
+        }
+        return report(delivered, ok);
+    }
+
+    static bool report(const Delivered& delivered, bool ok) {
+        if (delivered) delivered(ok);
+        return ok;
+    }
+
+    // Under mutex, when the ring closes
+    void dropUnread() {
+        for (auto& u : unread) lost.push_back(std::move(u.second));
+        unread.clear();
+    }
+
+    // Under mutex
+    bool sendPipe(const PipeMessage& message) {
+        if (client && client->SendMessage(message)) {
+            return true;
+        }
+        if (client) {
+            // Pipe vừa đứt: server tạo instance mới ngay, thử lại một lần
+            write_log(L"[ParentChannel] ", L"write failed, reconnecting");
+            client.reset();
+            retryAt = 0;
+        }
+        if (!ensureConnected()) return false;
+        if (client->SendMessage(message)) return true;
+
+        client.reset();
+        markDown();
+        return false;
+    }
+
+    // An app without a ring (not started yet, older build) is looked up
+    // again at most once per RING_RETRY_MS. Under mutex
+    bool sendRing(const PipeMessage& message, Delivered& delivered) {
+        // An event still on its way through the pipe would be overtaken
+        if (pipeEvents > 0) return false;
+        if (!ring.IsOpen()) {
+            // Positions in unread belong to the ring that closed
+            dropUnread();
+            int64_t t = nowMs();
+            if (t < ringRetryAt) return false;
+            if (!ring.Open(appTitle)) {
+                ringRetryAt = t + RING_RETRY_MS;
+                return false;
+            }
+            write_log(L"[ParentChannel] ", L"shared ring opened");
+        }
+        uint64_t end = 0;
+        if (ring.TryWrite(message, &end)) {
+            state.store(State::Up);
+            if (delivered) unread.emplace_back(end, std::move(delivered));
+            return true;
+        }
+        return false;
+    }
+
+    bool ensureConnected() {
+        if (client) return true;
+        int64_t t = nowMs();
+        if (t < retryAt) return false; // fail fast: app vẫn đang down
+
+        auto c = std::make_unique<NamedPipeClient>(GetPipeName(appTitle));
+        if (!c->Connect(1)) {
+            markDown();
+            return false;
+        }
+        if (inbound) {
+            MessageDispatcher<PipeMessage>* queue = inbound.get();
+            IpcStreamSender* out = &streams;
+            c->StartReading([queue, out](const PipeMessage& m) {
+                // Credits unblock a sender; they must not wait behind the
+                // requests being handled
+                if (m.command == PROTOCOL_STREAM_CREDIT) out->OnCredit(m);
+                else queue->post(L"ipc", m, static_cast<size_t>(ipcPriorityOf(m.command)));
+            });
+        }
+        client = std::move(c);
+        backoffMs = MIN_BACKOFF_MS;
+        retryAt = 0;
+        if (state.exchange(State::Up) != State::Up) {
+            write_log(L"[ParentChannel] ", L"connected");
+        }
+        return true;
+    }
+
+    void markDown() {
+        if (state.exchange(State::Down) != State::Down) {
+            write_log(L"[ParentChannel] ", L"app not reachable");
+        }
+        retryAt = nowMs() + backoffMs;
+        backoffMs = (std::min)(backoffMs * 2, MAX_BACKOFF_MS);
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+inline ParentChannel g_parentChannel;
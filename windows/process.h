@@ -45,14 +45,29 @@ static DWORD WINAPI ThreadFunction(LPVOID lpParam) {
 	write_log(L"[Plugin] ", L"Named Pipe mode - skipping hidden window");
 	write_pid(hwnd); // Still save PID for WM_COPYDATA fallback
 
+	// Control exists before HELLO: the app answers it with SET_URL right away
+	try {
+		m_control = std::make_unique<WebSocketControl>();
+		m_control->updateSettings(*param);
+	}
+	catch (const std::exception& ex) {
+		write_error(ex, 209);
+	}
+	catch (...) {
+		write_error();
+	}
+
     // Child process does not need its own Named Pipe server
     // It will receive settings via the parent pipe connection
     write_log(L"[DEBUG] ", L"Child process - no Named Pipe server needed");
     write_log(L"[Plugin] ", L"Child process - will receive settings via parent pipe");
     
     // Send HELLO message to parent via Named Pipe (matching diagram)
+    // The same persistent channel later carries SOCKET_EVENT and ACK messages
     std::wstring parentPipeName = GetPipeName(utf8_to_wide(param->title));
-    NamedPipeClient parentClient(parentPipeName);
+    g_parentChannel.SetTitle(utf8_to_wide(param->title));
+    // Requests from the app (SET_URL, stop, reconnect) come back on the same connection
+    g_parentChannel.SetHandler(HandlePipeMessage);
     
     // Wait a bit for parent pipe to be ready
     Sleep(500);
@@ -63,7 +78,7 @@ static DWORD WINAPI ThreadFunction(LPVOID lpParam) {
     // Try to connect with retry
     bool connected = false;
     for (int i = 0; i < 5; i++) {
-        if (parentClient.Connect()) {
+        if (g_parentChannel.Open()) {
             connected = true;
             write_log(L"[SUCCESS] ", L"Child successfully connected to parent pipe!");
             break;
@@ -79,11 +94,12 @@ static DWORD WINAPI ThreadFunction(LPVOID lpParam) {
         HelloMessage helloMsg;
         helloMsg.pid = GetCurrentProcessId();
         helloMsg.version = "1.0";
+        helloMsg.codec = IPC_CODEC_VERSION;
         
         std::string helloJson = toJson(helloMsg);
         PipeMessage message(PROTOCOL_HELLO, helloJson);
         
-        if (parentClient.SendMessage(message)) {
+        if (g_parentChannel.Send(message)) {
             write_log(L"[DEBUG] ", L"HELLO message sent to parent via Named Pipe");
             write_log(L"[Plugin] ", L"sent HELLO message to parent via Named Pipe");
             write_log(L"[DEBUG] ", (std::wstring(L"HELLO JSON: ") + utf8_to_wide(helloJson)).c_str());
@@ -133,16 +149,6 @@ static DWORD WINAPI ThreadFunction(LPVOID lpParam) {
         }
     }
 
-	try {
-		m_control = std::make_unique<WebSocketControl>();
-		m_control->updateSettings(*param);
-	}
-	catch (const std::exception& ex) {
-		write_error(ex, 209);
-	}
-	catch (...) {
-		write_error();
-	}
 	try {
 		MSG msg;
 		while (GetMessage(&msg, NULL, 0, 0)) {
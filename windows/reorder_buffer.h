@@ -0,0 +1,183 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Most out-of-order frames held per sender; beyond it the lowest is forced out
+#define REORDER_MAX_HELD    256
+// How long a frame may wait for a missing predecessor
+#define REORDER_TIMEOUT_MS  500
+// Skipped ranges remembered per sender, so a late frame or the replay of a
+// gap is still let through; beyond it the oldest range is forgotten
+#define REORDER_MAX_GAPS    64
+
+// Sequence numbers that never arrived before the timeout (inclusive range)
+struct ReorderGap {
+    std::wstring key;
+    int64_t from;
+    int64_t to;
+};
+
+struct ReorderStats {
+    uint64_t released = 0;
+    uint64_t delayed = 0;       // released after waiting in the buffer
+    uint64_t holdTotalUs = 0;
+    uint64_t holdMaxUs = 0;
+    uint64_t gaps = 0;
+    uint64_t held = 0;          // currently waiting
+    uint64_t duplicates = 0;    // dropped, Seq already released
+};
+
+// Releases frames per sender in Seq order. A frame ahead of the expected
+// sequence waits until its predecessors arrive, until REORDER_TIMEOUT_MS
+// passes or until the buffer is full; the skipped range is reported as a gap.
+// A frame below the expected Seq is released only if it falls in a gap that
+// is still open, so a replay of frames already delivered is dropped here
+// whether or not they carry a message id.
+// Not thread safe: callers serialize Push/Expire (stats() aside).
+template <typename T>
+class ReorderBuffer {
+public:
+    using Release = std::function<void(T&)>;
+
+    // baseline: next expected Seq for a sender seen for the first time
+    // (0 = take the first frame's Seq)
+    void Push(const std::wstring& key, int64_t seq, int64_t baseline, T item,
+        const Release& release, std::vector<ReorderGap>& gaps) {
+        Stream& s = streams[key];
+        if (s.expected == 0) s.expected = baseline > 0 ? baseline : seq;
+
+        if (seq < s.expected) {
+            // Late or replayed: only a skipped slot is still owed
+            if (!fillGap(s, seq)) {
+                duplicates++;
+                return;
+            }
+            release(item);
+            released++;
+            return;
+        }
+        if (seq == s.expected) {
+            release(item);
+            released++;
+            s.expected++;
+            drain(s, release);
+            return;
+        }
+        if (s.held.emplace(seq, Held{ std::move(item), nowUs() }).second) {
+            held++;
+        }
+        else {
+            duplicates++;
+        }
+        if (s.held.size() > REORDER_MAX_HELD) {
+            skipTo(key, s, s.held.begin()->first, release, gaps);
+        }
+    }
+
+    // Releases everything that waited longer than REORDER_TIMEOUT_MS
+    void Expire(const Release& release, std::vector<ReorderGap>& gaps) {
+        int64_t t = nowUs();
+        for (auto& [key, s] : streams) {
+            while (!s.held.empty() && oldest(s) + REORDER_TIMEOUT_MS * 1000 <= t) {
+                skipTo(key, s, s.held.begin()->first, release, gaps);
+            }
+        }
+    }
+
+    bool HasHeld() const {
+        return held.load() > 0;
+    }
+
+    ReorderStats stats() const {
+        ReorderStats s;
+        s.released = released.load();
+        s.delayed = delayed.load();
+        s.holdTotalUs = holdTotalUs.load();
+        s.holdMaxUs = holdMaxUs.load();
+        s.gaps = gapCount.load();
+        s.held = held.load();
+        s.duplicates = duplicates.load();
+        return s;
+    }
+
+private:
+    struct Held {
+        T item;
+        int64_t arrivedUs;
+    };
+
+    struct Stream {
+        int64_t expected = 0;
+        std::map<int64_t, Held> held;
+        std::map<int64_t, int64_t> missing; // open gaps, from -> to
+    };
+
+    std::unordered_map<std::wstring, Stream> streams;
+
+    std::atomic<uint64_t> released{ 0 };
+    std::atomic<uint64_t> delayed{ 0 };
+    std::atomic<uint64_t> holdTotalUs{ 0 };
+    std::atomic<uint64_t> holdMaxUs{ 0 };
+    std::atomic<uint64_t> gapCount{ 0 };
+    std::atomic<uint64_t> held{ 0 };
+    std::atomic<uint64_t> duplicates{ 0 };
+
+    void drain(Stream& s, const Release& release) {
+        while (!s.held.empty() && s.held.begin()->first <= s.expected) {
+            auto it = s.held.begin();
+            uint64_t waited = static_cast<uint64_t>(nowUs() - it->second.arrivedUs);
+            release(it->second.item);
+            if (it->first == s.expected) s.expected++;
+            s.held.erase(it);
+            held--;
+            released++;
+            delayed++;
+            holdTotalUs += waited;
+            if (waited > holdMaxUs.load()) holdMaxUs = waited;
+        }
+    }
+
+    void skipTo(const std::wstring& key, Stream& s, int64_t to, const Release& release, std::vector<ReorderGap>& gaps) {
+        if (to > s.expected) {
+            gaps.push_back(ReorderGap{ key, s.expected, to - 1 });
+            gapCount++;
+            s.missing[s.expected] = to - 1;
+            if (s.missing.size() > REORDER_MAX_GAPS) s.missing.erase(s.missing.begin());
+            s.expected = to;
+        }
+        drain(s, release);
+    }
+
+    // Takes seq out of the open gap holding it; false if none does
+    static bool fillGap(Stream& s, int64_t seq) {
+        auto it = s.missing.upper_bound(seq);
+        if (it == s.missing.begin()) return false;
+        --it;
+        int64_t from = it->first;
+        int64_t to = it->second;
+        if (seq > to) return false;
+        s.missing.erase(it);
+        if (from < seq) s.missing[from] = seq - 1;
+        if (seq < to) s.missing[seq + 1] = to;
+        return true;
+    }
+
+    static int64_t oldest(const Stream& s) {
+        int64_t o = INT64_MAX;
+        for (auto& [seq, h] : s.held) {
+            if (h.arrivedUs < o) o = h.arrivedUs;
+        }
+        return o;
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
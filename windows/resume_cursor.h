@@ -0,0 +1,114 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+
+#include "utils.h"
+
+// Highest server sequence number ("Seq") stored by this client, per
+// registration. Sent back in the register frame so the server only
+// replays what was missed. Kept in app_system.ini next to the pid.
+class ResumeCursor {
+public:
+    // Key is the registration identity (connector id); switching reloads
+    void SetKey(const std::string& key) {
+        std::lock_guard<std::mutex> lk(mutex);
+        std::wstring k = utf8_to_wide(key);
+        if (k == cursorKey) return;
+        flushLocked();
+        cursorKey = k;
+        value.store(load());
+        flushedValue = value.load();
+    }
+
+    int64_t Get() const { return value.load(); }
+
+    std::wstring Key() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return cursorKey;
+    }
+
+    void Advance(int64_t seq) {
+        int64_t cur = value.load();
+        while (seq > cur && !value.compare_exchange_weak(cur, seq)) {}
+    }
+
+    // Called from the heartbeat; one profile write at most every tick
+    void Flush() {
+        std::lock_guard<std::mutex> lk(mutex);
+        flushLocked();
+    }
+
+private:
+    std::mutex mutex;
+    std::wstring cursorKey;
+    std::atomic<int64_t> value{ 0 };
+    int64_t flushedValue = 0;
+
+    static std::wstring path() {
+        return get_current_path() + L"\\app_system.ini";
+    }
+
+    int64_t load() const {
+        if (cursorKey.empty()) return 0;
+        wchar_t buffer[32] = { 0 };
+        GetPrivateProfileStringW(L"resume", cursorKey.c_str(), L"0", buffer, 32, path().c_str());
+        return _wtoi64(buffer);
+    }
+
+    void flushLocked() {
+        int64_t v = value.load();
+        if (cursorKey.empty() || v == flushedValue) return;
+        WritePrivateProfileStringW(L"resume", cursorKey.c_str(), std::to_wstring(v).c_str(), path().c_str());
+        flushedValue = v;
+    }
+};
+
+// Frames handed to the lanes finish out of Seq order (priority lanes), so
+// the cursor may only move past a Seq once every frame below it is done:
+// moving it to the highest done Seq would skip frames still queued if the
+// service dies. Acks are held back the same way, since the server forgets
+// an acked frame.
+class SeqWatermark {
+public:
+    struct Done {
+        int64_t seq;
+        std::optional<std::string> id;
+        bool ack;
+    };
+
+    // Before the frame is queued
+    void Admit(int64_t seq) {
+        std::lock_guard<std::mutex> lk(mutex);
+        pending.insert(seq);
+    }
+
+    // release(const Done&) runs, in Seq order, for each frame the watermark
+    // now covers; this one included unless an earlier frame is pending
+    template <typename F>
+    void Complete(int64_t seq, std::optional<std::string> id, bool ack, F&& release) {
+        std::lock_guard<std::mutex> lk(mutex);
+        pending.erase(seq);
+        done[seq] = Done{ seq, std::move(id), ack };
+        while (!done.empty() && (pending.empty() || done.begin()->first < *pending.begin())) {
+            release(done.begin()->second);
+            done.erase(done.begin());
+        }
+    }
+
+    // Queued or done but held behind a queued one
+    size_t Outstanding() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return pending.size() + done.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::set<int64_t> pending;
+    std::map<int64_t, Done> done;
+};
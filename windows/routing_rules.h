@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "model.h"
+#include "message_classifier.h"
+#include "topic_matcher.h"
+#include "utils.h"
+
+// Predicates are bits in one 64-bit word; rules beyond that are ignored
+#define ROUTE_MAX_PREDICATES 64
+
+enum class RouteAction : uint8_t {
+    Deliver,   // app if it is connected, else toast (the default)
+    Toast,     // toast only; the app is not woken
+    StoreOnly, // inbox only; the app drains it on its next start
+    Drop,      // acked and discarded
+    Collapse,  // like Deliver, but an undelivered earlier message with the
+               // same collapse key is superseded in the inbox
+};
+#define ROUTE_ACTIONS 5
+
+inline RouteAction routeActionFromString(const std::string& s) {
+    if (s == "toast") return RouteAction::Toast;
+    if (s == "store") return RouteAction::StoreOnly;
+    if (s == "drop") return RouteAction::Drop;
+    if (s == "collapse") return RouteAction::Collapse;
+    return RouteAction::Deliver;
+}
+
+// What a rule can look at, taken from the message once per evaluation
+struct RouteFacts {
+    std::string_view type;
+    std::string_view tag;
+    MessagePriority priority = MessagePriority::Normal;
+    std::wstring_view topic;
+};
+
+// Rules from settings, first match wins. Compiled once into a flat program:
+// every distinct predicate gets a bit, a message is reduced to the word of
+// predicates it satisfies (hash lookups, no per-rule string compares), and
+// each rule is a (mask, action) pair tested with one AND and compare.
+// Topics are patterns with the subscription grammar (TopicMatcher).
+class RoutingRules {
+public:
+    void Compile(const std::vector<RouteRuleSetting>& rules,
+        const std::string& connectorTag = "", const std::string& connectorId = "") {
+        auto p = std::make_shared<Program>();
+        for (auto& r : rules) {
+            uint64_t mask = 0;
+            bool ok = true;
+            if (r.type) ok &= p->bit(p->types, *r.type, mask);
+            if (r.tag) ok &= p->bit(p->tags, *r.tag, mask);
+            if (r.priority) {
+                uint64_t b;
+                ok &= p->next(b);
+                if (ok) {
+                    p->priorities[static_cast<size_t>(priorityFromString(*r.priority))] |= b;
+                    mask |= b;
+                }
+            }
+            if (r.topic) ok &= p->topicBit(*r.topic, connectorTag, connectorId, mask);
+            if (!ok) {
+                write_log(L"[Rules] ", L"too many predicates, rule ignored");
+                continue;
+            }
+            p->masks.push_back(mask);
+            p->actions.push_back(routeActionFromString(r.action));
+        }
+        std::atomic_store(&program, std::shared_ptr<const Program>(p->masks.empty() ? nullptr : p));
+    }
+
+    RouteAction Evaluate(const RouteFacts& f) const {
+        auto p = std::atomic_load(&program);
+        if (!p) return RouteAction::Deliver;
+        uint64_t bits = p->priorities[static_cast<size_t>(f.priority)];
+        bits |= lookup(p->types, f.type);
+        bits |= lookup(p->tags, f.tag);
+        // A message without a topic satisfies no topic predicate
+        if (!f.topic.empty()) {
+            for (auto& t : p->topics) {
+                bits |= t.matcher.Matches(f.topic) ? t.bit : 0;
+            }
+        }
+        for (size_t i = 0; i < p->masks.size(); i++) {
+            if ((bits & p->masks[i]) == p->masks[i]) return p->actions[i];
+        }
+        return RouteAction::Deliver;
+    }
+
+private:
+    struct TopicPredicate {
+        std::string pattern;
+        TopicMatcher matcher;
+        uint64_t bit;
+    };
+
+    // Keyed by views of the names the program owns, so a message's
+    // string_view is looked up as is (C++17 maps have no heterogeneous find)
+    using Table = std::unordered_map<std::string_view, uint64_t>;
+
+    struct Program {
+        std::deque<std::string> names; // stable storage for the table keys
+        Table types;
+        Table tags;
+        uint64_t priorities[PRIORITY_LANES] = { 0 };
+        std::vector<TopicPredicate> topics;
+        std::vector<uint64_t> masks;
+        std::vector<RouteAction> actions;
+        int used = 0;
+
+        bool next(uint64_t& b) {
+            if (used >= ROUTE_MAX_PREDICATES) return false;
+            b = 1ull << used++;
+            return true;
+        }
+
+        // Same value in several rules shares one bit
+        bool bit(Table& table, const std::string& value, uint64_t& mask) {
+            auto it = table.find(value);
+            if (it == table.end()) {
+                uint64_t b;
+                if (!next(b)) return false;
+                names.push_back(value);
+                it = table.emplace(names.back(), b).first;
+            }
+            mask |= it->second;
+            return true;
+        }
+
+        // Same grammar as subscriptions: "a/b" exact, "a/+/c" one level,
+        // "a/#" "a" and everything below it
+        bool topicBit(const std::string& pattern, const std::string& connectorTag,
+            const std::string& connectorId, uint64_t& mask) {
+            for (auto& t : topics) {
+                if (t.pattern == pattern) {
+                    mask |= t.bit;
+                    return true;
+                }
+            }
+            uint64_t b;
+            if (!next(b)) return false;
+            topics.push_back(TopicPredicate{ pattern, TopicMatcher{}, b });
+            topics.back().matcher.Compile({ pattern }, connectorTag, connectorId);
+            mask |= b;
+            return true;
+        }
+    };
+
+    std::shared_ptr<const Program> program;
+
+    static uint64_t lookup(const Table& table, std::string_view value) {
+        if (table.empty() || value.empty()) return 0;
+        auto it = table.find(value);
+        return it == table.end() ? 0 : it->second;
+    }
+
+    static MessagePriority priorityFromString(const std::string& s) {
+        if (s == "high" || s == "urgent" || s == "0") return MessagePriority::High;
+        if (s == "low" || s == "2") return MessagePriority::Low;
+        return MessagePriority::Normal;
+    }
+};
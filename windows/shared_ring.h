@@ -0,0 +1,379 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "named_pipe_communication.h"
+#include "utils.h"
+
+// Bytes of record space in the shared section (power of two)
+#define SHARED_RING_SIZE           (1 << 20)
+#define SHARED_RING_MAGIC          0x474E4952u // "RING"
+#define SHARED_RING_VERSION        1
+// Longest the reader sleeps without a wakeup; only bounds shutdown latency
+#define SHARED_RING_PARK_MS        200
+// How often the writer checks that the reading process is still alive
+#define SHARED_RING_LIVENESS_MS    1000
+
+// Start of the shared section. Writer-owned and reader-owned fields live on
+// separate cache lines so the two processes never write the same line.
+struct RingControl {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    std::atomic<uint32_t> readerPid;
+    alignas(64) std::atomic<uint64_t> head; // writer: bytes published
+    alignas(64) std::atomic<uint64_t> tail; // reader: bytes consumed
+    std::atomic<uint32_t> parked;           // reader is (about to be) asleep
+    alignas(64) uint8_t data[1];
+};
+
+// One record: header, then dataSize bytes, padded to 8. A record never wraps;
+// if it does not fit before the end, a RING_WRAP marker fills the remainder.
+struct RingRecord {
+    uint32_t dataSize;
+    uint32_t command;
+};
+#define RING_WRAP                  0xFFFFFFFFu
+
+// Single-producer / single-consumer byte ring over a RingControl. Positions
+// are free-running 64-bit counters; the producer publishes with a release
+// store of head, the consumer frees space with a release store of tail.
+class SpscRing {
+public:
+    explicit SpscRing(RingControl* control = nullptr) : c(control) {}
+
+    void Attach(RingControl* control) { c = control; }
+
+    static size_t SectionSize(uint64_t capacity) {
+        return offsetof(RingControl, data) + static_cast<size_t>(capacity);
+    }
+
+    // Producer. False if the record does not fit right now (or ever)
+    bool TryWrite(uint32_t command, const char* data, uint32_t size) {
+        uint64_t cap = c->capacity;
+        uint64_t need = recordSize(size);
+        if (need > cap / 2) return false;
+        uint64_t h = c->head.load(std::memory_order_relaxed);
+        uint64_t t = c->tail.load(std::memory_order_acquire);
+        uint64_t off = h & (cap - 1);
+        uint64_t room = cap - off;
+        uint64_t total = need <= room ? need : room + need;
+        if (cap - (h - t) < total) return false;
+
+        if (need > room) {
+            RingRecord wrap{ 0, RING_WRAP };
+            memcpy(c->data + off, &wrap, sizeof(wrap));
+            h += room;
+            off = 0;
+        }
+        RingRecord r{ size, command };
+        memcpy(c->data + off, &r, sizeof(r));
+        if (size) memcpy(c->data + off + sizeof(r), data, size);
+        // seq_cst pairs with the reader's parked store / head re-check
+        c->head.store(h + need, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Producer, after TryWrite: true if the reader must be woken
+    bool ReaderParked() const {
+        return c->parked.load(std::memory_order_seq_cst) != 0;
+    }
+
+    // Producer: position after the last record written. A record is read
+    // once Consumed() has reached the position after it.
+    uint64_t Published() const {
+        return c->head.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Consumed() const {
+        return c->tail.load(std::memory_order_acquire);
+    }
+
+    // Consumer. Copies the next record out; its space stays taken, and the
+    // producer does not count it read, until Release()
+    bool TryRead(PipeMessage& message) {
+        uint64_t cap = c->capacity;
+        uint64_t t = c->tail.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t h = c->head.load(std::memory_order_acquire);
+            if (t == h) return false;
+            uint64_t off = t & (cap - 1);
+            RingRecord r;
+            memcpy(&r, c->data + off, sizeof(r));
+            if (r.command == RING_WRAP) {
+                t += cap - off;
+                c->tail.store(t, std::memory_order_release);
+                continue;
+            }
+            message.command = r.command;
+            message.dataSize = r.dataSize;
+            message.data.assign(reinterpret_cast<const char*>(c->data + off + sizeof(r)), r.dataSize);
+            next = t + recordSize(r.dataSize);
+            return true;
+        }
+    }
+
+    // Consumer, once the record from TryRead has been handled
+    void Release() {
+        c->tail.store(next, std::memory_order_release);
+    }
+
+    // Consumer: forget every record not read yet
+    void Discard() {
+        c->tail.store(c->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Consumer: announce sleep, then re-check so a write racing with the
+    // announcement is not missed. True if it is safe to wait.
+    bool Park() {
+        c->parked.store(1, std::memory_order_seq_cst);
+        if (c->head.load(std::memory_order_seq_cst) != c->tail.load(std::memory_order_relaxed)) {
+            c->parked.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void Unpark() {
+        c->parked.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    RingControl* c;
+    uint64_t next = 0; // consumer: tail after the record being handled
+
+    static uint64_t recordSize(uint32_t size) {
+        return (sizeof(RingRecord) + size + 7) & ~uint64_t(7);
+    }
+};
+
+inline std::wstring GetRingName(const std::wstring& appTitle) {
+    return L"Local\\" + appTitle + L"_notification_ring";
+}
+
+inline std::wstring GetRingEventName(const std::wstring& appTitle) {
+    return L"Local\\" + appTitle + L"_notification_ring_event";
+}
+
+// App side: owns the section and drains it on its own thread into the same
+// handler as the pipe server. A record is released only after the handler
+// returns; the service marks the event consumed in the inbox when it sees
+// it released. If the section survived a previous app instance (the service
+// still holds it), records left in it are dropped: the service never saw
+// them read, so they are still in the inbox that the app drains at start.
+class SharedRingReader {
+public:
+    ~SharedRingReader() {
+        Stop();
+    }
+
+    bool Start(const std::wstring& appTitle, std::function<void(const PipeMessage&)> handler) {
+        if (running.load()) return true;
+        size_t size = SpscRing::SectionSize(SHARED_RING_SIZE);
+        hMap = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+            static_cast<DWORD>(size), GetRingName(appTitle).c_str());
+        if (!hMap) {
+            write_log(L"[Ring] CreateFileMapping failed: ", std::to_wstring(GetLastError()).c_str());
+            return false;
+        }
+        bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+        control = static_cast<RingControl*>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        hEvent = CreateEventW(NULL, FALSE, FALSE, GetRingEventName(appTitle).c_str());
+        if (!control || !hEvent) {
+            write_log(L"[Ring] map/event failed: ", std::to_wstring(GetLastError()).c_str());
+            close();
+            return false;
+        }
+        if (!existed || control->magic != SHARED_RING_MAGIC) {
+            control->capacity = SHARED_RING_SIZE;
+            control->head.store(0);
+            control->tail.store(0);
+            control->parked.store(0);
+            control->version = SHARED_RING_VERSION;
+            control->magic = SHARED_RING_MAGIC;
+        }
+        ring.Attach(control);
+        if (existed) ring.Discard();
+        control->readerPid.store(GetCurrentProcessId());
+
+        messageHandler = std::move(handler);
+        running.store(true);
+        readerThread = std::thread([this]() { run(); });
+        return true;
+    }
+
+    void Stop() {
+        if (running.exchange(false)) {
+            SetEvent(hEvent);
+            if (readerThread.joinable()) readerThread.join();
+        }
+        close();
+    }
+
+    uint64_t Received() const { return received.load(); }
+    uint64_t Wakeups() const { return wakeups.load(); }
+
+private:
+    HANDLE hMap = NULL;
+    HANDLE hEvent = NULL;
+    RingControl* control = nullptr;
+    SpscRing ring;
+    std::atomic<bool> running{ false };
+    std::thread readerThread;
+    std::function<void(const PipeMessage&)> messageHandler;
+    std::atomic<uint64_t> received{ 0 };
+    std::atomic<uint64_t> wakeups{ 0 };
+
+    void run() {
+        PipeMessage message;
+        while (running.load()) {
+            if (ring.TryRead(message)) {
+                received++;
+                try {
+                    if (messageHandler) messageHandler(message);
+                }
+                catch (const std::exception& ex) {
+                    write_error(ex, 1004);
+                }
+                catch (...) {
+                    write_error();
+                }
+                ring.Release();
+                continue;
+            }
+            if (!ring.Park()) continue;
+            WaitForSingleObject(hEvent, SHARED_RING_PARK_MS);
+            ring.Unpark();
+            wakeups++;
+        }
+        ring.Unpark();
+    }
+
+    void close() {
+        if (control) {
+            control->readerPid.store(0);
+            UnmapViewOfFile(control);
+            control = nullptr;
+        }
+        if (hMap) {
+            CloseHandle(hMap);
+            hMap = NULL;
+        }
+        if (hEvent) {
+            CloseHandle(hEvent);
+            hEvent = NULL;
+        }
+    }
+};
+
+// Service side. Not thread safe: the owner (ParentChannel) serializes calls,
+// which is what keeps the ring single-producer.
+class SharedRingWriter {
+public:
+    ~SharedRingWriter() {
+        Close();
+    }
+
+    // Fails if the app has not created the section (older app, or not up)
+    bool Open(const std::wstring& appTitle) {
+        Close();
+        hMap = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, GetRingName(appTitle).c_str());
+        if (!hMap) return false;
+        control = static_cast<RingControl*>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        hEvent = OpenEventW(EVENT_MODIFY_STATE, FALSE, GetRingEventName(appTitle).c_str());
+        if (!control || !hEvent || control->magic != SHARED_RING_MAGIC
+            || control->version != SHARED_RING_VERSION || control->readerPid.load() == 0) {
+            Close();
+            return false;
+        }
+        readerPid = control->readerPid.load();
+        hReader = OpenProcess(SYNCHRONIZE, FALSE, readerPid);
+        checkedAt = nowMs();
+        ring.Attach(control);
+        return true;
+    }
+
+    bool IsOpen() const { return control != nullptr; }
+
+    // No syscall unless the reader sleeps (SetEvent) or the liveness check
+    // is due. False: full, too large, or the reader is gone (then closed).
+    // end: ring position the reader releases once it has handled the record
+    bool TryWrite(const PipeMessage& message, uint64_t* end = nullptr) {
+        if (!control || !readerAlive()) return false;
+        if (!ring.TryWrite(message.command, message.data.data(), message.dataSize)) {
+            full++;
+            return false;
+        }
+        written++;
+        if (end) *end = ring.Published();
+        if (ring.ReaderParked()) {
+            SetEvent(hEvent);
+            wakeups++;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (control) {
+            UnmapViewOfFile(control);
+            control = nullptr;
+        }
+        if (hMap) {
+            CloseHandle(hMap);
+            hMap = NULL;
+        }
+        if (hEvent) {
+            CloseHandle(hEvent);
+            hEvent = NULL;
+        }
+        if (hReader) {
+            CloseHandle(hReader);
+            hReader = NULL;
+        }
+    }
+
+    // Ring position up to which the app has handled records; 0 when closed
+    uint64_t Released() const { return control ? ring.Consumed() : 0; }
+
+    uint64_t Written() const { return written; }
+    uint64_t Full() const { return full; }
+    uint64_t Wakeups() const { return wakeups; }
+
+private:
+    HANDLE hMap = NULL;
+    HANDLE hEvent = NULL;
+    HANDLE hReader = NULL;
+    RingControl* control = nullptr;
+    SpscRing ring;
+    uint32_t readerPid = 0;
+    int64_t checkedAt = 0;
+    uint64_t written = 0;
+    uint64_t full = 0;
+    uint64_t wakeups = 0;
+
+    // The app may exit (or be replaced by a new instance) while we hold the
+    // section; records written then would never be read
+    bool readerAlive() {
+        int64_t t = nowMs();
+        if (t - checkedAt < SHARED_RING_LIVENESS_MS) return true;
+        checkedAt = t;
+        bool alive = control->readerPid.load() == readerPid
+            && (!hReader || WaitForSingleObject(hReader, 0) == WAIT_TIMEOUT);
+        if (!alive) {
+            write_log(L"[Ring] ", L"reader gone, closing");
+            Close();
+        }
+        return alive;
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
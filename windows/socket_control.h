@@ -8,6 +8,19 @@
 #include "utils.h"
 #include "win_toast.h"
 #include "named_pipe_communication.h"
+#include "message_dispatcher.h"
+#include "parent_channel.h"
+#include "ipc_codec.h"
+#include "ipc_requests.h"
+#include "message_classifier.h"
+#include "message_dedup.h"
+#include "message_inbox.h"
+#include "resume_cursor.h"
+#include "ack_batcher.h"
+#include "reorder_buffer.h"
+#include "endpoint_selector.h"
+#include "topic_matcher.h"
+#include "routing_rules.h"
 
 #include <winrt/windows.system.threading.h>
 
@@ -17,6 +30,42 @@
 #define CMD_STOP_SERVICE      PIPE_CMD_STOP_SERVICE
 #define CMD_RECONNECT         PIPE_CMD_RECONNECT
 
+// Dispatch worker handling inbound messages off the socket thread. One:
+// socket frames share one dispatch key so they stay ordered across
+// migrations, and a key is always served by the same worker
+#define DISPATCH_WORKERS      1
+#define SOCKET_DISPATCH_KEY   L"socket"
+
+// Priority lanes (see MessagePriority): depth limit and weighted-mode share.
+// A full lane holds the socket reader until there is room (the server then
+// stalls on TCP flow control); nothing is dropped.
+#define LANE_HIGH_DEPTH       1024
+#define LANE_NORMAL_DEPTH     8192
+#define LANE_LOW_DEPTH        8192
+#define LANE_HIGH_WEIGHT      8
+#define LANE_NORMAL_WEIGHT    2
+#define LANE_LOW_WEIGHT       1
+
+// Make-before-break: how long the new connection has to answer its first ping,
+// and how long the old one stays open to drain in-flight frames
+#define MIGRATION_TIMEOUT_SEC 15
+#define MIGRATION_DRAIN_SEC   2
+
+// Hot standby: the standby is pinged every STANDBY_PING_TICKS heartbeats and
+// dropped after STANDBY_PONG_TIMEOUT_SEC of silence; re-created at most once
+// per STANDBY_RETRY_SEC. With a standby ready, the primary is declared dead
+// after STANDBY_FAILOVER_MS without a pong instead of 45 s.
+#define STANDBY_PING_TICKS       6
+#define STANDBY_PONG_TIMEOUT_SEC 90
+#define STANDBY_RETRY_SEC        60
+#define STANDBY_FAILOVER_MS      12000
+
+// Collapse keys remembered for superseding undelivered messages
+#define COLLAPSE_MAX_KEYS        1024
+
+// Endpoint health/latency summary is logged every this many heartbeats
+#define ENDPOINT_LOG_TICKS       12
+
 using namespace winrt;
 using namespace Windows::System::Threading;
 
@@ -24,7 +73,8 @@ using json = nlohmann::json;
 
 struct WebSocketControl
 {
-    WebSocketClient client;
+    // Current connection. Replaced atomically (under clientMutex) on migration
+    std::shared_ptr<WebSocketClient> client = std::make_shared<WebSocketClient>();
     std::wstring uri;
     std::wstring registerStr = L"";
     PluginSetting settings;
@@ -40,8 +90,101 @@ struct WebSocketControl
     ThreadPoolTimer reconnectTimer{ nullptr };
     std::mutex reconnectMutex;
 
+    // Connection being brought up by migrate(); promoted on its first pong
+    std::shared_ptr<WebSocketClient> candidate;
+    std::wstring candidateUri;
+    std::wstring candidateRegister;
+    ThreadPoolTimer migrationTimer{ nullptr };
+    std::mutex clientMutex; // guards client, candidate*, standby*, uri, registerStr
+
+    // Registered but quiet connection to the alternate endpoint, promoted
+    // when the current one fails; at most one
+    std::shared_ptr<WebSocketClient> standby;
+    std::wstring standbyUri;
+    std::atomic<bool> standbyConnecting{ false };
+    std::atomic<int64_t> lastStandbyPong{ 0 };
+    std::atomic<int64_t> nextStandbyAttempt{ 0 };
+    uint64_t heartbeatTicks = 0;
+
+    // Health and latency of every configured endpoint; picks where to
+    // (re)connect when the settings list several servers
+    EndpointSelector endpoints;
+    std::atomic<int64_t> lastPingSent{ 0 };
+
+    // Subscriptions compiled on settings update; unwanted topics never
+    // reach a lane, the pipe or a toast
+    TopicMatcher topics;
+    std::atomic<uint64_t> topicDropped{ 0 };
+    uint64_t lastLoggedTopicDropped = 0;
+
+    // Routing rules compiled on settings update, evaluated per message
+    RoutingRules rules;
+    std::atomic<uint64_t> routed[ROUTE_ACTIONS] = {};
+    uint64_t lastLoggedRouted = 0;
+    std::wstring lastLoggedRing;
+    std::wstring lastLoggedBatching;
+    std::wstring lastLoggedStreaming;
+    std::wstring lastLoggedPriority;
+    uint64_t lastLoggedPoolHits = 0;
+    // Collapse key -> last undelivered message (socket dispatch worker only)
+    std::unordered_map<std::string, InboxRef> collapsed;
+    std::atomic<uint64_t> standbyConnects{ 0 };
+    std::atomic<uint64_t> standbyPings{ 0 };
+    std::atomic<uint64_t> standbyFrames{ 0 };
+    std::atomic<uint64_t> standbyPromotions{ 0 };
+
+    uint64_t lastLoggedProcessed = 0;
+
+    MessageDedup dedup;
+    ResumeCursor resume;
+    // Sequenced frames queued in the lanes; the cursor and acks follow its
+    // low watermark, not each frame
+    SeqWatermark watermark;
+    // Acks go out on whichever connection is current
+    AckBatcher acks{ [this](const std::wstring& frame) {
+        auto c = current();
+        if (!c->isConnected()) return false;
+        c->send(frame);
+        return true;
+    } };
+    uint64_t lastLoggedAcks = 0;
+    // After what its commit callbacks use: its flusher stops before they go
+    MessageInbox inbox;
+
+    // Sequenced frames are put back in order per sender before they reach the
+    // lanes; priority lanes then reorder delivery on purpose
+    ReorderBuffer<InboundMessage> reorder;
+    std::mutex reorderMutex;
+    // Taken before reorderMutex is let go, held while the frames it let
+    // through are queued: the reader and the timer never interleave batches
+    std::mutex releaseMutex;
+    std::atomic<bool> reorderTimerArmed{ false };
+    ThreadPoolTimer reorderTimer{ nullptr }; // under reorderMutex
+    uint64_t lastLoggedReleased = 0;
+
+    // Declared last: destroyed first, so workers stop before the state they use
+    MessageDispatcher<InboundMessage> dispatcher{ DISPATCH_WORKERS, [this](DispatchItem<InboundMessage>& item) {
+        try {
+            _reveive(item.value);
+        }
+        catch (...) {
+            write_log(L"[DISPATCH] ", L"handler failed");
+        }
+        // A frame that stopped early still must not hold the watermark back
+        settle(item.value, false);
+    }, {
+        LaneConfig{ LANE_HIGH_DEPTH, LANE_HIGH_WEIGHT },
+        LaneConfig{ LANE_NORMAL_DEPTH, LANE_NORMAL_WEIGHT },
+        LaneConfig{ LANE_LOW_DEPTH, LANE_LOW_WEIGHT },
+    }, LaneScheduling::Weighted };
+
     WebSocketControl() = default;
 
+    // Batched events report their delivery back into this object
+    ~WebSocketControl() {
+        g_parentChannel.FlushEvents();
+    }
+
     WebSocketControl(std::wstring const& url) {
         updateUri(url);
     }
@@ -64,9 +207,11 @@ struct WebSocketControl
                     return;
                 }
 
-                if (client.isConnected()) {
+                auto c = current();
+                if (c->isConnected()) {
                     json j = PingModel{ "ping" };
                     try {
+                        lastPingSent = now();
                         send(utf8_to_wide(j.dump()));
                     }
                     catch (...) {
@@ -74,15 +219,28 @@ struct WebSocketControl
                     }
 
                     int64_t diff = now() - lastPong.load();
-                    if (diff > 15000 * 3) { // >45s không có pong
-                        write_log(L"[HEARTBEAT] ", L"no pong → reconnect");
-                        client.disconnect();
-                        reconnect();
+                    int64_t limit = standbyReady() ? STANDBY_FAILOVER_MS : 15000 * 3; // >45s không có pong
+                    if (diff > limit) {
+                        write_log(L"[HEARTBEAT] ", L"no pong → failover / reconnect");
+                        if (!promoteStandby()) {
+                            c->disconnect();
+                            reconnect();
+                        }
                     }
                 }
                 else {
                     write_log(L"[HEARTBEAT] ", L"no connection");
+                    promoteStandby();
                 }
+
+                tickStandby();
+                if (heartbeatTicks % ENDPOINT_LOG_TICKS == 0 && endpoints.Size() > 1) {
+                    write_log(L"[ENDPOINTS] ", winrt::hstring(endpoints.Describe()));
+                }
+                logDispatchStats();
+                g_parentChannel.PollRing();
+                dedup.Flush();
+                resume.Flush();
             },
             std::chrono::seconds(5) // tick mỗi 5s
         );
@@ -105,61 +263,158 @@ struct WebSocketControl
             reconnectTimer = nullptr;
             write_log(L"[RECONNECT] reset timer (debounce)");
         }
+        cancelReorderTimer();
 
-        client.disconnect();
+        dropCandidate();
+        dropStandby();
+        current()->disconnect();
     }
 
-    void _reveive(std::wstring msg) {
-        // Try to send SOCKET_EVENT message to parent process via Named Pipe
-        std::wstring pipeName = GetPipeName(utf8_to_wide(settings.title));
-        NamedPipeClient pipeClient(pipeName);
-        
-        if (pipeClient.Connect()) {
-            // Create SOCKET_EVENT message (matching diagram)
-            SocketEventMessage socketEventMsg;
-            socketEventMsg.event = "MESSAGE";
-            socketEventMsg.payload = wide_to_utf8(msg);
-            socketEventMsg.id = "e1"; // Event ID
-            
-            std::string eventJson = toJson(socketEventMsg);
-            PipeMessage message(PROTOCOL_SOCKET_EVENT, eventJson);
-            
-            if (pipeClient.SendMessage(message)) {
-                write_log(L"[App Actived]", msg);
-                write_log(L"[DEBUG] ", (std::wstring(L"SOCKET_EVENT JSON: ") + utf8_to_wide(eventJson)).c_str());
+    void onPong() {
+        if (!firstPong.exchange(true)) {
+            write_log(L"[HEARTBEAT] first pong received\n");
+            write_log(L"[HEARTBEAT] send reconnect\n");
+            InboundMessage m;
+            m.kind = FrameKind::Reconnect;
+            m.raw = L"reconnect";
+            dispatcher.post(SOCKET_DISPATCH_KEY, std::move(m));
+        }
+        lastPong = now();
+        int64_t sent = lastPingSent.exchange(0);
+        if (sent) endpoints.ReportRtt(currentUri(), lastPong.load() - sent);
+        write_log( L"[HEARTBEAT] pong received\n");
+    }
+
+    // spilled: the frame found its lane full and is handled on the reader's
+    // thread as store-only (see spill)
+    void _reveive(InboundMessage& m, bool spilled = false) {
+        // Pong có khóa không nằm đầu frame chỉ được nhận ra sau khi parse
+        if (m.kind == FrameKind::Data && m.parse() && m.kind == FrameKind::Pong) {
+            onPong();
+            return;
+        }
+
+        // Bản sao (server gửi lại khi reconnect): bỏ trước mọi IPC / toast
+        if (m.parsed && m.response.data && m.response.data->id) {
+            if (dedup.CheckAndInsert(*m.response.data->id)) {
+                // Already stored once: ack again so the server stops resending
+                settle(m, true);
+                write_log(L"[Dedup] drop duplicate ", winrt::hstring(utf8_to_wide(*m.response.data->id)));
                 return;
             }
         }
-        
-        // Fallback: try to find window (for backward compatibility)
-        HWND hwnd = FindWindow(NULL, utf8_to_wide(settings.title).c_str());
-        if (hwnd && IsWindow(hwnd)) {
+
+        RouteAction action = RouteAction::Deliver;
+        std::string collapseKey;
+        if (m.kind == FrameKind::Data && m.parsed) {
+            std::string type = stringField(m.doc, "Type", "type");
+            std::string tag = stringField(m.doc, "Tag", "tag");
+            action = rules.Evaluate(RouteFacts{ type, tag, m.priority, m.topic });
+            if (action == RouteAction::Collapse) collapseKey = !tag.empty() ? tag : !type.empty() ? type : wide_to_utf8(m.topic);
+        }
+        if (spilled && action != RouteAction::Drop) action = RouteAction::StoreOnly;
+        routed[static_cast<size_t>(action)]++;
+        if (action == RouteAction::Drop) {
+            settle(m, true);
+            return;
+        }
+        deliver(m, action, collapseKey);
+    }
+
+    // Stores, acks and hands one accepted message to the app (or a toast)
+    void deliver(InboundMessage& m, RouteAction action = RouteAction::Deliver, std::string const& collapseKey = "") {
+        std::wstring& msg = m.raw;
+        std::string payload = wide_to_utf8(msg);
+
+        // Every accepted message goes to the durable inbox first; it is flagged
+        // consumed once the app has it, otherwise the app drains it on start
+        InboxRef stored;
+        if (m.kind != FrameKind::Reconnect) {
+            stored = inbox.Append(payload);
+            if (stored.seq && m.parsed) settleAfterCommit(m, stored);
+            else settle(m, false);
+        }
+
+        // Store-only: the app picks it up from the inbox, nothing is woken now
+        if (action == RouteAction::StoreOnly) {
+            return;
+        }
+        if (action == RouteAction::Toast) {
+            MessageInbox::MarkConsumed(stored);
+            showToast(m);
+            return;
+        }
+
+        if (action == RouteAction::Collapse && !collapseKey.empty() && stored.seq) {
+            // Chỉ giữ bản mới nhất chưa giao cho mỗi collapse key: bản cũ
+            // trong inbox bị thay thế dù app có nhận bản mới hay không
+            auto it = collapsed.find(collapseKey);
+            if (it != collapsed.end()) {
+                MessageInbox::MarkConsumed(it->second);
+                it->second = stored;
+            }
+            else {
+                if (collapsed.size() >= COLLAPSE_MAX_KEYS) collapsed.clear();
+                collapsed.emplace(collapseKey, stored);
+            }
+        }
+
+        // Send SOCKET_EVENT message to parent process over the persistent channel
+        SocketEventMessage socketEventMsg;
+        socketEventMsg.event = "MESSAGE";
+        socketEventMsg.payload = payload;
+        socketEventMsg.id = stored.seq ? std::to_string(stored.seq) : "e1"; // Event ID
+
+        // Encoded into a per-thread buffer, copied once into a pooled one
+        thread_local std::string encoded;
+        encodeIpcFor(socketEventMsg, g_parentChannel.PeerCodec(), encoded);
+        PipeMessage message(PROTOCOL_SOCKET_EVENT, encoded);
+
+        // Consumed only once the app has it: a batched event learns that when
+        // its batch is written, a ring event when the app has handled it,
+        // both possibly after Send returns and on another thread. Otherwise
+        // the record stays in the inbox and the fallbacks run.
+        bool reconnect = m.kind == FrameKind::Reconnect;
+        g_parentChannel.Send(message, [this, stored, reconnect, raw = std::move(msg)](bool delivered) mutable {
+            if (delivered) {
+                MessageInbox::MarkConsumed(stored);
+                write_log(L"[App Actived]", raw);
+                return;
+            }
+            deliverFallback(raw, reconnect, stored);
+        });
+    }
+
+    // The channel could not deliver: WM_COPYDATA to the app's window (for
+    // backward compatibility), else a toast from the stored text
+    void deliverFallback(std::wstring& msg, bool reconnect, const InboxRef& stored) {
+        HWND hwnd = g_parentChannel.Window();
+        if (hwnd) {
             COPYDATASTRUCT cds;
             cds.dwData = 1;
             cds.cbData = (DWORD)(wcslen(msg.c_str()) + 1) * sizeof(wchar_t);
             cds.lpData = (PVOID)msg.c_str();
             SendMessageW(hwnd, WM_COPYDATA, (WPARAM)GetCurrentProcessId(), (LPARAM)&cds);
+            MessageInbox::MarkConsumed(stored);
             write_log(L"[App Actived]", msg);
             return;
         }
-        if (msg == L"reconnect") {
+        if (reconnect) {
             write_log(L"[Sen Reconnect Miss] ", uri);
             return;
         }
-        MessageResponse p;
-        try {
-            json j = json::parse(msg);
-            p = j.get<MessageResponse>();
-        }
-        catch (const std::exception& ex) {
-            write_log(L"[Received] std::exception: ", winrt::hstring(utf8_to_wide(ex.what())));
-            return;
-        }
-        catch (...) {
-            write_log(L"[Received]", L"Unknown parse error");
+        InboundMessage m;
+        m.raw = std::move(msg);
+        m.parse();
+        showToast(m);
+    }
+
+    void showToast(InboundMessage& m) {
+        std::wstring& msg = m.raw;
+        if (!m.parsed) {
             return;
         }
-        auto notification = p.notification;
+        auto& notification = m.response.notification;
         if (!notification) {
             return;
         }
@@ -179,57 +434,32 @@ struct WebSocketControl
     void connect()
     {
         std::scoped_lock g(lock);
-        write_log(L"[CONNECT] ", uri);
+        auto c = current();
+        std::wstring u, r;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            u = uri;
+            r = registerStr;
+        }
+        write_log(L"[CONNECT] ", u);
         firstPong = false;
-        client.connect(uri);
+        wire(c);
+        int64_t started = now();
+        bool ok = c->connect(u);
+        endpoints.ReportConnect(u, ok, now() - started);
+        if (!ok) {
+            write_log(L"[CONNECT] failed ", u);
+            reconnect();
+            return;
+        }
         try {
-            client.send(registerStr);
+            c->send(withResumeCursor(r));
             write_log(L"[register]", L"success");
         }
         catch (...) {
             write_log(L"[register]", L"failure");
         }
-
-        client.onMessage = [this](std::wstring msg)
-            {
-                write_log(L"contrl received", msg);
-                PongModel p = {};
-                try {
-                    json j = json::parse(msg);
-                    p = j.get<PongModel>();
-                }
-                catch (const std::exception& ex) {
-                    write_log(L"[onMessage] parse error", winrt::hstring(utf8_to_wide(ex.what())));
-                }
-                catch (...) {
-                    write_log(L"[onMessage] parse error: unknown");
-                }
-                if (p.pong)
-                {
-                    if (!firstPong.exchange(true)) {
-                        write_log(L"[HEARTBEAT] first pong received\n");
-                        write_log(L"[HEARTBEAT] send reconnect\n");
-                        _reveive(L"reconnect");
-                    }
-                    lastPong = now();
-                    write_log( L"[HEARTBEAT] pong received\n");
-                }
-                else
-                {
-                    write_log(L"[RECV] ", msg);
-                    _reveive(msg);
-                }
-            };
-
-        client.onClosed = [this](uint16_t code, std::wstring reason)
-            {
-                std::wstringstream err;
-                err << code << L" reason=" << reason;
-                write_log(L"[CLOSED] code=", winrt::hstring(err.str()));
-                // TODO(hodoan): handle this
-                reconnect();
-            };
-        write_log(L"[CONNECTION CONNECTED] ", uri);
+        write_log(L"[CONNECTION CONNECTED] ", u);
 
         startHeartbeat();
     }
@@ -237,7 +467,7 @@ struct WebSocketControl
     void disconnect()
     {
         std::scoped_lock g(lock);
-        client.disconnect();
+        current()->disconnect();
     }
 
     void reconnect()
@@ -271,7 +501,9 @@ struct WebSocketControl
                 }
 
                 write_log(L"[RECONNECT] executing...");
+                reconnecting = false;
                 stopHeartbeat();
+                selectEndpoint();
                 connect();
             },
             std::chrono::seconds(3)
@@ -281,36 +513,646 @@ struct WebSocketControl
     }
 
     void updateSettings(PluginSetting _settings) {
-        std::scoped_lock g(lock);
-        auto oldregisterStr = registerStr;
-        auto oldUri= uri;
-        json j = settings;
-        json j2 = _settings;
-        std::stringstream ss;
-        ss << "oldSetting: " << j.dump() << "\nnewSetting: " << j2.dump() << "\n";
-        auto sss = ss.str();
-        write_log(L"[Change Settings] ", winrt::hstring(utf8_to_wide(sss)));
-        settings = _settings;
-        if (uri != oldUri && registerStr != oldregisterStr) {
-            updateUri(settings.uri());
+        std::wstring newUri;
+        std::wstring newRegister;
+        std::wstring newStandby;
+        bool affinity;
+        {
+            std::scoped_lock g(lock);
+            json j = settings;
+            json j2 = _settings;
+            std::stringstream ss;
+            ss << "oldSetting: " << j.dump() << "\nnewSetting: " << j2.dump() << "\n";
+            auto sss = ss.str();
+            write_log(L"[Change Settings] ", winrt::hstring(utf8_to_wide(sss)));
+            settings = _settings;
+            g_parentChannel.SetTitle(utf8_to_wide(settings.title));
+            g_parentChannel.ConfigureBatching(settings.ipc_batch_window_us,
+                settings.ipc_batch_max_count, settings.ipc_batch_max_bytes);
+            g_parentChannel.ConfigureStreaming(settings.ipc_max_message_bytes);
+            dedup.SetHorizon(settings.dedup_horizon_sec);
+            resume.SetKey(settings.connector_id);
+            acks.Configure(settings.ack_window_ms, settings.ack_max_count);
+            topics.Compile(settings.subscriptions, settings.connector_tag, settings.connector_id);
+            rules.Compile(settings.rules, settings.connector_tag, settings.connector_id);
+            dispatcher.setScheduling(settings.priority_scheduling == "strict"
+                ? LaneScheduling::Strict : LaneScheduling::Weighted);
+            affinity = settings.endpoint_selection == "affinity";
+            endpoints.SetMode(affinity ? EndpointSelection::Affinity : EndpointSelection::Latency,
+                settings.connector_id + "/" + wide_to_utf8(get_sys_device_id()));
+            endpoints.SetEndpoints(settings.endpointUris());
+            newUri = endpoints.Pick();
+            newRegister = settings.registerStr();
+            newStandby = settings.standbyUri();
+        }
+
+        bool connected;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            // Stay on the current endpoint while it is still listed; with
+            // affinity, move when the home node changed (node added/removed)
+            if (!affinity && endpoints.Contains(uri)) newUri = uri;
+            // After a failover the two endpoints are swapped: same pair, no change
+            bool swapped = !standbyUri.empty() && newUri == standbyUri && newStandby == uri;
+            bool same = (newUri == uri && newStandby == standbyUri) || swapped;
+            if (same && newRegister == registerStr) return;
+            if (swapped) newUri = uri; // stay on the promoted endpoint
+            else standbyUri = newStandby;
+        }
+        // Endpoints or registration changed: the standby is re-created to match
+        dropStandby();
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            if (newUri == uri && newRegister == registerStr) return;
+            connected = client->isConnected();
+            if (!connected) {
+                registerStr = newRegister;
+            }
         }
+        if (!connected) {
+            // Chưa có kết nối nào để giữ: kết nối thẳng
+            updateUri(newUri);
+            return;
+        }
+        migrate(newUri, newRegister);
     }
 
     void send(std::wstring const& msg)
     {
-        client.send(msg);
+        current()->send(msg);
     }
 
 private:
+    void logDispatchStats() {
+        // Filtered frames never reach the dispatcher: logged on their own
+        uint64_t dropped = topicDropped.load();
+        if (dropped != lastLoggedTopicDropped) {
+            lastLoggedTopicDropped = dropped;
+            write_log(L"[TOPICS] dropped ", winrt::hstring(std::to_wstring(dropped)));
+        }
+
+        DispatchStats s = dispatcher.stats();
+        if (s.processed == lastLoggedProcessed) return;
+        lastLoggedProcessed = s.processed;
+        std::wstringstream ss;
+        ss << L"enqueued=" << s.enqueued << L" processed=" << s.processed
+            << L" queueAvgUs=" << (s.processed ? s.queueLatencyTotalUs / s.processed : 0)
+            << L" queueMaxUs=" << s.queueLatencyMaxUs
+            << L" handlerAvgUs=" << (s.processed ? s.handlerTotalUs / s.processed : 0)
+            << L" handlerMaxUs=" << s.handlerMaxUs;
+        write_log(L"[DISPATCH] ", winrt::hstring(ss.str()));
+
+        static const wchar_t* laneNames[] = { L"high", L"normal", L"low" };
+        std::wstringstream ls;
+        for (size_t i = 0; i < s.lanes.size() && i < PRIORITY_LANES; i++) {
+            const LaneStats& l = s.lanes[i];
+            ls << laneNames[i] << L"{n=" << l.processed << L" dropped=" << l.dropped << L" spilled=" << l.spilled
+                << L" queueAvgUs=" << (l.processed ? l.queueLatencyTotalUs / l.processed : 0)
+                << L" queueMaxUs=" << l.queueLatencyMaxUs << L"} ";
+        }
+        write_log(L"[LANES] ", winrt::hstring(ls.str()));
+
+        uint64_t sentAcks = acks.AcksSent();
+        if (sentAcks != lastLoggedAcks) {
+            lastLoggedAcks = sentAcks;
+            std::wstringstream as;
+            as << L"acks=" << sentAcks << L" frames=" << acks.FramesSent();
+            write_log(L"[ACK] ", winrt::hstring(as.str()));
+        }
+
+        std::wstringstream rt;
+        rt << L"deliver=" << routed[0].load() << L" toast=" << routed[1].load() << L" store=" << routed[2].load()
+            << L" drop=" << routed[3].load() << L" collapse=" << routed[4].load();
+        uint64_t routedTotal = 0;
+        for (auto& r : routed) routedTotal += r.load();
+        if (routedTotal != lastLoggedRouted) {
+            lastLoggedRouted = routedTotal;
+            write_log(L"[ROUTE] ", winrt::hstring(rt.str()));
+        }
+
+        std::wstring ring = g_parentChannel.DescribeRing();
+        if (ring != lastLoggedRing) {
+            lastLoggedRing = ring;
+            write_log(L"[RING] ", winrt::hstring(ring));
+        }
+
+        std::wstring batching = g_parentChannel.DescribeBatching();
+        if (batching != lastLoggedBatching) {
+            lastLoggedBatching = batching;
+            write_log(L"[IPC BATCH] ", winrt::hstring(batching));
+        }
+
+        std::wstring streaming = g_parentChannel.DescribeStreaming();
+        if (streaming != lastLoggedStreaming) {
+            lastLoggedStreaming = streaming;
+            write_log(L"[IPC STREAM] ", winrt::hstring(streaming));
+        }
+
+        std::wstring priority = g_parentChannel.DescribePriority();
+        if (priority != lastLoggedPriority) {
+            lastLoggedPriority = priority;
+            write_log(L"[IPC PRIORITY] ", winrt::hstring(priority));
+        }
+
+        uint64_t poolHits = BufferPool::Instance().Stats().hits;
+        if (poolHits != lastLoggedPoolHits) {
+            lastLoggedPoolHits = poolHits;
+            write_log(L"[POOL] ", winrt::hstring(BufferPool::Instance().Describe()));
+        }
+
+        ReorderStats r = reorder.stats();
+        if (r.released != lastLoggedReleased) {
+            lastLoggedReleased = r.released;
+            std::wstringstream rs;
+            rs << L"released=" << r.released << L" delayed=" << r.delayed
+                << L" holdAvgUs=" << (r.delayed ? r.holdTotalUs / r.delayed : 0)
+                << L" holdMaxUs=" << r.holdMaxUs << L" gaps=" << r.gaps << L" held=" << r.held
+                << L" duplicates=" << r.duplicates;
+            write_log(L"[REORDER] ", winrt::hstring(rs.str()));
+        }
+    }
+
+    // Arms the timeout for held frames and asks the server to replay gaps
+    void afterReorder(const std::vector<ReorderGap>& gaps) {
+        for (auto& g : gaps) {
+            std::wstringstream ss;
+            ss << g.from << L"-" << g.to;
+            write_log(L"[REORDER] gap, requesting resume ", winrt::hstring(ss.str()));
+        }
+        if (!gaps.empty()) {
+            // Re-register with the cursor just before the first gap. The
+            // replay resends what followed it too; the reorder buffer lets
+            // through only the Seqs still missing and drops the rest
+            std::wstring r;
+            {
+                std::lock_guard<std::mutex> lk(clientMutex);
+                r = registerStr;
+            }
+            std::wstring frame = withResumeCursor(r, gaps.front().from - 1);
+            // send() can block: never on the receive thread
+            ThreadPool::RunAsync([this, frame](Windows::Foundation::IAsyncAction const&) {
+                try {
+                    auto c = current();
+                    if (c->isConnected()) c->send(frame);
+                }
+                catch (...) {
+                    write_log(L"[REORDER] ", L"resume request failed");
+                }
+            });
+        }
+        if (stopFlag || !reorder.HasHeld() || reorderTimerArmed.exchange(true)) return;
+        std::lock_guard<std::mutex> lk(reorderMutex);
+        reorderTimer = ThreadPoolTimer::CreateTimer(
+            [this](ThreadPoolTimer const&) {
+                reorderTimerArmed = false;
+                if (stopFlag) return;
+                std::vector<InboundMessage> ready;
+                std::vector<ReorderGap> expired;
+                {
+                    std::unique_lock<std::mutex> lk(reorderMutex);
+                    reorder.Expire([&ready](InboundMessage& r) { ready.push_back(std::move(r)); }, expired);
+                    release(ready, lk);
+                }
+                afterReorder(expired);
+            },
+            std::chrono::milliseconds(REORDER_TIMEOUT_MS));
+    }
+
+    void cancelReorderTimer() {
+        std::lock_guard<std::mutex> lk(reorderMutex);
+        if (reorderTimer) {
+            reorderTimer.Cancel();
+            reorderTimer = nullptr;
+        }
+        reorderTimerArmed = false;
+    }
+
+    // Frames ahead of the expected Seq wait for their predecessors; the rest
+    // go straight to their lane
+    void accept(InboundMessage m) {
+        if (!m.seq) {
+            enqueue(std::move(m));
+            return;
+        }
+        int64_t last = resume.Get();
+        std::wstring key = resume.Key();
+        std::vector<InboundMessage> ready;
+        std::vector<ReorderGap> gaps;
+        {
+            std::unique_lock<std::mutex> lk(reorderMutex);
+            int64_t seq = *m.seq;
+            reorder.Push(key, seq, last > 0 ? last + 1 : 0, std::move(m),
+                [&ready](InboundMessage& r) { ready.push_back(std::move(r)); }, gaps);
+            release(ready, lk);
+        }
+        afterReorder(gaps);
+    }
+
+    // Queues what the reorder stage let through, in order, with reorderMutex
+    // already released
+    void release(std::vector<InboundMessage>& ready, std::unique_lock<std::mutex>& reorderLock) {
+        if (ready.empty()) return;
+        std::lock_guard<std::mutex> order(releaseMutex);
+        reorderLock.unlock();
+        for (auto& r : ready) enqueue(std::move(r));
+    }
+
+    void enqueue(InboundMessage m) {
+        // After the reorder stage, so a filtered Seq is not seen as a gap.
+        // Acked and past the cursor: the server will not send it again.
+        if (!topics.Matches(m.topic)) {
+            topicDropped++;
+            settle(m, true);
+            return;
+        }
+        size_t lane = static_cast<size_t>(m.priority);
+        if (m.seq) watermark.Admit(*m.seq);
+        if (dispatcher.offer(SOCKET_DISPATCH_KEY, m, lane)) return;
+        spill(m);
+    }
+
+    // Lane full: the reader never waits for a worker. Pongs must keep being
+    // read, and a full low lane must not hold back a high frame behind it.
+    // The frame is stored and acked like any other, store-only: the app gets
+    // it on its next inbox drain instead of now.
+    void spill(InboundMessage& m) {
+        try {
+            _reveive(m, true);
+        }
+        catch (...) {
+            write_log(L"[DISPATCH] ", L"spill failed");
+        }
+        settle(m, false);
+    }
+
+    // Done with a frame: the cursor and its ack (ack = the server may forget
+    // it) move once every sequenced frame queued before it is done too
+    void settle(InboundMessage& m, bool ack) {
+        if (m.settled) return;
+        m.settled = true;
+        complete(m.seq, m.response.data ? m.response.data->id : std::nullopt, ack);
+    }
+
+    // Stored in the inbox: acked once the group commit has it on disk, since
+    // the server does not resend what was acked. Whatever the ack window.
+    void settleAfterCommit(InboundMessage& m, InboxRef const& stored) {
+        if (m.settled) return;
+        m.settled = true;
+        std::optional<std::string> id = m.response.data ? m.response.data->id : std::nullopt;
+        inbox.AfterCommit(stored, [this, seq = m.seq, id = std::move(id)]() mutable {
+            complete(seq, std::move(id), true);
+        });
+    }
+
+    void complete(std::optional<int64_t> seq, std::optional<std::string> id, bool ack) {
+        if (!seq) {
+            if (ack) acks.Add(std::nullopt, id);
+            return;
+        }
+        watermark.Complete(*seq, std::move(id), ack, [this](const SeqWatermark::Done& d) {
+            resume.Advance(d.seq);
+            if (d.ack) acks.Add(d.seq, d.id);
+        });
+    }
+
     void updateUri(std::wstring const& newUri)
     {
-        std::scoped_lock g(lock);
         write_log(L"[UPDATE URI] ", winrt::hstring(newUri));
-        uri = newUri;
-        client.disconnect();
-        // TODO(hodoan): handle thís
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            uri = newUri;
+        }
+        current()->disconnect();
         reconnect();
     }
+
+    // Register frame with the stored cursor, so the server sends only the gap.
+    // after >= 0 asks for a replay after that Seq instead; standby marks the
+    // registration as a quiet hot standby.
+    std::wstring withResumeCursor(std::wstring const& reg, int64_t after = -1, bool standby = false) {
+        if (reg.empty()) return reg;
+        try {
+            RegisterModel model = json::parse(wide_to_utf8(reg)).get<RegisterModel>();
+            int64_t last = after >= 0 ? after : resume.Get();
+            if (last > 0 || after >= 0) model.data.lastSeq = last;
+            if (standby) model.data.standby = true;
+            json j = model;
+            return utf8_to_wide(j.dump());
+        }
+        catch (...) {
+            write_log(L"[register] ", L"cannot add resume cursor");
+            return reg;
+        }
+    }
+
+    static std::string stringField(const json& doc, const char* key, const char* alt) {
+        if (!doc.is_object()) return "";
+        auto it = doc.find(key);
+        if (it == doc.end()) it = doc.find(alt);
+        return it != doc.end() && it->is_string() ? it->get<std::string>() : "";
+    }
+
+    std::wstring currentUri() {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return uri;
+    }
+
+    // Before a reconnect: the selector may prefer another endpoint now
+    void selectEndpoint() {
+        if (endpoints.Size() < 2) return;
+        std::wstring next = endpoints.Pick();
+        std::lock_guard<std::mutex> lk(clientMutex);
+        if (next.empty() || next == uri) return;
+        write_log(L"[ENDPOINTS] switching to ", next);
+        uri = next;
+    }
+
+    std::shared_ptr<WebSocketClient> current() {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return client;
+    }
+
+    bool isCurrent(WebSocketClient* c) {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return client.get() == c;
+    }
+
+    bool isCandidate(WebSocketClient* c) {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return candidate && candidate.get() == c;
+    }
+
+    bool isStandby(WebSocketClient* c) {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return standby && standby.get() == c;
+    }
+
+    bool standbyReady() {
+        std::lock_guard<std::mutex> lk(clientMutex);
+        return standby && standby->isConnected();
+    }
+
+    // Heartbeat side of the standby: sparse pings, liveness, re-creation
+    void tickStandby() {
+        heartbeatTicks++;
+        std::shared_ptr<WebSocketClient> s;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            s = standby;
+        }
+        if (!s) {
+            ensureStandby();
+        }
+        else if (now() - lastStandbyPong.load() > STANDBY_PONG_TIMEOUT_SEC * 1000) {
+            write_log(L"[STANDBY] ", L"no pong, dropped");
+            dropStandby();
+        }
+        else if (heartbeatTicks % STANDBY_PING_TICKS == 0) {
+            json j = PingModel{ "ping" };
+            s->send(utf8_to_wide(j.dump()));
+            standbyPings++;
+        }
+
+        std::wstringstream ss;
+        ss << L"up=" << (s ? 1 : 0) << L" connects=" << standbyConnects.load()
+            << L" pings=" << standbyPings.load() << L" frames=" << standbyFrames.load()
+            << L" promotions=" << standbyPromotions.load();
+        if (s || standbyConnects.load()) write_log(L"[STANDBY] ", winrt::hstring(ss.str()));
+    }
+
+    void ensureStandby() {
+        std::wstring target, reg;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            if (standby || standbyUri.empty() || registerStr.empty() || candidate) return;
+            target = standbyUri;
+            reg = registerStr;
+        }
+        int64_t t = now();
+        if (t < nextStandbyAttempt.load() || standbyConnecting.exchange(true)) return;
+        nextStandbyAttempt = t + STANDBY_RETRY_SEC * 1000;
+
+        auto c = std::make_shared<WebSocketClient>();
+        wire(c);
+        // ConnectAsync chờ tới 20s: không chặn heartbeat
+        ThreadPool::RunAsync([this, c, target, reg](Windows::Foundation::IAsyncAction const&) {
+            if (c->connect(target)) {
+                c->send(withResumeCursor(reg, -1, true));
+                bool keep;
+                {
+                    std::lock_guard<std::mutex> lk(clientMutex);
+                    keep = !stopFlag && !standby && standbyUri == target && registerStr == reg;
+                    if (keep) standby = c;
+                }
+                if (keep) {
+                    lastStandbyPong = now();
+                    standbyConnects++;
+                    write_log(L"[STANDBY] ready ", winrt::hstring(target));
+                }
+                else {
+                    c->disconnect();
+                }
+            }
+            standbyConnecting = false;
+        });
+    }
+
+    // Failover: the standby becomes current and registers for real; the
+    // server replays after the cursor and dedup drops what was already seen
+    bool promoteStandby() {
+        std::shared_ptr<WebSocketClient> old, s;
+        std::wstring reg, newUri;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            if (stopFlag || candidate || !standby || !standby->isConnected()) return false;
+            old = client;
+            s = standby;
+            client = standby;
+            standby = nullptr;
+            std::swap(uri, standbyUri); // the failed endpoint becomes the standby target
+            reg = registerStr;
+            newUri = uri;
+        }
+        standbyPromotions++;
+        nextStandbyAttempt = 0;
+        firstPong = true;
+        lastPong = now();
+        write_log(L"[STANDBY] promoted ", newUri);
+
+        ThreadPool::RunAsync([this, old, s, reg](Windows::Foundation::IAsyncAction const&) {
+            old->disconnect();
+            try {
+                s->send(withResumeCursor(reg));
+            }
+            catch (...) {
+                write_log(L"[STANDBY] ", L"register after promotion failed");
+            }
+        });
+        return true;
+    }
+
+    void dropStandby() {
+        std::shared_ptr<WebSocketClient> s;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            s = std::move(standby);
+            standby = nullptr;
+        }
+        if (s) s->disconnect();
+    }
+
+    void wire(const std::shared_ptr<WebSocketClient>& c) {
+        WebSocketClient* raw = c.get();
+        c->onMessage = [this, raw](std::wstring msg)
+            {
+                onFrame(raw, std::move(msg));
+            };
+
+        c->onClosed = [this, raw](uint16_t code, std::wstring reason)
+            {
+                std::wstringstream err;
+                err << code << L" reason=" << reason;
+                write_log(L"[CLOSED] code=", winrt::hstring(err.str()));
+                // Kết nối cũ (đang drain), candidate hoặc standby đóng: không reconnect
+                if (!isCurrent(raw)) {
+                    if (isCandidate(raw)) abandonCandidate(raw);
+                    else if (isStandby(raw)) dropStandby();
+                    return;
+                }
+                endpoints.ReportClosed(currentUri());
+                // Primary gone: the standby takes over without a reconnect
+                if (!promoteStandby()) reconnect();
+            };
+    }
+
+    void onFrame(WebSocketClient* source, std::wstring msg) {
+        write_log(L"contrl received", msg);
+        // Prefix scan only; data frames are parsed once on the dispatch worker
+        InboundMessage m = makeInboundMessage(std::move(msg));
+        switch (m.kind) {
+        case FrameKind::Pong:
+            if (isCandidate(source)) {
+                promoteCandidate(source);
+            }
+            else if (isCurrent(source)) {
+                onPong();
+            }
+            else if (isStandby(source)) {
+                lastStandbyPong = now();
+            }
+            break;
+        case FrameKind::Ping:
+            write_log(L"[HEARTBEAT] ", L"ping from server ignored");
+            break;
+        default:
+            // Frames from the old, new, standby and current connection all go
+            // through; dedup drops the overlap during a migration or failover
+            write_log(L"[RECV] ", m.raw);
+            if (isStandby(source)) standbyFrames++;
+            // Không xử lý trên receive thread: pong phải luôn được đọc kịp
+            accept(std::move(m));
+            break;
+        }
+    }
+
+    // Make-before-break: connect and register the new endpoint while the
+    // current connection keeps delivering, switch on the new one's first pong.
+    void migrate(std::wstring const& newUri, std::wstring const& newRegister) {
+        dropCandidate();
+        auto c = std::make_shared<WebSocketClient>();
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            candidate = c;
+            candidateUri = newUri;
+            candidateRegister = newRegister;
+        }
+        wire(c);
+        write_log(L"[MIGRATE] connecting ", winrt::hstring(newUri));
+
+        // ConnectAsync chờ tới 20s: không chặn thread gọi updateSettings
+        ThreadPool::RunAsync([this, c, newUri, newRegister](Windows::Foundation::IAsyncAction const&) {
+            if (!c->connect(newUri)) {
+                abandonCandidate(c.get());
+                return;
+            }
+            c->send(withResumeCursor(newRegister));
+            json j = PingModel{ "ping" };
+            c->send(utf8_to_wide(j.dump()));
+
+            std::scoped_lock lk(reconnectMutex);
+            if (migrationTimer) migrationTimer.Cancel();
+            migrationTimer = ThreadPoolTimer::CreateTimer(
+                [this, raw = c.get()](ThreadPoolTimer const&) {
+                    if (isCandidate(raw)) {
+                        write_log(L"[MIGRATE] ", L"no pong from new endpoint");
+                        abandonCandidate(raw);
+                    }
+                },
+                std::chrono::seconds(MIGRATION_TIMEOUT_SEC));
+        });
+    }
+
+    void promoteCandidate(WebSocketClient* source) {
+        std::shared_ptr<WebSocketClient> old;
+        std::wstring newUri;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            if (!candidate || candidate.get() != source) return;
+            old = client;
+            client = candidate;
+            candidate = nullptr;
+            uri = candidateUri;
+            registerStr = candidateRegister;
+            newUri = uri;
+        }
+        {
+            std::scoped_lock lk(reconnectMutex);
+            if (migrationTimer) {
+                migrationTimer.Cancel();
+                migrationTimer = nullptr;
+            }
+        }
+        // Không có khoảng trống nào: app không cần biết là đã reconnect
+        firstPong = true;
+        lastPong = now();
+        write_log(L"[MIGRATE] switched to ", newUri);
+
+        // Keep the old connection briefly so frames already in flight arrive
+        ThreadPoolTimer::CreateTimer(
+            [old](ThreadPoolTimer const&) {
+                old->disconnect();
+                write_log(L"[MIGRATE] ", L"old connection closed");
+            },
+            std::chrono::seconds(MIGRATION_DRAIN_SEC));
+    }
+
+    // The new endpoint did not come up: fall back to break-then-connect
+    void abandonCandidate(WebSocketClient* source) {
+        std::shared_ptr<WebSocketClient> c;
+        std::wstring newUri;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            if (!candidate || candidate.get() != source) return;
+            c = candidate;
+            candidate = nullptr;
+            newUri = candidateUri;
+            registerStr = candidateRegister;
+        }
+        write_log(L"[MIGRATE] failed, reconnecting to ", newUri);
+        c->disconnect();
+        updateUri(newUri);
+    }
+
+    void dropCandidate() {
+        std::shared_ptr<WebSocketClient> c;
+        {
+            std::lock_guard<std::mutex> lk(clientMutex);
+            c = std::move(candidate);
+            candidate = nullptr;
+        }
+        if (c) c->disconnect();
+    }
+
     static int64_t now()
     {
         return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -323,45 +1165,51 @@ inline std::unique_ptr<WebSocketControl> m_control;
 // Global Named Pipe server for child process
 inline std::unique_ptr<NamedPipeServer> g_pipeServer;
 
+// Answers a request from the app over the same connection. Legacy
+// commands without an id get no reply.
+inline void replyToApp(const std::string& id, bool ok, const std::string& error = "") {
+    if (id.empty()) return;
+    AckMessage ackMsg;
+    ackMsg.id = id;
+    ackMsg.status = ok ? "OK" : "ERROR";
+    ackMsg.error = error;
+    
+    PipeMessage ackMessage(PROTOCOL_ACK, encodeIpcFor(ackMsg, g_parentChannel.PeerCodec()));
+    if (g_parentChannel.Send(ackMessage)) {
+        write_log(L"[DEBUG] ", (std::wstring(L"ACK: ") + utf8_to_wide(toJson(ackMsg))).c_str());
+    }
+    else {
+        write_log(L"[Service] ", L"ACK could not be sent");
+    }
+}
+
 // Message handler for Named Pipe
 inline void HandlePipeMessage(const PipeMessage& message) {
+    std::string id = requestIdOf(message.data);
     try {
         switch (message.command) {
         case PROTOCOL_SET_URL: {
-            write_log(L"[Service] receive SET_URL: ", utf8_to_wide(message.data).c_str());
+            write_log(L"[Service] receive SET_URL: ", utf8_to_wide(describeIpc(message.command, message.data)).c_str());
             
-            // Parse SET_URL message and update settings
-            auto settings = pluginSettingsFromJson(message.data);
+            // Settings travel in "opts"; a bare payload is the legacy base64 form
+            SetUrlMessage request;
+            PluginSetting settings = decodeIpc(message.data, request) && !request.opts.empty()
+                ? json::parse(request.opts).get<PluginSetting>()
+                : pluginSettingsFromJson(message.data.str());
             if (m_control) {
                 m_control->updateSettings(settings);
-                
-                // Send ACK response (matching diagram)
-                AckMessage ackMsg;
-                ackMsg.id = "m1"; // Same ID as SET_URL
-                ackMsg.status = "OK";
-                
-                std::string ackJson = toJson(ackMsg);
-                std::wstring pipeName = GetPipeName(utf8_to_wide(settings.title));
-                NamedPipeClient client(pipeName);
-                
-                if (client.Connect()) {
-                    PipeMessage ackMessage(PROTOCOL_ACK, ackJson);
-                    if (client.SendMessage(ackMessage)) {
-                        write_log(L"[Service] ", L"ACK sent to parent via Named Pipe");
-                        write_log(L"[DEBUG] ", (std::wstring(L"ACK JSON: ") + utf8_to_wide(ackJson)).c_str());
-                    }
-                    client.Disconnect();
-                }
+                replyToApp(id, true);
             }
             else {
                 write_log(L"[Service] control is null!", L"");
+                replyToApp(id, false, "service not running");
             }
             break;
         }
         case CMD_UPDATE_SETTINGS: {
-            write_log(L"[Service] receive settings: ", utf8_to_wide(message.data).c_str());
+            write_log(L"[Service] receive settings: ", utf8_to_wide(message.data.str()).c_str());
             
-            auto settings = pluginSettingsFromJson(message.data);
+            auto settings = pluginSettingsFromJson(message.data.str());
             if (m_control) {
                 m_control->updateSettings(settings);
             }
@@ -373,24 +1221,37 @@ inline void HandlePipeMessage(const PipeMessage& message) {
         case CMD_STOP_SERVICE: {
             write_log(L"[Service] Stop command received", L"");
             if (m_control) m_control->stop();
+            replyToApp(id, m_control != nullptr, m_control ? "" : "service not running");
             break;
         }
         case CMD_RECONNECT: {
             write_log(L"[Service] Reconnect command", L"");
             if (m_control) m_control->reconnect();
+            replyToApp(id, m_control != nullptr, m_control ? "" : "service not running");
+            break;
+        }
+        case PROTOCOL_HELLO_ACK: {
+            write_log(L"[Service] HELLO_ACK: ", utf8_to_wide(describeIpc(message.command, message.data)).c_str());
+            HelloAckMessage ack;
+            if (decodeIpc(message.data, ack)) {
+                g_parentChannel.SetPeerCodec((std::min)(ack.codec, IPC_CODEC_VERSION));
+            }
             break;
         }
         default:
             write_log(L"[Service] Unknown command", winrt::hstring(std::to_wstring(message.command)));
+            replyToApp(id, false, "unknown command");
             break;
         }
     }
     catch (const std::exception& ex) {
         write_error(ex, 166);
         write_log(L"[Service] receive error: ", winrt::hstring(utf8_to_wide(ex.what())));
+        replyToApp(id, false, ex.what());
     }
     catch (...) {
         write_error();
         write_log(L"[Service] receive error: ", L"unknown");
+        replyToApp(id, false, "unknown error");
     }
 }
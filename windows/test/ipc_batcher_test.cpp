@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc_batcher.h"
+#include "named_pipe_communication.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+// What the batcher wrote: one entry per pipe write
+struct Writes {
+  std::mutex mutex;
+  std::vector<PipeMessage> messages;
+  std::vector<int64_t> counts;
+  std::atomic<bool> fail{ false };
+
+  IpcBatcher::Sender sender = [this](const PipeMessage& message, int64_t count) {
+    std::lock_guard<std::mutex> lk(mutex);
+    messages.push_back(message);
+    counts.push_back(count);
+    return !fail.load();
+  };
+
+  size_t Size() {
+    std::lock_guard<std::mutex> lk(mutex);
+    return messages.size();
+  }
+};
+
+std::vector<std::string> Frames(const PipeMessage& batch) {
+  std::vector<std::string> out;
+  EXPECT_TRUE(ForEachBatchFrame(batch, [&out](PipeMessage& m) {
+    out.push_back(std::to_string(m.command) + ":" + m.data.str());
+  }));
+  return out;
+}
+
+}  // namespace
+
+TEST(BatchFrame, RoundTripsFramesInOrder) {
+  std::string batch;
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_SOCKET_EVENT, "first"));
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_ACK, ""));
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_SOCKET_EVENT, "third"));
+  EXPECT_EQ(Frames(PipeMessage(PROTOCOL_BATCH, batch)),
+            (std::vector<std::string>{ "1004:first", "1003:", "1004:third" }));
+}
+
+TEST(BatchFrame, CarriesTheConnectionToEachFrame) {
+  std::string batch;
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_SOCKET_EVENT, "a"));
+  PipeMessage message(PROTOCOL_BATCH, batch);
+  message.connection = 42;
+  ForEachBatchFrame(message, [](PipeMessage& m) { EXPECT_EQ(m.connection, 42u); });
+}
+
+TEST(BatchFrame, RejectsTruncatedFrame) {
+  std::string batch;
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_SOCKET_EVENT, "whole"));
+  AppendBatchFrame(batch, PipeMessage(PROTOCOL_SOCKET_EVENT, "cut short"));
+  batch.resize(batch.size() - 3);
+  int seen = 0;
+  EXPECT_FALSE(ForEachBatchFrame(PipeMessage(PROTOCOL_BATCH, batch), [&seen](PipeMessage&) { seen++; }));
+  EXPECT_EQ(seen, 1);
+}
+
+TEST(BatchFrame, RejectsNestedBatch) {
+  std::string inner;
+  AppendBatchFrame(inner, PipeMessage(PROTOCOL_SOCKET_EVENT, "a"));
+  std::string outer;
+  AppendBatchFrame(outer, PipeMessage(PROTOCOL_BATCH, inner));
+  EXPECT_FALSE(ForEachBatchFrame(PipeMessage(PROTOCOL_BATCH, outer), [](PipeMessage&) {}));
+}
+
+TEST(IpcBatcher, IsolatedMessageGoesOutAtOnceAsItself) {
+  Writes writes;
+  IpcBatcher batcher(writes.sender);
+  bool reported = false;
+  EXPECT_TRUE(batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "solo"), [&reported](bool ok) { reported = ok; }));
+  // Done ran on this thread, before Add returned
+  EXPECT_TRUE(reported);
+  ASSERT_EQ(writes.Size(), 1u);
+  EXPECT_EQ(writes.messages[0].command, static_cast<DWORD>(PROTOCOL_SOCKET_EVENT));
+  EXPECT_EQ(writes.messages[0].data.str(), "solo");
+  EXPECT_EQ(writes.counts[0], 1);
+  EXPECT_EQ(batcher.Immediate(), 1u);
+}
+
+TEST(IpcBatcher, MessagesWithinTheWindowShareAWrite) {
+  Writes writes;
+  IpcBatcher batcher(writes.sender);
+  batcher.Configure(1000 * 1000, 3, 0);
+  std::vector<bool> done(4, false);
+  for (int i = 0; i < 4; i++) {
+    batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, std::to_string(i)), [&done, i](bool ok) { done[i] = ok; });
+  }
+  // The first went alone; the next three filled the batch
+  ASSERT_EQ(writes.Size(), 2u);
+  EXPECT_EQ(writes.messages[1].command, static_cast<DWORD>(PROTOCOL_BATCH));
+  EXPECT_EQ(writes.counts[1], 3);
+  EXPECT_EQ(Frames(writes.messages[1]), (std::vector<std::string>{ "1004:1", "1004:2", "1004:3" }));
+  EXPECT_EQ(done, (std::vector<bool>{ true, true, true, true }));
+  EXPECT_EQ(batcher.Batched(), 4u);
+}
+
+TEST(IpcBatcher, WindowTimerWritesAPartialBatch) {
+  Writes writes;
+  IpcBatcher batcher(writes.sender);
+  batcher.Configure(20 * 1000, 0, 0);
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "a"));
+  std::atomic<int> late{ 0 };
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "b"), [&late](bool ok) { late += ok ? 1 : 100; });
+  EXPECT_EQ(writes.Size(), 1u);
+  for (int i = 0; i < 100 && late.load() == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(late.load(), 1);
+  ASSERT_EQ(writes.Size(), 2u);
+  // One message waiting is written as itself, not as a batch of one
+  EXPECT_EQ(writes.messages[1].data.str(), "b");
+}
+
+TEST(IpcBatcher, FailedWriteIsReportedToEveryMessage) {
+  Writes writes;
+  IpcBatcher batcher(writes.sender);
+  batcher.Configure(1000 * 1000, 2, 0);
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "ok"));
+  writes.fail = true;
+  int failed = 0;
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "x"), [&failed](bool ok) { failed += ok ? 0 : 1; });
+  EXPECT_FALSE(batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "y"), [&failed](bool ok) { failed += ok ? 0 : 1; }));
+  EXPECT_EQ(failed, 2);
+  EXPECT_EQ(batcher.Dropped(), 2u);
+}
+
+TEST(IpcBatcher, FlushWritesWhatIsWaiting) {
+  Writes writes;
+  IpcBatcher batcher(writes.sender);
+  batcher.Configure(1000 * 1000, 0, 0);
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "a"));
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "b"));
+  batcher.Add(PipeMessage(PROTOCOL_SOCKET_EVENT, "c"));
+  EXPECT_EQ(writes.Size(), 1u);
+  batcher.Flush();
+  ASSERT_EQ(writes.Size(), 2u);
+  EXPECT_EQ(writes.counts[1], 2);
+  batcher.Flush();
+  EXPECT_EQ(writes.Size(), 2u);
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
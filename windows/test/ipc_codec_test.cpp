@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "ipc_codec.h"
+#include "named_pipe_communication.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+TEST(IpcCodec, HelloRoundTrips) {
+  HelloMessage hello;
+  hello.pid = 4242;
+  hello.version = "2.1";
+  hello.codec = IPC_CODEC_VERSION;
+  std::string data = encodeIpcFor(hello, IPC_CODEC_VERSION);
+  EXPECT_TRUE(isBinaryIpc(data));
+
+  HelloMessage out;
+  ASSERT_TRUE(decodeIpc(data, out));
+  EXPECT_EQ(out.pid, 4242);
+  EXPECT_EQ(out.version, "2.1");
+  EXPECT_EQ(out.codec, IPC_CODEC_VERSION);
+}
+
+TEST(IpcCodec, HelloAckKeepsNegativeTime) {
+  HelloAckMessage ack;
+  ack.ok = false;
+  ack.server_time = -1234567890123;
+  ack.codec = IPC_CODEC_VERSION;
+  HelloAckMessage out;
+  ASSERT_TRUE(decodeIpc(encodeIpcFor(ack, IPC_CODEC_VERSION), out));
+  EXPECT_FALSE(out.ok);
+  EXPECT_EQ(out.server_time, -1234567890123);
+  EXPECT_EQ(out.codec, IPC_CODEC_VERSION);
+}
+
+TEST(IpcCodec, SetUrlRoundTrips) {
+  SetUrlMessage set;
+  set.id = "req-1";
+  set.url = "wss://example.test/ws";
+  set.opts = "{\"ping\":30}";
+  SetUrlMessage out;
+  ASSERT_TRUE(decodeIpc(encodeIpcFor(set, IPC_CODEC_VERSION), out));
+  EXPECT_EQ(out.id, "req-1");
+  EXPECT_EQ(out.url, "wss://example.test/ws");
+  EXPECT_EQ(out.opts, "{\"ping\":30}");
+}
+
+TEST(IpcCodec, AckStatusTravelsAsACode) {
+  AckMessage ack;
+  ack.id = "req-1";
+  ack.status = "OK";
+  AckMessage out;
+  ASSERT_TRUE(decodeIpc(encodeIpcFor(ack, IPC_CODEC_VERSION), out));
+  EXPECT_EQ(out.status, "OK");
+
+  ack.status = "TIMEOUT";
+  ack.error = "no answer";
+  ASSERT_TRUE(decodeIpc(encodeIpcFor(ack, IPC_CODEC_VERSION), out));
+  EXPECT_EQ(out.status, "ERROR");
+  EXPECT_EQ(out.error, "no answer");
+}
+
+TEST(IpcCodec, SocketEventCarriesAnyBytes) {
+  SocketEventMessage event;
+  event.event = "message";
+  // Long enough for a two-byte length, with a NUL inside
+  event.payload = std::string(300, 'p') + std::string(1, '\0') + "end";
+  event.id = "m-9";
+  event.info = "{\"seq\":7}";
+  SocketEventMessage out;
+  ASSERT_TRUE(decodeIpc(encodeIpcFor(event, IPC_CODEC_VERSION), out));
+  EXPECT_EQ(out.event, "message");
+  EXPECT_EQ(out.payload, event.payload);
+  EXPECT_EQ(out.id, "m-9");
+  EXPECT_EQ(out.info, "{\"seq\":7}");
+}
+
+TEST(IpcCodec, JsonForPeersWithoutTheCodec) {
+  SocketEventMessage event;
+  event.event = "message";
+  event.payload = "hi";
+  event.id = "m-1";
+  std::string data = encodeIpcFor(event, 0);
+  EXPECT_FALSE(isBinaryIpc(data));
+  ASSERT_EQ(data.front(), '{');
+
+  SocketEventMessage out;
+  ASSERT_TRUE(decodeIpc(data, out));
+  EXPECT_EQ(out.event, "message");
+  EXPECT_EQ(out.payload, "hi");
+  EXPECT_EQ(out.id, "m-1");
+}
+
+TEST(IpcCodec, OlderJsonHelloMeansJsonOnly) {
+  HelloMessage out;
+  out.codec = 5;
+  ASSERT_TRUE(decodeIpc("{\"type\":\"HELLO\",\"pid\":7,\"ver\":\"1.0\"}", out));
+  EXPECT_EQ(out.pid, 7);
+  EXPECT_EQ(out.codec, 0);
+}
+
+TEST(IpcCodec, OlderBinaryHelloWithoutCodecField) {
+  std::string data;
+  IpcWriter w(data, IpcKind::Hello);
+  w.varint(7);
+  w.str("1.0");
+  HelloMessage out;
+  out.codec = 5;
+  ASSERT_TRUE(decodeIpc(data, out));
+  EXPECT_EQ(out.pid, 7);
+  EXPECT_EQ(out.codec, 0);
+}
+
+TEST(IpcCodec, NewerVersionFieldsAreIgnored) {
+  AckMessage ack;
+  ack.id = "req-2";
+  ack.status = "OK";
+  std::string data = encodeIpcFor(ack, IPC_CODEC_VERSION);
+  // A later version bumps the header and appends fields
+  data[1] = static_cast<char>(IPC_CODEC_VERSION + 1);
+  std::string added;
+  IpcWriter w(added, IpcKind::Ack);
+  w.varint(99999);
+  w.str("added later");
+  data.append(added, sizeof(IpcHeader), std::string::npos);
+
+  AckMessage out;
+  ASSERT_TRUE(decodeIpc(data, out));
+  EXPECT_EQ(out.id, "req-2");
+  EXPECT_EQ(out.status, "OK");
+}
+
+TEST(IpcCodec, TruncatedPayloadFails) {
+  SetUrlMessage set;
+  set.id = "req-3";
+  set.url = "wss://example.test/ws";
+  std::string data = encodeIpcFor(set, IPC_CODEC_VERSION);
+  data.resize(data.size() - 4);
+  SetUrlMessage out;
+  EXPECT_FALSE(decodeIpc(data, out));
+}
+
+TEST(IpcCodec, OtherKindOrGarbageIsNotDecoded) {
+  PingMessage ping;
+  ping.t = 1;
+  std::string data = encodeIpcFor(ping, IPC_CODEC_VERSION);
+  EXPECT_EQ(ipcKindOf(data), static_cast<uint8_t>(IpcKind::Ping));
+  AckMessage ack;
+  EXPECT_FALSE(decodeIpc(data, ack));
+  EXPECT_FALSE(decodeIpc("not json", ack));
+}
+
+TEST(IpcCodec, DescribeShowsBinaryAsJson) {
+  AckMessage ack;
+  ack.id = "req-4";
+  ack.status = "OK";
+  EXPECT_EQ(describeIpc(PROTOCOL_ACK, encodeIpcFor(ack, IPC_CODEC_VERSION)), toJson(ack));
+  EXPECT_EQ(describeIpc(PROTOCOL_ACK, "{\"id\":\"x\"}"), "{\"id\":\"x\"}");
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "message_classifier.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+TEST(MessageClassifier, ClassifiesHeartbeatFrames) {
+  EXPECT_EQ(classifyFrame(L"{\"pong\":\"1\"}"), FrameKind::Pong);
+  EXPECT_EQ(classifyFrame(L"{ \"messageType\" : \"ping\" }"), FrameKind::Ping);
+  EXPECT_EQ(classifyFrame(L"{\"messageType\":\"pong\"}"), FrameKind::Pong);
+  EXPECT_EQ(classifyFrame(L"{\"Data\":{\"pong\":\"1\"}}"), FrameKind::Data);
+}
+
+TEST(MessageClassifier, ReadsEnvelopeFields) {
+  InboundMessage m = makeInboundMessage(
+      L"{\"Seq\": 42, \"Topic\":\"alerts/site1\", \"Priority\":\"high\", \"Data\":{\"ID\":\"x\"}}");
+  EXPECT_EQ(m.kind, FrameKind::Data);
+  ASSERT_TRUE(m.seq.has_value());
+  EXPECT_EQ(*m.seq, 42);
+  EXPECT_EQ(m.topic, L"alerts/site1");
+  EXPECT_EQ(m.priority, MessagePriority::High);
+}
+
+TEST(MessageClassifier, PriorityForms) {
+  EXPECT_EQ(scanPriority(L"{\"priority\":0}"), MessagePriority::High);
+  EXPECT_EQ(scanPriority(L"{\"Priority\":2}"), MessagePriority::Low);
+  EXPECT_EQ(scanPriority(L"{\"Priority\":\"low\"}"), MessagePriority::Low);
+  EXPECT_EQ(scanPriority(L"{\"Priority\":\"whatever\"}"), MessagePriority::Normal);
+  EXPECT_EQ(scanPriority(L"{}"), MessagePriority::Normal);
+}
+
+TEST(MessageClassifier, IgnoresKeysNestedInData) {
+  InboundMessage m = makeInboundMessage(
+      L"{\"Data\":{\"ID\":\"x\",\"Seq\":7,\"Topic\":\"private/other\",\"Priority\":\"low\"},"
+      L"\"Notification\":{\"Priority\":0}}");
+  EXPECT_FALSE(m.seq.has_value());
+  EXPECT_EQ(m.topic, L"");
+  EXPECT_EQ(m.priority, MessagePriority::Normal);
+}
+
+TEST(MessageClassifier, FindsEnvelopeKeyAfterNestedOnes) {
+  InboundMessage m = makeInboundMessage(
+      L"{\"Data\":{\"Seq\":7,\"list\":[{\"Topic\":\"a\"},\"Seq\"]},\"Seq\":8,\"Topic\":\"b\"}");
+  ASSERT_TRUE(m.seq.has_value());
+  EXPECT_EQ(*m.seq, 8);
+  EXPECT_EQ(m.topic, L"b");
+}
+
+TEST(MessageClassifier, IgnoresKeysInsideStringValues) {
+  InboundMessage m = makeInboundMessage(
+      L"{\"Body\":\"{\\\"Seq\\\":5, \\\"Topic\\\":\\\"x\\\"}\",\"Note\":\"Seq\"}");
+  EXPECT_FALSE(m.seq.has_value());
+  EXPECT_EQ(m.topic, L"");
+}
+
+TEST(MessageClassifier, ValueNamedLikeAKeyIsNotAKey) {
+  // "Seq" here is the value of Kind, not a name
+  InboundMessage m = makeInboundMessage(L"{\"Kind\":\"Seq\", \"Other\": 3}");
+  EXPECT_FALSE(m.seq.has_value());
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "message_dedup.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+// Every test starts without the filters a previous one persisted
+class MessageDedupTest : public ::testing::Test {
+ protected:
+  void SetUp() override { DeleteFileW(Path().c_str()); }
+  void TearDown() override { DeleteFileW(Path().c_str()); }
+
+  static std::wstring Path() { return get_current_path() + L"\\dedup.bin"; }
+};
+
+}  // namespace
+
+TEST_F(MessageDedupTest, SecondSightingIsDuplicate) {
+  MessageDedup dedup;
+  EXPECT_FALSE(dedup.CheckAndInsert("once"));
+  EXPECT_TRUE(dedup.CheckAndInsert("once"));
+}
+
+TEST_F(MessageDedupTest, FullGenerationRotatesEarlyAndGrows) {
+  MessageDedup dedup;
+  uint64_t capacity = dedup.Capacity();
+  EXPECT_EQ(capacity, static_cast<uint64_t>(DEDUP_MIN_CAPACITY));
+  // One more id than the generation holds: the last insert rotates
+  dedup.CheckAndInsert("first");
+  for (uint64_t i = 0; i < capacity; i++) {
+    dedup.CheckAndInsert("id-" + std::to_string(i));
+  }
+  // Filled within moments of a 24 h horizon: the next one is sized up
+  EXPECT_GT(dedup.Capacity(), capacity);
+  EXPECT_LE(dedup.Capacity(), static_cast<uint64_t>(DEDUP_MAX_CAPACITY));
+  EXPECT_EQ(dedup.Count(), 1u);
+  // Long out of the exact LRU set, still in the previous generation
+  EXPECT_TRUE(dedup.CheckAndInsert("first"));
+}
+
+TEST_F(MessageDedupTest, RotatesEveryHalfHorizon) {
+  MessageDedup dedup;
+  dedup.SetHorizon(1);
+  dedup.CheckAndInsert("a");
+  EXPECT_EQ(dedup.Count(), 1u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  EXPECT_FALSE(dedup.CheckAndInsert("b"));
+  // b opened a new generation; a is still known from the previous one
+  EXPECT_EQ(dedup.Count(), 1u);
+  EXPECT_TRUE(dedup.CheckAndInsert("a"));
+}
+
+TEST_F(MessageDedupTest, ForgetsAfterTheHorizon) {
+  MessageDedup dedup;
+  dedup.SetHorizon(1);
+  // Push "old" out of the exact LRU set so only the filters know it
+  dedup.CheckAndInsert("old");
+  for (int i = 0; i < DEDUP_LRU_CAPACITY; i++) {
+    dedup.CheckAndInsert("fill-" + std::to_string(i));
+  }
+  EXPECT_TRUE(dedup.CheckAndInsert("old"));
+  // Two rotations later neither generation holds it
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  dedup.CheckAndInsert("tick-1");
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  dedup.CheckAndInsert("tick-2");
+  EXPECT_FALSE(dedup.CheckAndInsert("old"));
+}
+
+TEST_F(MessageDedupTest, FlushedFiltersSurviveARestart) {
+  {
+    MessageDedup dedup;
+    dedup.CheckAndInsert("kept");
+    dedup.Flush();
+  }
+  // Not in the new instance's LRU set: only the loaded filters know it
+  MessageDedup dedup;
+  EXPECT_TRUE(dedup.CheckAndInsert("kept"));
+  EXPECT_FALSE(dedup.CheckAndInsert("new"));
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
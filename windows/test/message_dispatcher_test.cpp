@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "message_dispatcher.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+// One worker; the first item it takes holds it until Open(), so the test
+// can fill the lanes before anything else is served
+class Recorder {
+ public:
+  MessageDispatcher<std::string>::Handler handler = [this](DispatchItem<std::string>& item) {
+    if (item.value == "gate") gate.wait();
+    std::lock_guard<std::mutex> lk(mutex);
+    order.push_back(item.value);
+    cv.notify_all();
+  };
+
+  void Open() { opened.set_value(); }
+
+  std::vector<std::string> WaitFor(size_t count) {
+    std::unique_lock<std::mutex> lk(mutex);
+    cv.wait_for(lk, std::chrono::seconds(5), [&]() { return order.size() >= count; });
+    return order;
+  }
+
+ private:
+  std::promise<void> opened;
+  std::shared_future<void> gate = opened.get_future().share();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> order;
+};
+
+std::vector<LaneConfig> Lanes(size_t depth = 0) {
+  return { LaneConfig{ depth, 8 }, LaneConfig{ depth, 2 }, LaneConfig{ depth, 1 } };
+}
+
+}  // namespace
+
+TEST(MessageDispatcher, HighGoesAheadOfAnotherLanesTurn) {
+  Recorder r;
+  MessageDispatcher<std::string> d(1, r.handler, Lanes(), LaneScheduling::Weighted);
+  d.post(L"k", "gate", 1);
+  // The worker is inside the normal lane's turn, holding the gate
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  d.post(L"k", "n1", 1);
+  d.post(L"k", "n2", 1);
+  d.post(L"k", "high", 0);
+  r.Open();
+  EXPECT_EQ(r.WaitFor(4), (std::vector<std::string>{ "gate", "high", "n1", "n2" }));
+}
+
+TEST(MessageDispatcher, WeightedStillServesLowerLanes) {
+  Recorder r;
+  MessageDispatcher<std::string> d(1, r.handler, Lanes(), LaneScheduling::Weighted);
+  d.post(L"k", "gate", 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (int i = 0; i < 20; i++) d.post(L"k", "high", 0);
+  d.post(L"k", "low", 2);
+  r.Open();
+  std::vector<std::string> order = r.WaitFor(22);
+  ASSERT_EQ(order.size(), 22u);
+  // Lane 0 spends its weight of 8, then the low lane gets its turn
+  EXPECT_EQ(order[9], "low");
+}
+
+TEST(MessageDispatcher, StrictServesTheLowestLaneFirst) {
+  Recorder r;
+  MessageDispatcher<std::string> d(1, r.handler, Lanes(), LaneScheduling::Strict);
+  d.post(L"k", "gate", 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  d.post(L"k", "low", 2);
+  d.post(L"k", "normal", 1);
+  d.post(L"k", "high", 0);
+  r.Open();
+  EXPECT_EQ(r.WaitFor(4), (std::vector<std::string>{ "gate", "high", "normal", "low" }));
+}
+
+TEST(MessageDispatcher, OfferHandsBackWhatDoesNotFit) {
+  Recorder r;
+  MessageDispatcher<std::string> d(1, r.handler, Lanes(1), LaneScheduling::Weighted);
+  d.post(L"k", "gate", 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::string first = "first";
+  std::string second = "second";
+  EXPECT_TRUE(d.offer(L"k", first, 1));
+  EXPECT_FALSE(d.offer(L"k", second, 1));
+  // Left with the caller, not moved from
+  EXPECT_EQ(second, "second");
+  // A full lane does not hold back another one
+  std::string high = "high";
+  EXPECT_TRUE(d.offer(L"k", high, 0));
+  r.Open();
+  r.WaitFor(3);
+  DispatchStats s = d.stats();
+  EXPECT_EQ(s.lanes[1].spilled, 1u);
+  EXPECT_EQ(s.lanes[1].dropped, 0u);
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "reorder_buffer.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+// Records what the buffer releases, in order
+struct Sink {
+  std::vector<int> out;
+  std::vector<ReorderGap> gaps;
+  ReorderBuffer<int>::Release release = [this](int& v) { out.push_back(v); };
+
+  void Push(ReorderBuffer<int>& buffer, int64_t seq, int64_t baseline = 0) {
+    buffer.Push(L"s", seq, baseline, static_cast<int>(seq), release, gaps);
+  }
+};
+
+}  // namespace
+
+TEST(ReorderBuffer, ReleasesInOrderFramesAtOnce) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  for (int64_t seq = 1; seq <= 3; seq++) sink.Push(buffer, seq);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1, 2, 3 }));
+  EXPECT_FALSE(buffer.HasHeld());
+  EXPECT_EQ(buffer.stats().delayed, 0u);
+}
+
+TEST(ReorderBuffer, HoldsFramesUntilThePredecessorArrives) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  sink.Push(buffer, 1);
+  sink.Push(buffer, 3);
+  sink.Push(buffer, 4);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1 }));
+  EXPECT_TRUE(buffer.HasHeld());
+  sink.Push(buffer, 2);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1, 2, 3, 4 }));
+  EXPECT_FALSE(buffer.HasHeld());
+  EXPECT_EQ(buffer.stats().delayed, 2u);
+  EXPECT_TRUE(sink.gaps.empty());
+}
+
+TEST(ReorderBuffer, ReportsGapWhenTheWaitTimesOut) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  sink.Push(buffer, 10, 10);
+  sink.Push(buffer, 13);
+  sink.Push(buffer, 14);
+  buffer.Expire(sink.release, sink.gaps);
+  EXPECT_TRUE(sink.gaps.empty());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(REORDER_TIMEOUT_MS + 50));
+  buffer.Expire(sink.release, sink.gaps);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 10, 13, 14 }));
+  ASSERT_EQ(sink.gaps.size(), 1u);
+  EXPECT_EQ(sink.gaps[0].key, L"s");
+  EXPECT_EQ(sink.gaps[0].from, 11);
+  EXPECT_EQ(sink.gaps[0].to, 12);
+  EXPECT_EQ(buffer.stats().gaps, 1u);
+}
+
+TEST(ReorderBuffer, ReportsGapWhenTheBufferIsFull) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  sink.Push(buffer, 1);
+  // 2 never comes; one frame more than the buffer holds forces it out
+  for (int64_t seq = 3; seq <= REORDER_MAX_HELD + 3; seq++) sink.Push(buffer, seq);
+  ASSERT_EQ(sink.gaps.size(), 1u);
+  EXPECT_EQ(sink.gaps[0].from, 2);
+  EXPECT_EQ(sink.gaps[0].to, 2);
+  EXPECT_EQ(sink.out.size(), static_cast<size_t>(REORDER_MAX_HELD + 2));
+  EXPECT_EQ(sink.out.back(), REORDER_MAX_HELD + 3);
+}
+
+TEST(ReorderBuffer, LateFrameInAGapIsReleasedOnce) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  sink.Push(buffer, 1);
+  sink.Push(buffer, 5);
+  std::this_thread::sleep_for(std::chrono::milliseconds(REORDER_TIMEOUT_MS + 50));
+  buffer.Expire(sink.release, sink.gaps);
+  ASSERT_EQ(sink.gaps.size(), 1u);
+
+  // 3 splits the open gap 2..4; each slot is let through only once
+  sink.Push(buffer, 3);
+  sink.Push(buffer, 3);
+  sink.Push(buffer, 2);
+  sink.Push(buffer, 4);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1, 5, 3, 2, 4 }));
+  EXPECT_EQ(buffer.stats().duplicates, 1u);
+  sink.Push(buffer, 4);
+  EXPECT_EQ(buffer.stats().duplicates, 2u);
+}
+
+TEST(ReorderBuffer, DropsReplayOfReleasedFrames) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  for (int64_t seq = 1; seq <= 3; seq++) sink.Push(buffer, seq);
+  // Server resends after a reconnect
+  for (int64_t seq = 1; seq <= 3; seq++) sink.Push(buffer, seq);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1, 2, 3 }));
+  EXPECT_EQ(buffer.stats().duplicates, 3u);
+}
+
+TEST(ReorderBuffer, DropsDuplicateOfAHeldFrame) {
+  ReorderBuffer<int> buffer;
+  Sink sink;
+  sink.Push(buffer, 1);
+  sink.Push(buffer, 3);
+  sink.Push(buffer, 3);
+  EXPECT_EQ(buffer.stats().held, 1u);
+  EXPECT_EQ(buffer.stats().duplicates, 1u);
+  sink.Push(buffer, 2);
+  EXPECT_EQ(sink.out, (std::vector<int>{ 1, 2, 3 }));
+}
+
+TEST(ReorderBuffer, KeepsSendersApart) {
+  ReorderBuffer<int> buffer;
+  std::vector<int> out;
+  std::vector<ReorderGap> gaps;
+  ReorderBuffer<int>::Release release = [&out](int& v) { out.push_back(v); };
+  buffer.Push(L"a", 1, 0, 1, release, gaps);
+  buffer.Push(L"b", 7, 0, 7, release, gaps);
+  buffer.Push(L"a", 3, 0, 3, release, gaps);
+  buffer.Push(L"b", 8, 0, 8, release, gaps);
+  EXPECT_EQ(out, (std::vector<int>{ 1, 7, 8 }));
+  buffer.Push(L"a", 2, 0, 2, release, gaps);
+  EXPECT_EQ(out, (std::vector<int>{ 1, 7, 8, 2, 3 }));
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
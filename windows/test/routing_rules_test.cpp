@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "routing_rules.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+RouteRuleSetting Rule(const std::string& action) {
+  RouteRuleSetting rule;
+  rule.action = action;
+  return rule;
+}
+
+RouteFacts Facts(std::string_view type, std::string_view tag = "",
+                 MessagePriority priority = MessagePriority::Normal,
+                 std::wstring_view topic = L"") {
+  RouteFacts facts;
+  facts.type = type;
+  facts.tag = tag;
+  facts.priority = priority;
+  facts.topic = topic;
+  return facts;
+}
+
+}  // namespace
+
+TEST(RoutingRules, NoRulesDeliver) {
+  RoutingRules rules;
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Deliver);
+  rules.Compile({});
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, ParsesActions) {
+  EXPECT_EQ(routeActionFromString("toast"), RouteAction::Toast);
+  EXPECT_EQ(routeActionFromString("store"), RouteAction::StoreOnly);
+  EXPECT_EQ(routeActionFromString("drop"), RouteAction::Drop);
+  EXPECT_EQ(routeActionFromString("collapse"), RouteAction::Collapse);
+  EXPECT_EQ(routeActionFromString("deliver"), RouteAction::Deliver);
+  EXPECT_EQ(routeActionFromString("bogus"), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, EveryPresentFieldMustMatch) {
+  RouteRuleSetting rule = Rule("drop");
+  rule.type = "chat";
+  rule.tag = "muted";
+  RoutingRules rules;
+  rules.Compile({ rule });
+  EXPECT_EQ(rules.Evaluate(Facts("chat", "muted")), RouteAction::Drop);
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Deliver);
+  EXPECT_EQ(rules.Evaluate(Facts("call", "muted")), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, FirstMatchWins) {
+  RouteRuleSetting chat = Rule("toast");
+  chat.type = "chat";
+  RouteRuleSetting any = Rule("store");
+  RoutingRules rules;
+  rules.Compile({ chat, any });
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Toast);
+  // A rule without predicates matches everything
+  EXPECT_EQ(rules.Evaluate(Facts("call")), RouteAction::StoreOnly);
+}
+
+TEST(RoutingRules, SameValueInSeveralRulesSharesABit) {
+  RouteRuleSetting urgentChat = Rule("deliver");
+  urgentChat.type = "chat";
+  urgentChat.priority = "high";
+  RouteRuleSetting chat = Rule("store");
+  chat.type = "chat";
+  RoutingRules rules;
+  rules.Compile({ urgentChat, chat });
+  EXPECT_EQ(rules.Evaluate(Facts("chat", "", MessagePriority::High)), RouteAction::Deliver);
+  EXPECT_EQ(rules.Evaluate(Facts("chat", "", MessagePriority::Low)), RouteAction::StoreOnly);
+  EXPECT_EQ(rules.Evaluate(Facts("call", "", MessagePriority::High)), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, PriorityAliases) {
+  RouteRuleSetting low = Rule("drop");
+  low.priority = "2";
+  RouteRuleSetting urgent = Rule("toast");
+  urgent.priority = "urgent";
+  RoutingRules rules;
+  rules.Compile({ low, urgent });
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Low)), RouteAction::Drop);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::High)), RouteAction::Toast);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal)), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, ExactAndPrefixTopics) {
+  RouteRuleSetting exact = Rule("toast");
+  exact.topic = "alerts/site1";
+  RouteRuleSetting prefix = Rule("store");
+  prefix.topic = "alerts/#";
+  RoutingRules rules;
+  rules.Compile({ exact, prefix });
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"alerts/site1")), RouteAction::Toast);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"alerts/site2")), RouteAction::StoreOnly);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"news/site1")), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, TopicsUseTheSubscriptionGrammar) {
+  RouteRuleSetting door = Rule("toast");
+  door.topic = "alerts/+/door";
+  RouteRuleSetting alerts = Rule("store");
+  alerts.topic = "alerts/#";
+  RouteRuleSetting literal = Rule("drop");
+  literal.topic = "news#";
+  RoutingRules rules;
+  rules.Compile({ door, alerts, literal });
+  auto topic = [](std::wstring_view t) { return Facts("x", "", MessagePriority::Normal, t); };
+  EXPECT_EQ(rules.Evaluate(topic(L"alerts/site1/door")), RouteAction::Toast);
+  EXPECT_EQ(rules.Evaluate(topic(L"alerts/site1/door/front")), RouteAction::StoreOnly);
+  // '#' matches its parent level too
+  EXPECT_EQ(rules.Evaluate(topic(L"alerts")), RouteAction::StoreOnly);
+  EXPECT_EQ(rules.Evaluate(topic(L"alertsX/site1")), RouteAction::Deliver);
+  // '#' not alone in its level is no wildcard
+  EXPECT_EQ(rules.Evaluate(topic(L"newsroom/a")), RouteAction::Deliver);
+  EXPECT_EQ(rules.Evaluate(topic(L"news#")), RouteAction::Drop);
+}
+
+TEST(RoutingRules, MessageWithoutTopicMatchesNoTopicRule) {
+  RouteRuleSetting any = Rule("drop");
+  any.topic = "#";
+  RoutingRules rules;
+  rules.Compile({ any });
+  EXPECT_EQ(rules.Evaluate(Facts("x")), RouteAction::Deliver);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"a/b")), RouteAction::Drop);
+}
+
+TEST(RoutingRules, TopicPlaceholdersAreSubstituted) {
+  RouteRuleSetting mine = Rule("toast");
+  mine.topic = "users/{connectorId}/#";
+  RoutingRules rules;
+  rules.Compile({ mine }, "tag1", "user7");
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"users/user7/inbox")), RouteAction::Toast);
+  EXPECT_EQ(rules.Evaluate(Facts("x", "", MessagePriority::Normal, L"users/user8/inbox")), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, RuleBeyondThePredicateLimitIsIgnored) {
+  std::vector<RouteRuleSetting> settings;
+  for (int i = 0; i < ROUTE_MAX_PREDICATES; i++) {
+    RouteRuleSetting rule = Rule("store");
+    rule.type = "type-" + std::to_string(i);
+    settings.push_back(rule);
+  }
+  RouteRuleSetting extra = Rule("drop");
+  extra.type = "one-too-many";
+  settings.push_back(extra);
+  RoutingRules rules;
+  rules.Compile(settings);
+  EXPECT_EQ(rules.Evaluate(Facts("type-0")), RouteAction::StoreOnly);
+  EXPECT_EQ(rules.Evaluate(Facts("type-63")), RouteAction::StoreOnly);
+  EXPECT_EQ(rules.Evaluate(Facts("one-too-many")), RouteAction::Deliver);
+}
+
+TEST(RoutingRules, RecompileReplacesTheProgram) {
+  RouteRuleSetting chat = Rule("drop");
+  chat.type = "chat";
+  RoutingRules rules;
+  rules.Compile({ chat });
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Drop);
+  rules.Compile({});
+  EXPECT_EQ(rules.Evaluate(Facts("chat")), RouteAction::Deliver);
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <windows.h>
+
+#include <new>
+#include <string>
+
+#include "shared_ring.h"
+
+#define TEST_RING_CAPACITY 256
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+// A ring in ordinary memory; the two SpscRing views stand for the processes
+class SpscRingTest : public ::testing::Test {
+ protected:
+  SpscRingTest()
+      : control(new (memory) RingControl()), writer(control), reader(control) {
+    control->capacity = TEST_RING_CAPACITY;
+    control->head.store(0);
+    control->tail.store(0);
+    control->parked.store(0);
+  }
+
+  bool Write(const std::string& payload, DWORD command = PROTOCOL_SOCKET_EVENT) {
+    return writer.TryWrite(command, payload.data(), static_cast<uint32_t>(payload.size()));
+  }
+
+  // Reads and releases one record; empty if there is none
+  std::string Read() {
+    PipeMessage message;
+    if (!reader.TryRead(message)) return std::string();
+    reader.Release();
+    return message.data.str();
+  }
+
+  alignas(RingControl) uint8_t memory[sizeof(RingControl) + TEST_RING_CAPACITY];
+  RingControl* control;
+  SpscRing writer;
+  SpscRing reader;
+};
+
+}  // namespace
+
+TEST_F(SpscRingTest, EmptyRingHasNothingToRead) {
+  PipeMessage message;
+  EXPECT_FALSE(reader.TryRead(message));
+  EXPECT_TRUE(reader.Park());
+  reader.Unpark();
+}
+
+TEST_F(SpscRingTest, RoundTripsCommandAndPayload) {
+  ASSERT_TRUE(Write("hello", PROTOCOL_SOCKET_EVENT));
+  PipeMessage message;
+  ASSERT_TRUE(reader.TryRead(message));
+  EXPECT_EQ(message.command, static_cast<DWORD>(PROTOCOL_SOCKET_EVENT));
+  EXPECT_EQ(message.dataSize, 5u);
+  EXPECT_EQ(message.data.str(), "hello");
+}
+
+TEST_F(SpscRingTest, RecordIsConsumedOnlyOnRelease) {
+  ASSERT_TRUE(Write("a"));
+  uint64_t end = writer.Published();
+  PipeMessage message;
+  ASSERT_TRUE(reader.TryRead(message));
+  EXPECT_LT(writer.Consumed(), end);
+  reader.Release();
+  EXPECT_EQ(writer.Consumed(), end);
+}
+
+TEST_F(SpscRingTest, RefusesWhenFullAndTooLarge) {
+  std::string payload(40, 'x');
+  int written = 0;
+  while (Write(payload)) written++;
+  // 48-byte records in a 256-byte ring
+  EXPECT_EQ(written, 5);
+  EXPECT_EQ(Read(), payload);
+  EXPECT_TRUE(Write(payload));
+  // More than half the ring is never accepted
+  EXPECT_FALSE(Write(std::string(TEST_RING_CAPACITY / 2, 'y')));
+}
+
+TEST_F(SpscRingTest, WrapsAroundInOrder) {
+  std::string payload(40, 'x');
+  int read = 0;
+  for (int i = 0; i < 100; i++) {
+    payload[0] = static_cast<char>(i);
+    while (!Write(payload)) {
+      std::string got = Read();
+      ASSERT_FALSE(got.empty());
+      EXPECT_EQ(got[0], static_cast<char>(read));
+      read++;
+    }
+  }
+  for (std::string got = Read(); !got.empty(); got = Read()) {
+    EXPECT_EQ(got[0], static_cast<char>(read));
+    read++;
+  }
+  EXPECT_EQ(read, 100);
+  EXPECT_EQ(writer.Consumed(), writer.Published());
+  // 256 is no multiple of 48: the tail end of each lap went to a wrap marker
+  EXPECT_GT(writer.Published(), static_cast<uint64_t>(100 * 48));
+}
+
+TEST_F(SpscRingTest, DiscardDropsUnreadRecords) {
+  ASSERT_TRUE(Write("left"));
+  ASSERT_TRUE(Write("over"));
+  reader.Discard();
+  EXPECT_EQ(writer.Consumed(), writer.Published());
+  PipeMessage message;
+  EXPECT_FALSE(reader.TryRead(message));
+  ASSERT_TRUE(Write("fresh"));
+  EXPECT_EQ(Read(), "fresh");
+}
+
+TEST_F(SpscRingTest, ParkFailsWhileRecordsArePending) {
+  ASSERT_TRUE(Write("a"));
+  EXPECT_FALSE(reader.Park());
+  EXPECT_FALSE(writer.ReaderParked());
+  EXPECT_EQ(Read(), "a");
+  EXPECT_TRUE(reader.Park());
+  EXPECT_TRUE(writer.ReaderParked());
+  reader.Unpark();
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
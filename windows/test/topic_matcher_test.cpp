@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "topic_matcher.h"
+
+namespace local_push_connectivity {
+namespace test {
+
+namespace {
+
+TopicMatcher Compiled(const std::vector<std::string>& patterns) {
+  TopicMatcher matcher;
+  matcher.Compile(patterns, "tag1", "user7");
+  return matcher;
+}
+
+}  // namespace
+
+TEST(TopicMatcher, NoSubscriptionsPassEverything) {
+  TopicMatcher matcher = Compiled({});
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1"));
+  EXPECT_TRUE(matcher.Matches(L""));
+}
+
+TEST(TopicMatcher, MessageWithoutTopicPasses) {
+  TopicMatcher matcher = Compiled({ "alerts/site1" });
+  EXPECT_TRUE(matcher.Matches(L""));
+}
+
+TEST(TopicMatcher, ExactPattern) {
+  TopicMatcher matcher = Compiled({ "alerts/site1" });
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/site2"));
+  EXPECT_FALSE(matcher.Matches(L"alerts"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/site1/door"));
+}
+
+TEST(TopicMatcher, PlusMatchesExactlyOneLevel) {
+  TopicMatcher matcher = Compiled({ "alerts/+/door" });
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1/door"));
+  EXPECT_TRUE(matcher.Matches(L"alerts//door"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/door"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/a/b/door"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/site1/window"));
+}
+
+TEST(TopicMatcher, HashMatchesTheRestIncludingNone) {
+  TopicMatcher matcher = Compiled({ "alerts/#" });
+  EXPECT_TRUE(matcher.Matches(L"alerts"));
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1"));
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1/door/front"));
+  EXPECT_FALSE(matcher.Matches(L"news/site1"));
+}
+
+TEST(TopicMatcher, HashAloneMatchesAnyTopic) {
+  TopicMatcher matcher = Compiled({ "#" });
+  EXPECT_TRUE(matcher.Matches(L"a"));
+  EXPECT_TRUE(matcher.Matches(L"a/b/c"));
+}
+
+TEST(TopicMatcher, PlusAndHashTogether) {
+  TopicMatcher matcher = Compiled({ "+/site1/#" });
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1"));
+  EXPECT_TRUE(matcher.Matches(L"news/site1/a/b"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/site2/a"));
+}
+
+TEST(TopicMatcher, ExactAndWildcardEdgesAreBothFollowed) {
+  TopicMatcher matcher = Compiled({ "alerts/site1/window", "alerts/+/door" });
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1/window"));
+  EXPECT_TRUE(matcher.Matches(L"alerts/site1/door"));
+  EXPECT_FALSE(matcher.Matches(L"alerts/site2/window"));
+}
+
+TEST(TopicMatcher, SubstitutesConnectorPlaceholders) {
+  TopicMatcher matcher = Compiled({ "users/{connectorId}/#", "groups/{connectorTag}" });
+  EXPECT_TRUE(matcher.Matches(L"users/user7/inbox"));
+  EXPECT_TRUE(matcher.Matches(L"groups/tag1"));
+  EXPECT_FALSE(matcher.Matches(L"users/user8/inbox"));
+  EXPECT_FALSE(matcher.Matches(L"groups/{connectorTag}"));
+}
+
+TEST(TopicMatcher, RecompileReplacesPatterns) {
+  TopicMatcher matcher;
+  matcher.Compile({ "a/b" }, "", "");
+  EXPECT_FALSE(matcher.Matches(L"c/d"));
+  matcher.Compile({ "c/+" }, "", "");
+  EXPECT_TRUE(matcher.Matches(L"c/d"));
+  EXPECT_FALSE(matcher.Matches(L"a/b"));
+}
+
+}  // namespace test
+}  // namespace local_push_connectivity
@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils.h"
+
+// Subscription patterns over '/'-separated topics, MQTT style:
+//   "alerts/site1"   exact
+//   "alerts/+/door"  '+' matches exactly one level
+//   "alerts/#"       '#' (last level only) matches the rest, including none
+// "{connectorTag}" and "{connectorId}" are substituted when compiling.
+// Compiled into a trie of levels; matching walks the topic once, following
+// the exact and '+' edges of every live node. The live sets are per-thread
+// scratch, so a match allocates nothing once they have grown.
+class TopicMatcher {
+public:
+    void Compile(const std::vector<std::string>& patterns, const std::string& connectorTag, const std::string& connectorId) {
+        auto trie = std::make_shared<Trie>();
+        for (auto p : patterns) {
+            replaceAll(p, "{connectorTag}", connectorTag);
+            replaceAll(p, "{connectorId}", connectorId);
+            if (!p.empty()) trie->insert(utf8_to_wide(p));
+        }
+        if (trie->patterns == 0) trie = nullptr;
+        std::atomic_store(&compiled, std::shared_ptr<const Trie>(trie));
+    }
+
+    // No subscriptions, or a message without a topic: everything passes
+    bool Matches(std::wstring_view topic) const {
+        auto trie = std::atomic_load(&compiled);
+        if (!trie || topic.empty()) return true;
+        return trie->match(topic);
+    }
+
+private:
+    struct Node {
+        std::map<std::wstring, uint32_t, std::less<>> children;
+        int32_t plus = -1;
+        bool terminal = false;
+        bool rest = false; // '#' child
+    };
+
+    struct Trie {
+        std::vector<Node> nodes{ Node{} };
+        size_t patterns = 0;
+
+        void insert(const std::wstring& pattern) {
+            uint32_t n = 0;
+            size_t start = 0;
+            while (true) {
+                size_t end = pattern.find(L'/', start);
+                std::wstring_view level(pattern.data() + start, (end == std::wstring::npos ? pattern.size() : end) - start);
+                if (level == L"#") {
+                    nodes[n].rest = true;
+                    patterns++;
+                    return;
+                }
+                n = child(n, level);
+                if (end == std::wstring::npos) break;
+                start = end + 1;
+            }
+            nodes[n].terminal = true;
+            patterns++;
+        }
+
+        uint32_t child(uint32_t n, std::wstring_view level) {
+            if (level == L"+") {
+                if (nodes[n].plus < 0) {
+                    nodes[n].plus = static_cast<int32_t>(nodes.size());
+                    nodes.emplace_back();
+                }
+                return static_cast<uint32_t>(nodes[n].plus);
+            }
+            auto it = nodes[n].children.find(level);
+            if (it != nodes[n].children.end()) return it->second;
+            uint32_t id = static_cast<uint32_t>(nodes.size());
+            nodes[n].children.emplace(std::wstring(level), id);
+            nodes.emplace_back();
+            return id;
+        }
+
+        bool match(std::wstring_view topic) const {
+            thread_local std::vector<uint32_t> live, next;
+            live.clear();
+            live.push_back(0);
+            size_t start = 0;
+            while (true) {
+                size_t end = topic.find(L'/', start);
+                std::wstring_view level = topic.substr(start, end == std::wstring_view::npos ? std::wstring_view::npos : end - start);
+                next.clear();
+                for (uint32_t n : live) {
+                    const Node& node = nodes[n];
+                    if (node.rest) return true;
+                    auto it = node.children.find(level);
+                    if (it != node.children.end()) next.push_back(it->second);
+                    if (node.plus >= 0) next.push_back(static_cast<uint32_t>(node.plus));
+                }
+                if (next.empty()) return false;
+                live.swap(next);
+                if (end == std::wstring_view::npos) break;
+                start = end + 1;
+            }
+            for (uint32_t n : live) {
+                if (nodes[n].terminal || nodes[n].rest) return true;
+            }
+            return false;
+        }
+    };
+
+    std::shared_ptr<const Trie> compiled;
+
+    static void replaceAll(std::string& s, const std::string& from, const std::string& to) {
+        size_t pos = 0;
+        while ((pos = s.find(from, pos)) != std::string::npos) {
+            s.replace(pos, from.size(), to);
+            pos += to.size();
+        }
+    }
+};